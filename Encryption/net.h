@@ -777,7 +777,7 @@ void tcp_set_blocking(Socket* socket, bool blocking) {
         return;
     }
     
-    blocking ? (flags |= O_NONBLOCK) : (flags &= (~O_NONBLOCK));
+    blocking ? (flags &= (~O_NONBLOCK)) : (flags |= O_NONBLOCK);
     int res = fcntl(socket->handle, F_SETFL, flags);
     if (res == -1) socket->error = SocketError_FailedToSetBlocking;
     #endif
@@ -4,13 +4,14 @@ in vec3 fragmentPosition;
 in vec4 fragmentColor;
 in vec2 texCoords;
 flat in uint texIndex;
+flat in uint texLayer;
 
 out vec4 FragColor;
 
-layout (binding = 0) uniform sampler2D uTextures[32];
+layout (binding = 0) uniform sampler2DArray uTextures[32];
 
 void main() {
-    //vec4 color = texture(uTextures[texIndex], texCoords);
+    //vec4 color = texture(uTextures[texIndex], vec3(texCoords, texLayer));
     vec4 color = vec4(texCoords.x, texCoords.y, 0.0, 1.0);
     /*vec4 color;
     if (texIndex == 0) {
@@ -4,11 +4,13 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec4 aColor;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in uint aTexIndex;
+layout (location = 4) in uint aTexLayer;
 
 out vec4 fragmentColor;
 out vec3 fragmentPosition;
 out vec2 texCoords;
 flat out uint texIndex;
+flat out uint texLayer;
 
 uniform mat4 projectionMatrix;
 
@@ -18,4 +20,5 @@ void main() {
    fragmentColor = aColor;
    texCoords = aTexCoords;
    texIndex = aTexIndex;
+   texLayer = aTexLayer;
 }
\ No newline at end of file
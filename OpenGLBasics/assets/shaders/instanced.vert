@@ -0,0 +1,32 @@
+#version 430 core
+
+// the unit quad
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoords;
+// per instance
+layout (location = 2) in vec2 aColumn0;
+layout (location = 3) in vec2 aColumn1;
+layout (location = 4) in vec2 aTranslation;
+layout (location = 5) in vec4 aColor;
+// left, bottom, right, top
+layout (location = 6) in vec4 aTexRect;
+layout (location = 7) in uint aTexIndex;
+layout (location = 8) in uint aTexLayer;
+
+out vec4 fragmentColor;
+out vec3 fragmentPosition;
+out vec2 texCoords;
+flat out uint texIndex;
+flat out uint texLayer;
+
+uniform mat4 projectionMatrix;
+
+void main() {
+   vec2 position = aColumn0 * aPos.x + aColumn1 * aPos.y + aTranslation;
+   gl_Position = projectionMatrix * vec4(position, 0.0, 1.0);
+   fragmentPosition = vec3(position, 0.0);
+   fragmentColor = aColor;
+   texCoords = mix(aTexRect.xy, aTexRect.zw, aTexCoords);
+   texIndex = aTexIndex;
+   texLayer = aTexLayer;
+}
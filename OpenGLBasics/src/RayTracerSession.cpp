@@ -0,0 +1,91 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "RayTracerSession.hpp"
+#include "Integrator.hpp"
+#include "Options.hpp"
+#include "ProgressiveRender.hpp"
+#include "RenderSetup.hpp"
+#include "Scene.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+struct RayTracerSession::State {
+    State(const Scene& scene, const Options& options, const RenderSettings& settings, const unsigned int numThreads)
+        : world{ scene.buildWorld(BvhSettings{ .type{ options.bvhType } }) },
+          settings{ settings },
+          kernel{ selectRenderKernel(settings, world) },
+          render{ world, settings, kernel.renderTile, numThreads, tileSize } { }
+
+    static constexpr int tileSize = 32;
+    World world;
+    RenderSettings settings;
+    RenderKernel kernel;
+    // last member, the render threads use all of the above
+    ProgressiveRender render;
+};
+
+RayTracerSession::RayTracerSession(std::unique_ptr<State> state) noexcept : mState{ std::move(state) } { }
+
+RayTracerSession::RayTracerSession(RayTracerSession&&) noexcept = default;
+
+RayTracerSession::~RayTracerSession() = default;
+
+RayTracerSession& RayTracerSession::operator=(RayTracerSession&&) noexcept = default;
+
+tl::expected<RayTracerSession, std::string> RayTracerSession::Create(int argc, const char* const* argv) noexcept {
+    // the ray tracer reports the details of invalid options itself
+    const auto options = CommandLine::parse(argc, argv);
+    if (!options) {
+        return tl::unexpected{ std::string{ "Invalid ray tracer options" } };
+    }
+    const auto imageWidth = options->imageWidth;
+    const auto imageHeight = RenderSetup::imageHeight(*options);
+    const auto settings = RenderSetup::createRenderSettings(*options, Tile::wholeImage(imageWidth, imageHeight));
+    // the same scene as the one of the command line ray tracer, which also reports why it cannot be created
+    const auto scene = RenderSetup::createScene(*options);
+    if (!scene) {
+        return tl::unexpected{ std::string{ "Unable to create the scene" } };
+    }
+
+    // one of eight hardware threads is left to the viewer, so that the display stays responsive
+    const auto hardwareThreads = std::thread::hardware_concurrency();
+    const auto numThreads = options->numThreads > 0
+                                    ? options->numThreads
+                                    : std::max(1U, (hardwareThreads == 0 ? 4 : hardwareThreads * 7 / 8));
+    auto state = std::make_unique<State>(*scene, *options, settings, numThreads);
+    spdlog::info("Rendering {}x{} pixels with {} samples per pixel on {} threads ({})", imageWidth, imageHeight,
+                 settings.samplesPerPixel, numThreads, state->kernel.description);
+    return RayTracerSession{ std::move(state) };
+}
+
+int RayTracerSession::getWidth() const noexcept {
+    return mState->render.width();
+}
+
+int RayTracerSession::getHeight() const noexcept {
+    return mState->render.height();
+}
+
+std::uint32_t RayTracerSession::getSamplesPerPixel() const noexcept {
+    return mState->settings.samplesPerPixel;
+}
+
+std::uint32_t RayTracerSession::getCompletedSamples() const noexcept {
+    return mState->render.completedSamples();
+}
+
+bool RayTracerSession::isFinished() const noexcept {
+    return mState->render.isFinished();
+}
+
+void RayTracerSession::stop() noexcept {
+    mState->render.stop();
+}
+
+std::size_t RayTracerSession::uploadChangedTiles(const UploadTile& upload) noexcept {
+    return mState->render.uploadChangedTiles(upload);
+}
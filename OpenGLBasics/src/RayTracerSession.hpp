@@ -0,0 +1,50 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "expected/expected.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+// Progressive render of the ray tracer demo scene (see ../RayTracingInOneWeekend) that runs on its own threads from
+// the moment it is created. The ray tracer headers are only included by RayTracerSession.cpp, since they declare
+// classes whose names clash with the ones of this project (e.g. Texture).
+class RayTracerSession final {
+public:
+    // receives a rectangle of the image as 8 bit RGBA, the position is relative to the bottom left corner and the rows
+    // go from the bottom to the top
+    using UploadTile =
+            std::function<void(int x, int y, int width, int height, std::span<const std::uint8_t> rgba)>;
+
+    RayTracerSession(RayTracerSession&&) noexcept;
+    ~RayTracerSession();
+    RayTracerSession& operator=(RayTracerSession&&) noexcept;
+
+    // takes the command line options of the ray tracer (--width, --samples, --camera, --threads, --bvh, ...)
+    [[nodiscard]] static tl::expected<RayTracerSession, std::string> Create(int argc, const char* const* argv) noexcept;
+
+    [[nodiscard]] int getWidth() const noexcept;
+    [[nodiscard]] int getHeight() const noexcept;
+    [[nodiscard]] std::uint32_t getSamplesPerPixel() const noexcept;
+    // samples per pixel that every pixel has reached
+    [[nodiscard]] std::uint32_t getCompletedSamples() const noexcept;
+    [[nodiscard]] bool isFinished() const noexcept;
+    // stops the render threads after their current tiles, the image keeps all finished tiles
+    void stop() noexcept;
+    // calls upload for every tile that changed since the last call and returns their number
+    std::size_t uploadChangedTiles(const UploadTile& upload) noexcept;
+
+private:
+    struct State;
+
+    explicit RayTracerSession(std::unique_ptr<State> state) noexcept;
+
+private:
+    std::unique_ptr<State> mState;
+};
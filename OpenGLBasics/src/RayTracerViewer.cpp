@@ -0,0 +1,94 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "RayTracerViewer.hpp"
+#include "hash/hash.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+
+RayTracerViewer::RayTracerViewer(RayTracerSession session,
+                                 const std::string& title,
+                                 WindowSize size,
+                                 OpenGLVersion version) noexcept
+    : Application{ title, size, version },
+      mSession{ std::move(session) } { }
+
+void RayTracerViewer::setup() noexcept {
+    auto expectedShaderProgram =
+            ShaderProgram::generateFromFiles(std::filesystem::current_path() / "assets" / "shaders" / "default.vert",
+                                             std::filesystem::current_path() / "assets" / "shaders" / "default.frag");
+    if (!expectedShaderProgram) {
+        spdlog::error("Failed to generate shader program from files: {}", expectedShaderProgram.error());
+        glfwSetWindowShouldClose(getGLFWWindowPointer(), true);
+        return;
+    }
+    mShaderProgram = std::move(expectedShaderProgram.value());
+
+    auto expectedTexture = Texture::CreateEmpty(mSession.getWidth(), mSession.getHeight());
+    if (!expectedTexture) {
+        spdlog::error("Failed to create the texture of the ray traced image: {}", expectedTexture.error());
+        glfwSetWindowShouldClose(getGLFWWindowPointer(), true);
+        return;
+    }
+    mTexture = std::move(expectedTexture.value());
+    glClearColor(73.f / 255.f, 54.f / 255.f, 87.f / 255.f, 1.f);
+}
+
+void RayTracerViewer::update() noexcept {
+    processInput();
+    if (!mShaderProgram || !mTexture) {
+        return;
+    }
+    uploadChangedTiles();
+    render();
+}
+
+void RayTracerViewer::processInput() noexcept {
+    if (glfwGetKey(getGLFWWindowPointer(), GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        glfwSetWindowShouldClose(getGLFWWindowPointer(), true);
+    }
+    if (glfwGetKey(getGLFWWindowPointer(), GLFW_KEY_SPACE) == GLFW_PRESS && !mStopped && !mSession.isFinished()) {
+        // blocks until the threads have finished their current tiles
+        mSession.stop();
+        mStopped = true;
+        spdlog::info("Render stopped at {} samples per pixel", mSession.getCompletedSamples());
+    }
+}
+
+void RayTracerViewer::uploadChangedTiles() noexcept {
+    // checked before uploading, so that the last tiles of a finished render are never missed
+    const auto finished = mSession.isFinished();
+    mSession.uploadChangedTiles([this](int x, int y, int width, int height, std::span<const std::uint8_t> rgba) {
+        mTexture->setSubImage(x, y, width, height, rgba);
+    });
+    const auto completedSamples = mSession.getCompletedSamples();
+    if (completedSamples != mLastCompletedSamples) {
+        spdlog::info("{} of {} samples per pixel", completedSamples, mSession.getSamplesPerPixel());
+        mLastCompletedSamples = completedSamples;
+    }
+    if (finished && !mFinishedLogged) {
+        spdlog::info("Render finished");
+        mFinishedLogged = true;
+    }
+}
+
+void RayTracerViewer::render() noexcept {
+    const auto framebufferSize = getFramebufferSize();
+    const auto projectionMatrix = glm::ortho<float>(
+            gsl::narrow_cast<float>(-framebufferSize.width / 2), gsl::narrow_cast<float>(framebufferSize.width / 2),
+            gsl::narrow_cast<float>(-framebufferSize.height / 2), gsl::narrow_cast<float>(framebufferSize.height / 2));
+    mShaderProgram->setUniform(Hash::staticHashString("projectionMatrix"), projectionMatrix);
+
+    // the largest centered quad with the aspect ratio of the image, the unit quad of the renderer spans [-1, 1]
+    const auto imageWidth = gsl::narrow_cast<float>(mSession.getWidth());
+    const auto imageHeight = gsl::narrow_cast<float>(mSession.getHeight());
+    const auto scale = std::min(gsl::narrow_cast<float>(framebufferSize.width) / imageWidth,
+                                gsl::narrow_cast<float>(framebufferSize.height) / imageHeight);
+    const auto halfSize = glm::vec3{ scale * imageWidth / 2.0f, scale * imageHeight / 2.0f, 1.0f };
+    mRenderer.beginFrame();
+    mRenderer.drawQuad(glm::vec3{ 0.0f }, 0.0f, halfSize, *mShaderProgram, *mTexture);
+    mRenderer.endFrame();
+}
@@ -0,0 +1,44 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Application.hpp"
+#include "RayTracerSession.hpp"
+#include "ShaderProgram.hpp"
+#include "Texture.hpp"
+#include "Renderer.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Shows the image of a ray tracer session while it converges. Only the tiles that changed since the last frame are
+// uploaded to the texture, the render threads never wait for the display. Space stops the render, Escape closes the
+// window.
+class RayTracerViewer final : public Application<RayTracerViewer> {
+public:
+    RayTracerViewer(RayTracerSession session,
+                    const std::string& title,
+                    WindowSize size,
+                    OpenGLVersion version) noexcept;
+
+private:
+    void setup() noexcept;
+    void update() noexcept;
+
+    void processInput() noexcept;
+    void uploadChangedTiles() noexcept;
+    void render() noexcept;
+
+private:
+    RayTracerSession mSession;
+    std::optional<ShaderProgram> mShaderProgram;
+    std::optional<Texture> mTexture;
+    Renderer mRenderer;
+    std::uint32_t mLastCompletedSamples{ 0U };
+    bool mStopped{ false };
+    bool mFinishedLogged{ false };
+
+    friend class Application;
+};
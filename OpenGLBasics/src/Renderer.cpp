@@ -8,21 +8,59 @@
 #include <spdlog/spdlog.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
 
-Renderer::Renderer() {
+Renderer::Renderer(QuadRendering quadRendering) : mQuadRendering{ quadRendering } {
+    // the buffers are swapped after sorting, the capacity of both decides when the command buffer is flushed
     mCommandBuffer.reserve(maxCommandsPerBatch);
-    mVertexData.reserve(maxCommandsPerBatch * 4ULL);
-    mIndexData.reserve(maxCommandsPerBatch * 6ULL);
+    mSortedCommandBuffer.reserve(maxCommandsPerBatch);
+    mSortEntries.reserve(maxCommandsPerBatch);
+    mSortScratch.reserve(maxCommandsPerBatch);
+    mTextureSlots.reserve(maxCommandsPerBatch);
     mCurrentTextureNames.reserve(std::min(Texture::getTextureUnitCount(), 32));
     spdlog::info("GPU is capable of binding {} textures at a time.", mCurrentTextureNames.capacity());
-    mVertexBuffer.setVertexAttributeLayout(
-            VertexAttributeDefinition{ 3, GL_FLOAT, false }, VertexAttributeDefinition{ 4, GL_FLOAT, false },
-            VertexAttributeDefinition{ 2, GL_FLOAT, false }, VertexAttributeDefinition{ 1, GL_UNSIGNED_INT, false });
+    if (mQuadRendering == QuadRendering::Instanced) {
+        const std::vector<QuadVertexData> quadVertices{
+            QuadVertexData{ .position = { -1.0f, -1.0f }, .texCoords = { 0.0f, 0.0f } },
+            QuadVertexData{ .position = { 1.0f, -1.0f }, .texCoords = { 1.0f, 0.0f } },
+            QuadVertexData{ .position = { 1.0f, 1.0f }, .texCoords = { 1.0f, 1.0f } },
+            QuadVertexData{ .position = { -1.0f, 1.0f }, .texCoords = { 0.0f, 1.0f } },
+        };
+        const std::vector<IndexData> quadIndices{
+            IndexData{ .i0 = 0, .i1 = 1, .i2 = 2 },
+            IndexData{ .i0 = 0, .i1 = 2, .i2 = 3 },
+        };
+        mVertexBuffer.submitVertexData(quadVertices, GLDataUsagePattern::StaticDraw);
+        mVertexBuffer.submitIndexData(quadIndices, GLDataUsagePattern::StaticDraw);
+        mVertexBuffer.setVertexAttributeLayout(VertexAttributeDefinition{ 2, GL_FLOAT, false },
+                                               VertexAttributeDefinition{ 2, GL_FLOAT, false });
+        mVertexBuffer.allocateInstanceRingBuffer<InstanceData>(maxCommandsPerBatch);
+        mVertexBuffer.setInstanceAttributeLayout(
+                VertexAttributeDefinition{ 2, GL_FLOAT, false }, VertexAttributeDefinition{ 2, GL_FLOAT, false },
+                VertexAttributeDefinition{ 2, GL_FLOAT, false }, VertexAttributeDefinition{ 4, GL_FLOAT, false },
+                VertexAttributeDefinition{ 4, GL_FLOAT, false }, VertexAttributeDefinition{ 1, GL_UNSIGNED_INT, false },
+                VertexAttributeDefinition{ 1, GL_UNSIGNED_INT, false });
+    } else {
+        // the indices of a batch only depend on the number of its quads, so all batches share the same ones
+        std::vector<IndexData> quadIndices;
+        quadIndices.reserve(maxCommandsPerBatch * 2ULL);
+        for (std::size_t i = 0; i < maxCommandsPerBatch; ++i) {
+            const auto indexOffset = gsl::narrow_cast<GLuint>(i * 4U);
+            quadIndices.push_back(IndexData{ .i0 = indexOffset + 0, .i1 = indexOffset + 1, .i2 = indexOffset + 2 });
+            quadIndices.push_back(IndexData{ .i0 = indexOffset + 0, .i1 = indexOffset + 2, .i2 = indexOffset + 3 });
+        }
+        mVertexBuffer.submitIndexData(quadIndices, GLDataUsagePattern::StaticDraw);
+        mVertexBuffer.allocateVertexRingBuffer<VertexData>(maxCommandsPerBatch * 4ULL);
+        mVertexBuffer.setVertexAttributeLayout(
+                VertexAttributeDefinition{ 3, GL_FLOAT, false }, VertexAttributeDefinition{ 4, GL_FLOAT, false },
+                VertexAttributeDefinition{ 2, GL_FLOAT, false }, VertexAttributeDefinition{ 1, GL_UNSIGNED_INT, false },
+                VertexAttributeDefinition{ 1, GL_UNSIGNED_INT, false });
+    }
 }
 
 void Renderer::beginFrame() noexcept {
-    mVertexData.clear();
-    mIndexData.clear();
     mRenderStats = RenderStats{};
 }
 
@@ -47,7 +85,91 @@ void Renderer::drawQuad(T&& transform, const ShaderProgram& shader, const Textur
     if (mCommandBuffer.size() == mCommandBuffer.capacity()) {
         flushCommandBuffer();
     }
-    mCommandBuffer.emplace_back(transform, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f }, shader.mName, texture.mName);
+    mCommandBuffer.emplace_back(transform, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f }, texture.mUVRect, shader.mName,
+                                texture.getArrayName(), gsl::narrow_cast<GLuint>(texture.mLayer));
+}
+
+std::uint64_t Renderer::makeSortKey(std::uint8_t layer,
+                                    bool translucent,
+                                    float depth,
+                                    GLuint shaderName,
+                                    GLuint textureName) noexcept {
+    // From the most to the least significant bits: layer (8), translucency (1), then shader (15), texture (24) and
+    // depth (16) for opaque quads, but depth, shader and texture for translucent ones, since those have to be drawn
+    // from back to front. Names that exceed their bits only make the batching less efficient, the commands are still
+    // drawn correctly.
+    constexpr auto shaderBits = 15;
+    constexpr auto textureBits = 24;
+    constexpr auto depthBits = 16;
+    // There is no depth test, so quads are drawn from back to front, which is ascending z for the default orthographic
+    // projection. Flipping the bits makes the order of the unsigned integers match the order of the floats.
+    const auto depthBitPattern = std::bit_cast<std::uint32_t>(depth);
+    constexpr auto signBit = 0x8000'0000U;
+    const auto orderedDepth = (depthBitPattern & signBit) != 0U ? ~depthBitPattern : depthBitPattern | signBit;
+    const auto depthKey = std::uint64_t{ orderedDepth >> (32 - depthBits) };
+    const auto shaderKey = std::uint64_t{ shaderName } & ((std::uint64_t{ 1 } << shaderBits) - 1U);
+    const auto textureKey = std::uint64_t{ textureName } & ((std::uint64_t{ 1 } << textureBits) - 1U);
+    auto result = std::uint64_t{ layer } << 56U;
+    if (translucent) {
+        result |= std::uint64_t{ 1 } << 55U;
+        result |= depthKey << (shaderBits + textureBits) | shaderKey << textureBits | textureKey;
+    } else {
+        result |= shaderKey << (textureBits + depthBits) | textureKey << depthBits | depthKey;
+    }
+    return result;
+}
+
+std::uint64_t Renderer::sortKey(const RenderCommand& renderCommand) noexcept {
+    // there are neither layers nor blending yet
+    return makeSortKey(0U, false, renderCommand.transform[3].z, renderCommand.shaderName, renderCommand.textureName);
+}
+
+// least significant digit first, stable
+void Renderer::radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) noexcept {
+    constexpr std::size_t numDigits = sizeof(std::uint64_t);
+    constexpr std::size_t radix = 256;
+    if (entries.size() < 2) {
+        return;
+    }
+    // the histograms of all digits in a single pass
+    std::array<std::array<std::uint32_t, radix>, numDigits> counts{};
+    for (const auto& entry : entries) {
+        for (std::size_t digit = 0; digit < numDigits; ++digit) {
+            ++counts[digit][(entry.key >> (8U * digit)) & 0xFFU];
+        }
+    }
+    scratch.resize(entries.size());
+    for (std::size_t digit = 0; digit < numDigits; ++digit) {
+        auto& digitCounts = counts[digit];
+        const auto shift = 8U * digit;
+        // skips the digits that all keys share, e.g. the unused layers
+        if (digitCounts[(entries.front().key >> shift) & 0xFFU] == entries.size()) {
+            continue;
+        }
+        std::uint32_t offset = 0U;
+        for (auto& count : digitCounts) {
+            offset += std::exchange(count, offset);
+        }
+        for (const auto& entry : entries) {
+            scratch[digitCounts[(entry.key >> shift) & 0xFFU]++] = entry;
+        }
+        std::swap(entries, scratch);
+    }
+}
+
+void Renderer::sortCommandBuffer() noexcept {
+    // only the small (key, index) pairs are moved while sorting, every command is copied once afterwards
+    mSortEntries.clear();
+    for (std::size_t i = 0; i < mCommandBuffer.size(); ++i) {
+        mSortEntries.push_back(
+                SortEntry{ .key = sortKey(mCommandBuffer[i]), .commandIndex = gsl::narrow_cast<std::uint32_t>(i) });
+    }
+    radixSort(mSortEntries, mSortScratch);
+    mSortedCommandBuffer.clear();
+    for (const auto& entry : mSortEntries) {
+        mSortedCommandBuffer.push_back(mCommandBuffer[entry.commandIndex]);
+    }
+    std::swap(mCommandBuffer, mSortedCommandBuffer);
 }
 
 void Renderer::flushCommandBuffer() noexcept {
@@ -58,100 +180,163 @@ void Renderer::flushCommandBuffer() noexcept {
         return;
     }
 
-    std::sort(mCommandBuffer.begin(), mCommandBuffer.end(), [](const RenderCommand& lhs, const RenderCommand& rhs) {
-        // TODO: sort differently for transparent shaders
-        return (lhs.shaderName < rhs.shaderName) ||
-               (lhs.shaderName == rhs.shaderName && lhs.textureName < rhs.textureName);
-    });
+    sortCommandBuffer();
+    // the commands of a shader are contiguous unless layers or translucency separate them
+    const auto nextShaderIt = [this](const auto startIt) {
+        return std::find_if(startIt, mCommandBuffer.end(), [startIt](const RenderCommand& renderCommand) {
+            return renderCommand.shaderName != startIt->shaderName;
+        });
+    };
     auto currentStartIt = mCommandBuffer.begin();
-    auto currentEndIt = std::upper_bound(
-            mCommandBuffer.begin(), mCommandBuffer.end(), mCommandBuffer.front(),
-            [](const RenderCommand& lhs, const RenderCommand& rhs) { return lhs.shaderName < rhs.shaderName; });
+    auto currentEndIt = nextShaderIt(currentStartIt);
 
     while (currentStartIt != mCommandBuffer.end()) {// one iteration per shader
-        mVertexData.clear();
-        mIndexData.clear();
-        mCurrentTextureNames.clear();
         ShaderProgram::bind(currentStartIt->shaderName);
         /*spdlog::warn("converting command range {} - {} (shader {})",
                      std::distance(mCommandBuffer.begin(), currentStartIt),
                      std::distance(mCommandBuffer.begin(), currentEndIt) - 1, currentStartIt->shaderName);*/
-        std::for_each(currentStartIt, currentEndIt, [&](const RenderCommand& renderCommand) {
-            addVertexAndIndexDataFromRenderCommand(renderCommand);
-        });
+        auto remainingCommands = std::span{ currentStartIt, currentEndIt };
+        while (!remainingCommands.empty()) {// one iteration per batch
+            const auto maxBatchSize = assignTextureSlots(remainingCommands);
+            // the sections have room for maxCommandsPerBatch quads, if a section is smaller anyway, the batch is
+            // split and the rest goes into the next one
+            const auto batchSize = std::min(maxBatchSize, acquireBatchSections());
+            if (batchSize == 0U) {
+                if (!mReportedDroppedQuads) {
+                    spdlog::error("The ring buffer storage is not mapped, quads are not drawn");
+                    mReportedDroppedQuads = true;
+                }
+                mRenderStats.numDroppedQuads += remainingCommands.size();
+                break;
+            }
+            writeBatch(remainingCommands.first(batchSize));
+            flushVertexAndIndexData();
+            remainingCommands = remainingCommands.subspan(batchSize);
+        }
         currentStartIt = currentEndIt;
         if (currentEndIt != mCommandBuffer.end()) {// there's at least one more shader to draw with
-            currentEndIt = std::upper_bound(
-                    currentEndIt, mCommandBuffer.end(), *currentEndIt,
-                    [](const RenderCommand& lhs, const RenderCommand& rhs) { return lhs.shaderName < rhs.shaderName; });
+            currentEndIt = nextShaderIt(currentEndIt);
         }
-        flushVertexAndIndexData();
     }
     mCommandBuffer.clear();
 }
 
 void Renderer::flushVertexAndIndexData() noexcept {
-    if (mVertexData.empty()) {
+    if (mNumTrianglesInCurrentBatch == 0ULL && mNumInstancesInCurrentBatch == 0U) {
         return;
     }
-    // flush all buffers
-    mVertexBuffer.submitVertexData(mVertexData, GLDataUsagePattern::DynamicDraw);
-    mVertexBuffer.submitIndexData(mIndexData, GLDataUsagePattern::DynamicDraw);
-    mVertexBuffer.bind();
     for (std::size_t i = 0; i < mCurrentTextureNames.size(); ++i) {
         Texture::bind(mCurrentTextureNames[i], gsl::narrow_cast<GLint>(i));
     }
-    //spdlog::warn("drawing {} quads", mVertexBuffer.indicesCount() / 6);
-    glDrawElements(GL_TRIANGLES, gsl::narrow_cast<GLsizei>(mVertexBuffer.indicesCount()), GL_UNSIGNED_INT, nullptr);
-    mVertexData.clear();
-    mIndexData.clear();
-    mCurrentTextureNames.clear();
+    // the data has been written into the mapped sections already
+    if (mQuadRendering == QuadRendering::Instanced) {
+        mVertexBuffer.drawInstancedSection(mNumInstancesInCurrentBatch);
+    } else {
+        mVertexBuffer.drawVertexSection(mNumTrianglesInCurrentBatch * 3ULL);
+    }
+    mVertexSection = {};
+    mInstanceSection = {};
     mNumTrianglesInCurrentBatch = 0ULL;
+    mNumInstancesInCurrentBatch = 0U;
     mRenderStats.numBatches += 1ULL;
 }
-void Renderer::addVertexAndIndexDataFromRenderCommand(const Renderer::RenderCommand& renderCommand) {
-    // TODO: use an indirection vector to optimize this as soon as there is a global asset manager
-    int textureIndex = -1;
-    for (std::size_t i = 0; i < mCurrentTextureNames.size(); ++i) {
-        if (mCurrentTextureNames[i] == renderCommand.textureName) {
-            textureIndex = gsl::narrow_cast<int>(i);
-            break;
+
+// Cheap serial pass before the quads of a batch are written in parallel: gives each of the leading commands its
+// texture slot and returns how many of them fit into one batch.
+std::size_t Renderer::assignTextureSlots(std::span<const RenderCommand> renderCommands) noexcept {
+    for (const auto textureName : mCurrentTextureNames) {
+        mTextureSlotsByName[textureName] = 0U;
+    }
+    mCurrentTextureNames.clear();
+    mTextureSlots.clear();
+    const auto maxBatchSize = std::min(renderCommands.size(), maxCommandsPerBatch);
+    for (std::size_t i = 0; i < maxBatchSize; ++i) {
+        const auto textureName = renderCommands[i].textureName;
+        if (textureName >= mTextureSlotsByName.size()) {
+            mTextureSlotsByName.resize(textureName + std::size_t{ 1 }, 0U);
         }
+        auto& slot = mTextureSlotsByName[textureName];
+        if (slot == 0U) {
+            if (mCurrentTextureNames.size() == mCurrentTextureNames.capacity()) {
+                return i;
+            }
+            mCurrentTextureNames.push_back(textureName);
+            slot = gsl::narrow_cast<GLuint>(mCurrentTextureNames.size());
+        }
+        mTextureSlots.push_back(slot - 1U);
     }
+    return maxBatchSize;
+}
+
+// returns how many quads fit into the sections, zero if the storage is not mapped
+std::size_t Renderer::acquireBatchSections() noexcept {
+    if (mQuadRendering == QuadRendering::Instanced) {
+        mInstanceSection = mVertexBuffer.acquireInstanceSection<InstanceData>();
+        return mInstanceSection.size();
+    }
+    mVertexSection = mVertexBuffer.acquireVertexSection<VertexData>();
+    return mVertexSection.size() / 4U;
+}
+
+// Every quad has its own slice of the mapped sections, so the workers never write to the same memory.
+void Renderer::writeBatch(std::span<const RenderCommand> renderCommands) noexcept {
+    if (mQuadRendering == QuadRendering::Instanced) {
+        mWorkerPool.parallelFor(renderCommands.size(), minQuadsPerWorker, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                addInstanceDataFromRenderCommand(renderCommands[i], mTextureSlots[i], i);
+            }
+        });
+        mNumInstancesInCurrentBatch = renderCommands.size();
+    } else {
+        mWorkerPool.parallelFor(renderCommands.size(), minQuadsPerWorker, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                addVertexDataFromRenderCommand(renderCommands[i], mTextureSlots[i], i);
+            }
+        });
+        mNumTrianglesInCurrentBatch = renderCommands.size() * 2ULL;
+    }
+    mRenderStats.numVertices += renderCommands.size() * 4ULL;
+    mRenderStats.numTriangles += renderCommands.size() * 2ULL;
+}
+
+void Renderer::addVertexDataFromRenderCommand(const Renderer::RenderCommand& renderCommand,
+                                              GLuint textureIndex,
+                                              std::size_t quadIndex) const noexcept {
+    // written in order, the mapped memory may be write-combined
+    auto* const vertices = mVertexSection.data() + quadIndex * 4U;
+    const auto& texRect = renderCommand.texRect;
+    vertices[0] = VertexData{ .position = { renderCommand.transform * glm::vec4{ -1.0f, -1.0f, 0.0f, 1.0f } },
+                              .color = { 1.0f, 1.0f, 1.0f, 1.0f },
+                              .texCoords = { texRect.x, texRect.y },
+                              .texIndex = textureIndex,
+                              .texLayer = renderCommand.textureLayer };
+    vertices[1] = VertexData{ .position = { renderCommand.transform * glm::vec4{ 1.0f, -1.0f, 0.0f, 1.0f } },
+                              .color = { 1.0f, 1.0f, 1.0f, 1.0f },
+                              .texCoords = { texRect.z, texRect.y },
+                              .texIndex = textureIndex,
+                              .texLayer = renderCommand.textureLayer };
+    vertices[2] = VertexData{ .position = { renderCommand.transform * glm::vec4{ 1.0f, 1.0f, 0.0f, 1.0f } },
+                              .color = { 1.0f, 1.0f, 1.0f, 1.0f },
+                              .texCoords = { texRect.z, texRect.w },
+                              .texIndex = textureIndex,
+                              .texLayer = renderCommand.textureLayer };
+    vertices[3] = VertexData{ .position = { renderCommand.transform * glm::vec4{ -1.0f, 1.0f, 0.0f, 1.0f } },
+                              .color = { 1.0f, 1.0f, 1.0f, 1.0f },
+                              .texCoords = { texRect.x, texRect.w },
+                              .texIndex = textureIndex,
+                              .texLayer = renderCommand.textureLayer };
+}
 
-    if ((textureIndex < 0 && mCurrentTextureNames.size() == mCurrentTextureNames.capacity()) ||
-        (mNumTrianglesInCurrentBatch + 2ULL > mVertexData.capacity())) {
-        flushVertexAndIndexData();
-    }
-    if (textureIndex < 0) {
-        textureIndex = static_cast<int>(mCurrentTextureNames.size());
-        mCurrentTextureNames.push_back(renderCommand.textureName);
-    }
-
-    const auto indexOffset = mVertexData.size();
-    mVertexData.push_back(VertexData{ .position = { renderCommand.transform * glm::vec4{ -1.0f, -1.0f, 0.0f, 1.0f } },
-                                      .color = { 1.0f, 1.0f, 1.0f, 1.0f },
-                                      .texCoords = { 0.0f, 0.0f },
-                                      .texIndex = gsl::narrow_cast<GLuint>(textureIndex) });
-    mVertexData.push_back(VertexData{ .position = { renderCommand.transform * glm::vec4{ 1.0f, -1.0f, 0.0f, 1.0f } },
-                                      .color = { 1.0f, 1.0f, 1.0f, 1.0f },
-                                      .texCoords = { 1.0f, 0.0f },
-                                      .texIndex = gsl::narrow_cast<GLuint>(textureIndex) });
-    mVertexData.push_back(VertexData{ .position = { renderCommand.transform * glm::vec4{ 1.0f, 1.0f, 0.0f, 1.0f } },
-                                      .color = { 1.0f, 1.0f, 1.0f, 1.0f },
-                                      .texCoords = { 1.0f, 1.0f },
-                                      .texIndex = gsl::narrow_cast<GLuint>(textureIndex) });
-    mVertexData.push_back(VertexData{ .position = { renderCommand.transform * glm::vec4{ -1.0f, 1.0f, 0.0f, 1.0f } },
-                                      .color = { 1.0f, 1.0f, 1.0f, 1.0f },
-                                      .texCoords = { 0.0f, 1.0f },
-                                      .texIndex = gsl::narrow_cast<GLuint>(textureIndex) });
-    mIndexData.push_back(IndexData{ .i0 = gsl::narrow_cast<GLuint>(indexOffset + 0),
-                                    .i1 = gsl::narrow_cast<GLuint>(indexOffset + 1),
-                                    .i2 = gsl::narrow_cast<GLuint>(indexOffset + 2) });
-    mIndexData.push_back(IndexData{ .i0 = gsl::narrow_cast<GLuint>(indexOffset + 0),
-                                    .i1 = gsl::narrow_cast<GLuint>(indexOffset + 2),
-                                    .i2 = gsl::narrow_cast<GLuint>(indexOffset + 3) });
-    mNumTrianglesInCurrentBatch += 2ULL;
-    mRenderStats.numVertices += 4ULL;
-    mRenderStats.numTriangles += 2ULL;
+void Renderer::addInstanceDataFromRenderCommand(const Renderer::RenderCommand& renderCommand,
+                                                GLuint textureIndex,
+                                                std::size_t quadIndex) const noexcept {
+    // the vertex shader only uses x and y of the transformed unit quad
+    const auto& transform = renderCommand.transform;
+    mInstanceSection[quadIndex] = InstanceData{ .column0 = { transform[0].x, transform[0].y },
+                                                .column1 = { transform[1].x, transform[1].y },
+                                                .translation = { transform[3].x, transform[3].y },
+                                                .color = renderCommand.color,
+                                                .texRect = renderCommand.texRect,
+                                                .texIndex = textureIndex,
+                                                .texLayer = renderCommand.textureLayer };
 }
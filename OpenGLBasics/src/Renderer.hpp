@@ -7,28 +7,41 @@
 #include "VertexBuffer.hpp"
 #include "ShaderProgram.hpp"
 #include "Texture.hpp"
+#include "WorkerPool.hpp"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
 #include <cstdint>
+#include <span>
 
 struct RenderStats {
     std::uint64_t numBatches{ 0ULL };
     std::uint64_t numTriangles{ 0ULL };
     std::uint64_t numVertices{ 0ULL };
+    // quads that were not drawn because the storage of the ring buffer could not be mapped
+    std::uint64_t numDroppedQuads{ 0ULL };
 };
 
 class Renderer final {
 public:
+    // Vertices: four transformed vertices per quad are written into the ring buffer, the indices are generated once.
+    // Instanced: one unit quad is drawn per instance, the per-instance data holds the 2D transform, the color and the
+    // texture index of a quad. Requires a vertex shader with per-instance attributes, see instanced.vert.
+    enum class QuadRendering {
+        Vertices,
+        Instanced,
+    };
+
     struct VertexData {
         glm::vec3 position;
         glm::vec4 color;
         glm::vec2 texCoords;
         GLuint texIndex;
+        GLuint texLayer;
     };
     static_assert(alignof(VertexData) == 4);
     static_assert(sizeof(VertexData[2]) == 2 * sizeof(VertexData));
-    static_assert(sizeof(VertexData) == 10 * sizeof(GLfloat));
+    static_assert(sizeof(VertexData) == 11 * sizeof(GLfloat));
 
     struct IndexData {
         GLuint i0, i1, i2;
@@ -37,8 +50,29 @@ public:
     static_assert(sizeof(IndexData) == 3 * sizeof(GLuint));
     static_assert(sizeof(IndexData[2]) == 2 * sizeof(IndexData));
 
+    // vertex of the unit quad that all instances share
+    struct QuadVertexData {
+        glm::vec2 position;
+        glm::vec2 texCoords;
+    };
+    static_assert(sizeof(QuadVertexData) == 4 * sizeof(GLfloat));
+
+    // the x and y columns and the translation of the 2D part of a quad's transform
+    struct InstanceData {
+        glm::vec2 column0;
+        glm::vec2 column1;
+        glm::vec2 translation;
+        glm::vec4 color;
+        // left, bottom, right and top texture coordinates of the texture within its layer
+        glm::vec4 texRect;
+        GLuint texIndex;
+        GLuint texLayer;
+    };
+    static_assert(alignof(InstanceData) == 4);
+    static_assert(sizeof(InstanceData) == 16 * sizeof(GLfloat));
+
 public:
-    Renderer();
+    explicit Renderer(QuadRendering quadRendering = QuadRendering::Vertices);
 
     void beginFrame() noexcept;
     void endFrame() noexcept;
@@ -57,23 +91,64 @@ private:
     struct RenderCommand {
         glm::mat4 transform;
         glm::vec4 color;
+        glm::vec4 texRect;
         GLuint shaderName;
+        // the name of the texture array
         GLuint textureName;
+        GLuint textureLayer;
+    };
+
+    // sorting the entries by their keys in ascending order gives the draw order of the render commands
+    struct SortEntry {
+        std::uint64_t key;
+        std::uint32_t commandIndex;
     };
 
 private:
+    [[nodiscard]] static std::uint64_t makeSortKey(std::uint8_t layer,
+                                                   bool translucent,
+                                                   float depth,
+                                                   GLuint shaderName,
+                                                   GLuint textureName) noexcept;
+    [[nodiscard]] static std::uint64_t sortKey(const RenderCommand& renderCommand) noexcept;
+    static void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) noexcept;
+    void sortCommandBuffer() noexcept;
     void flushCommandBuffer() noexcept;
     void flushVertexAndIndexData() noexcept;
-    void addVertexAndIndexDataFromRenderCommand(const RenderCommand& renderCommand);
+    [[nodiscard]] std::size_t assignTextureSlots(std::span<const RenderCommand> renderCommands) noexcept;
+    [[nodiscard]] std::size_t acquireBatchSections() noexcept;
+    void writeBatch(std::span<const RenderCommand> renderCommands) noexcept;
+    void addVertexDataFromRenderCommand(const RenderCommand& renderCommand,
+                                        GLuint textureIndex,
+                                        std::size_t quadIndex) const noexcept;
+    void addInstanceDataFromRenderCommand(const RenderCommand& renderCommand,
+                                          GLuint textureIndex,
+                                          std::size_t quadIndex) const noexcept;
 
 private:
     static constexpr std::size_t maxCommandsPerBatch = 10'000;
+    // below this, handing the quads to another thread costs more than converting them
+    static constexpr std::size_t minQuadsPerWorker = 1'024;
+    QuadRendering mQuadRendering;
     std::uint64_t mNumTrianglesInCurrentBatch = 0ULL;
+    std::size_t mNumInstancesInCurrentBatch = 0U;
     std::vector<RenderCommand> mCommandBuffer;
-    std::vector<VertexData> mVertexData;
-    std::vector<IndexData> mIndexData;
+    // only used while sorting the command buffer
+    std::vector<SortEntry> mSortEntries;
+    std::vector<SortEntry> mSortScratch;
+    std::vector<RenderCommand> mSortedCommandBuffer;
+    // the texture slot of every command of the current batch
+    std::vector<GLuint> mTextureSlots;
+    WorkerPool mWorkerPool;
     VertexBuffer mVertexBuffer;
+    // the mapped ring buffer sections of the current batch, empty until the batch has been assigned its commands
+    std::span<VertexData> mVertexSection;
+    std::span<InstanceData> mInstanceSection;
     RenderStats mRenderStats;
+    // dropped quads are only logged once, RenderStats counts them in every frame
+    bool mReportedDroppedQuads{ false };
     std::vector<GLuint> mCurrentTextureNames;
+    // indexed by texture name, the slot of the texture in the current batch plus one, or zero if it has none
+    std::vector<GLuint> mTextureSlotsByName;
     GLuint mCurrentShaderProgramName{ 0U };
 };
@@ -0,0 +1,76 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "RingBuffer.hpp"
+#include <gsl/gsl_util>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+RingBuffer::RingBuffer(GLuint bufferName, std::size_t sectionSize, std::size_t numSections) noexcept
+    : mSectionSize{ sectionSize },
+      mFences(numSections, nullptr) {
+    // coherent, so that the writes of the CPU become visible to the GPU without explicit flushes
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const auto size = gsl::narrow_cast<GLsizeiptr>(sectionSize * numSections);
+    glNamedBufferStorage(bufferName, size, nullptr, flags);
+    mData = static_cast<std::byte*>(glMapNamedBufferRange(bufferName, 0, size, flags));
+    if (mData == nullptr) {
+        spdlog::error("Could not map the storage of buffer {} persistently", bufferName);
+    }
+}
+
+RingBuffer::RingBuffer(RingBuffer&& other) noexcept {
+    using std::swap;
+    swap(mData, other.mData);
+    swap(mSectionSize, other.mSectionSize);
+    swap(mCurrentSection, other.mCurrentSection);
+    swap(mFences, other.mFences);
+}
+
+RingBuffer::~RingBuffer() {
+    // the mapping itself ends when the owner deletes the buffer object
+    for (const auto fence : mFences) {
+        glDeleteSync(fence);
+    }
+}
+
+RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept {
+    using std::swap;
+    swap(mData, other.mData);
+    swap(mSectionSize, other.mSectionSize);
+    swap(mCurrentSection, other.mCurrentSection);
+    swap(mFences, other.mFences);
+    return *this;
+}
+
+std::span<std::byte> RingBuffer::acquireSection() noexcept {
+    if (mData == nullptr) {
+        return {};
+    }
+    auto& fence = mFences[mCurrentSection];
+    if (fence != nullptr) {
+        constexpr GLuint64 timeoutNanoseconds = 1'000'000'000ULL;
+        auto waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNanoseconds);
+        while (waitResult == GL_TIMEOUT_EXPIRED) {
+            spdlog::warn("Still waiting for the GPU to release a ring buffer section");
+            waitResult = glClientWaitSync(fence, 0, timeoutNanoseconds);
+        }
+        if (waitResult == GL_WAIT_FAILED) {
+            spdlog::error("Waiting for the GPU to release a ring buffer section failed");
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return std::span{ mData + getSectionOffset(), mSectionSize };
+}
+
+void RingBuffer::releaseSection() noexcept {
+    if (mData == nullptr) {
+        return;
+    }
+    auto& fence = mFences[mCurrentSection];
+    glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mCurrentSection = (mCurrentSection + 1) % mFences.size();
+}
@@ -0,0 +1,47 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Immutable storage of a buffer object that stays mapped for the lifetime of the buffer, so the CPU writes its data
+// directly into memory the GPU reads from. The storage is split into sections that are used in turn, one per batch.
+// A fence per section keeps the CPU from overwriting a section while the GPU may still read from it, with three
+// sections the CPU can fill one while the GPU works on the other two. Requires OpenGL 4.5 for the direct state
+// access functions.
+class RingBuffer final {
+public:
+    static constexpr std::size_t defaultNumSections = 3;
+
+    RingBuffer() = default;
+    // the buffer object is not owned by the ring buffer and must not have immutable storage yet
+    RingBuffer(GLuint bufferName, std::size_t sectionSize, std::size_t numSections) noexcept;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer(RingBuffer&& other) noexcept;
+    ~RingBuffer();
+
+    RingBuffer& operator=(const RingBuffer&) = delete;
+    RingBuffer& operator=(RingBuffer&& other) noexcept;
+
+    // waits until the GPU has finished reading the current section and returns its memory (empty if the storage
+    // could not be mapped)
+    [[nodiscard]] std::span<std::byte> acquireSection() noexcept;
+    // fences the commands issued so far, which are the last ones reading the current section, and makes the next
+    // section the current one
+    void releaseSection() noexcept;
+    // byte offset of the current section within the buffer
+    [[nodiscard]] std::size_t getSectionOffset() const noexcept {
+        return mCurrentSection * mSectionSize;
+    }
+
+private:
+    std::byte* mData{ nullptr };
+    std::size_t mSectionSize{ 0U };
+    std::size_t mCurrentSection{ 0U };
+    std::vector<GLsync> mFences;
+};
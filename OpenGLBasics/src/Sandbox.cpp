@@ -19,7 +19,9 @@ void Sandbox::setup() noexcept {
 #endif
     for (const auto& directoryEntry :
          std::filesystem::directory_iterator(std::filesystem::current_path() / "assets" / "images")) {
-        auto expectedTexture = Image::LoadFromFile(directoryEntry).and_then(Texture::Create);
+        auto expectedTexture = Image::LoadFromFile(directoryEntry).and_then([this](const Image& image) {
+            return mTextureManager.add(image);
+        });
         if (expectedTexture) {
             mTextures.push_back(std::move(expectedTexture.value()));
             spdlog::info("Loaded texture: {}", directoryEntry.path().string());
@@ -83,12 +85,13 @@ void Sandbox::render() noexcept {
     }
     mRenderer.endFrame();
     const RenderStats& stats = mRenderer.stats();
-    //spdlog::info("Stats: {} tris, {} vertices ({} batches)", stats.numTriangles, stats.numVertices, stats.numBatches);
+    //spdlog::info("Stats: {} tris, {} vertices ({} batches, {} dropped quads)", stats.numTriangles, stats.numVertices,
+    //             stats.numBatches, stats.numDroppedQuads);
 }
 
 void Sandbox::setupShaders() noexcept {
     auto expectedShaderProgram =
-            ShaderProgram::generateFromFiles(std::filesystem::current_path() / "assets" / "shaders" / "default.vert",
+            ShaderProgram::generateFromFiles(std::filesystem::current_path() / "assets" / "shaders" / "instanced.vert",
                                              std::filesystem::current_path() / "assets" / "shaders" / "default.frag");
     if (!expectedShaderProgram) {
         spdlog::error("Failed to generate shader program from files: {}", expectedShaderProgram.error());
@@ -97,7 +100,7 @@ void Sandbox::setupShaders() noexcept {
     mShaderPrograms.push_back(std::move(expectedShaderProgram.value()));
 
     expectedShaderProgram =
-            ShaderProgram::generateFromFiles(std::filesystem::current_path() / "assets" / "shaders" / "default.vert",
+            ShaderProgram::generateFromFiles(std::filesystem::current_path() / "assets" / "shaders" / "instanced.vert",
                                              std::filesystem::current_path() / "assets" / "shaders" / "debug.frag");
     if (!expectedShaderProgram) {
         spdlog::error("Failed to generate shader program from files: {}", expectedShaderProgram.error());
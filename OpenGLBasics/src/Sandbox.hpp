@@ -8,6 +8,7 @@
 #include "ShaderProgram.hpp"
 #include "VertexBuffer.hpp"
 #include "Texture.hpp"
+#include "TextureManager.hpp"
 #include "Renderer.hpp"
 #include <vector>
 
@@ -26,8 +27,10 @@ private:
 private:
     VertexBuffer mVertexBuffer;
     std::vector<ShaderProgram> mShaderPrograms;
+    // declared before the textures, which refer to its arrays
+    TextureManager mTextureManager;
     std::vector<Texture> mTextures;
-    Renderer mRenderer;
+    Renderer mRenderer{ Renderer::QuadRendering::Instanced };
 
     friend class Application;
 };
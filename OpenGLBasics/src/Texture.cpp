@@ -3,7 +3,9 @@
 //
 
 #include "Texture.hpp"
+#include "TextureArray.hpp"
 #include <spdlog/spdlog.h>
+#include <vector>
 
 tl::expected<Texture, std::string> Texture::Create(const Image& image) noexcept {
     GLint colorComponentFormat;
@@ -22,9 +24,9 @@ tl::expected<Texture, std::string> Texture::Create(const Image& image) noexcept
     Texture result;
     glGenTextures(1, &result.mName);
     result.bind();
-    glTexImage2D(GL_TEXTURE_2D, 0, colorComponentFormat, image.getWidth(), image.getHeight(), 0, colorComponentFormat,
-                 GL_UNSIGNED_BYTE, image.getData());
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, colorComponentFormat, image.getWidth(), image.getHeight(), 1, 0,
+                 colorComponentFormat, GL_UNSIGNED_BYTE, image.getData());
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
     result.mWidth = image.getWidth();
     result.mHeight = image.getHeight();
     result.mNumChannels = image.getNumChannels();
@@ -33,6 +35,36 @@ tl::expected<Texture, std::string> Texture::Create(const Image& image) noexcept
     return result;
 }
 
+tl::expected<Texture, std::string> Texture::CreateEmpty(int width, int height) noexcept {
+    if (width <= 0 || height <= 0) {
+        return tl::unexpected{ fmt::format("Invalid texture size: {}x{}", width, height) };
+    }
+
+    // transparent black, the default shader discards these pixels
+    const std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+    Texture result;
+    glGenTextures(1, &result.mName);
+    result.bind();
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    result.mWidth = width;
+    result.mHeight = height;
+    result.mNumChannels = 4;
+    result.setFiltering(Filtering::Linear);
+    result.setWrap(false);
+    return result;
+}
+
+void Texture::setSubImage(int x, int y, int width, int height, std::span<const std::uint8_t> data) const noexcept {
+    if (mNumChannels != 4 || x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > mWidth ||
+        y + height > mHeight || data.size() < static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4) {
+        spdlog::error("Cannot set sub image ({}, {}, {}x{}) of texture {}", x, y, width, height, getArrayName());
+        return;
+    }
+    // rows of RGBA pixels are always 4 byte aligned, so the default unpack alignment fits
+    glTextureSubImage3D(getArrayName(), 0, mX + x, mY + y, mLayer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        data.data());
+}
+
 void Texture::bind(GLint textureUnit) const noexcept {
     /*if (textureUnit < 0 || textureUnit >= getTextureUnitCount()) {
         spdlog::error("Cannot bind texture since {} is no valid texture unit.", textureUnit);
@@ -40,7 +72,7 @@ void Texture::bind(GLint textureUnit) const noexcept {
     }
     glActiveTexture(GL_TEXTURE0 + textureUnit);
     glBindTexture(GL_TEXTURE_2D, mName);*/
-    bind(mName, textureUnit);
+    bind(getArrayName(), textureUnit);
 }
 
 void Texture::unbind(GLint textureUnit) noexcept {
@@ -49,7 +81,7 @@ void Texture::unbind(GLint textureUnit) noexcept {
         return;
     }
     glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
 
 GLint Texture::getTextureUnitCount() noexcept {
@@ -63,15 +95,16 @@ GLint Texture::getTextureUnitCount() noexcept {
 void Texture::setFiltering(Texture::Filtering filtering) const noexcept {
     // TODO: Remove unnecessary binds
     bind();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering == Filtering::Linear ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER,
+                    filtering == Filtering::Linear ? GL_LINEAR : GL_NEAREST);
 }
 
 void Texture::setWrap(bool enabled) const noexcept {
     // TODO: Remove unnecessary binds
     bind();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, enabled ? GL_REPEAT : GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, enabled ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, enabled ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, enabled ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 }
 
 Texture::Texture(Texture&& other) noexcept {
@@ -80,6 +113,11 @@ Texture::Texture(Texture&& other) noexcept {
     swap(mWidth, other.mWidth);
     swap(mHeight, other.mHeight);
     swap(mNumChannels, other.mNumChannels);
+    swap(mArray, other.mArray);
+    swap(mLayer, other.mLayer);
+    swap(mX, other.mX);
+    swap(mY, other.mY);
+    swap(mUVRect, other.mUVRect);
 }
 
 Texture::~Texture() {
@@ -92,6 +130,11 @@ Texture& Texture::operator=(Texture&& other) noexcept {
     swap(mWidth, other.mWidth);
     swap(mHeight, other.mHeight);
     swap(mNumChannels, other.mNumChannels);
+    swap(mArray, other.mArray);
+    swap(mLayer, other.mLayer);
+    swap(mX, other.mX);
+    swap(mY, other.mY);
+    swap(mUVRect, other.mUVRect);
     return *this;
 }
 
@@ -113,5 +156,9 @@ void Texture::bind(GLuint textureName, GLint textureUnit) noexcept {
         return;
     }
     glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, textureName);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureName);
+}
+
+GLuint Texture::getArrayName() const noexcept {
+    return mArray != nullptr ? mArray->getName() : mName;
 }
@@ -7,7 +7,14 @@
 #include "Image.hpp"
 #include "expected/expected.hpp"
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
 
+class TextureArray;
+
+// A texture is the layer of a GL_TEXTURE_2D_ARRAY, or a rectangle of it. Textures created by Create() and
+// CreateEmpty() have an array with a single layer of their own, the ones of a TextureManager share its arrays.
 class Texture final {
 public:
     enum class Filtering {
@@ -26,24 +33,39 @@ public:
 
     void bind(GLint textureUnit = 0U) const noexcept;
     static void unbind(GLint textureUnit) noexcept;
+    // for textures of a TextureManager, these affect all textures of the same array
     void setFiltering(Filtering filtering) const noexcept;
     void setWrap(bool enabled) const noexcept;
     int getWidth() const noexcept;
     int getHeight() const noexcept;
     int getNumChannels() const noexcept;
+    // replaces a rectangle of an RGBA texture, the rows of data go from the bottom to the top
+    void setSubImage(int x, int y, int width, int height, std::span<const std::uint8_t> data) const noexcept;
 
     [[nodiscard]] static tl::expected<Texture, std::string> Create(const Image& image) noexcept;
+    // creates an RGBA texture without mipmaps that is transparent black until its contents are set via setSubImage()
+    [[nodiscard]] static tl::expected<Texture, std::string> CreateEmpty(int width, int height) noexcept;
     [[nodiscard]] static GLint getTextureUnitCount() noexcept;
 
 private:
     static void bind(GLuint textureName, GLint textureUnit) noexcept;
+    [[nodiscard]] GLuint getArrayName() const noexcept;
 
 private:
     static inline GLint sTextureUnitCount{ 0U };
     int mWidth{ 0U };
     int mHeight{ 0U };
     int mNumChannels{ 0U };
+    // only set if the texture owns its array
     GLuint mName{ 0U };
+    // the shared array of a texture of a TextureManager
+    TextureArray* mArray{ nullptr };
+    GLint mLayer{ 0 };
+    // position within the layer in pixels and in texture coordinates (left, bottom, right, top)
+    int mX{ 0 };
+    int mY{ 0 };
+    glm::vec4 mUVRect{ 0.0f, 0.0f, 1.0f, 1.0f };
 
     friend class Renderer;
+    friend class TextureManager;
 };
@@ -0,0 +1,70 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "TextureArray.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+TextureArray::TextureArray(int width, int height) noexcept : mWidth{ width }, mHeight{ height } { }
+
+TextureArray::~TextureArray() {
+    glDeleteTextures(1, &mName);
+}
+
+std::optional<GLint> TextureArray::addLayer() noexcept {
+    if (mNumLayers == mCapacity && !grow()) {
+        return {};
+    }
+    return mNumLayers++;
+}
+
+void TextureArray::setSubImage(int x,
+                               int y,
+                               GLint layer,
+                               int width,
+                               int height,
+                               GLenum format,
+                               const void* data) const noexcept {
+    // the rows of RGB images are not necessarily 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage3D(mName, 0, x, y, layer, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureArray::copyRegion(int sourceX,
+                              int sourceY,
+                              int x,
+                              int y,
+                              GLint layer,
+                              int width,
+                              int height) const noexcept {
+    glCopyImageSubData(mName, GL_TEXTURE_2D_ARRAY, 0, sourceX, sourceY, layer, mName, GL_TEXTURE_2D_ARRAY, 0, x, y,
+                       layer, width, height, 1);
+}
+
+bool TextureArray::grow() noexcept {
+    GLint maxLayers{ 0 };
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (mCapacity >= maxLayers) {
+        return false;
+    }
+    // doubling keeps the number of copies low while the array fills up
+    const auto capacity = std::min(std::max(mCapacity * 2, 1), maxLayers);
+    GLuint name{ 0U };
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &name);
+    glTextureStorage3D(name, 1, GL_RGBA8, mWidth, mHeight, capacity);
+    glTextureParameteri(name, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(name, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(name, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (mNumLayers > 0) {
+        glCopyImageSubData(mName, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, name, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, mWidth,
+                           mHeight, mNumLayers);
+    }
+    glDeleteTextures(1, &mName);
+    spdlog::info("Texture array of size {}x{} now has room for {} layers (name {})", mWidth, mHeight, capacity, name);
+    mName = name;
+    mCapacity = capacity;
+    return true;
+}
@@ -0,0 +1,47 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <glad/glad.h>
+#include <optional>
+
+// An RGBA8 GL_TEXTURE_2D_ARRAY whose layers all have the same size, without mipmaps. It grows by reallocating its
+// storage, which gives it a new name, so textures refer to the array itself instead of remembering its name.
+class TextureArray final {
+public:
+    TextureArray(int width, int height) noexcept;
+    TextureArray(const TextureArray&) = delete;
+    TextureArray(TextureArray&&) = delete;
+    ~TextureArray();
+
+    TextureArray& operator=(const TextureArray&) = delete;
+    TextureArray& operator=(TextureArray&&) = delete;
+
+    // returns the index of a new layer with undefined contents or nothing if the array cannot have more layers
+    [[nodiscard]] std::optional<GLint> addLayer() noexcept;
+    // format is the one of the data, e.g. GL_RGB, which is converted to RGBA
+    void setSubImage(int x, int y, GLint layer, int width, int height, GLenum format, const void* data) const noexcept;
+    // copies a rectangle within a layer, the source and the destination must not overlap
+    void copyRegion(int sourceX, int sourceY, int x, int y, GLint layer, int width, int height) const noexcept;
+    [[nodiscard]] GLuint getName() const noexcept {
+        return mName;
+    }
+    [[nodiscard]] int getWidth() const noexcept {
+        return mWidth;
+    }
+    [[nodiscard]] int getHeight() const noexcept {
+        return mHeight;
+    }
+
+private:
+    [[nodiscard]] bool grow() noexcept;
+
+private:
+    GLuint mName{ 0U };
+    int mWidth;
+    int mHeight;
+    GLsizei mNumLayers{ 0 };
+    GLsizei mCapacity{ 0 };
+};
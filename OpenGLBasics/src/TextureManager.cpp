@@ -0,0 +1,139 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "TextureManager.hpp"
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+tl::expected<Texture, std::string> TextureManager::add(const Image& image) noexcept {
+    GLenum format;
+    const int numChannels = image.getNumChannels();
+    switch (numChannels) {
+        case 3:
+            format = GL_RGB;
+            break;
+        case 4:
+            format = GL_RGBA;
+            break;
+        default:
+            return tl::unexpected{ fmt::format("Unsupported number of channels: {}", numChannels) };
+    }
+    GLint maxTextureSize{ 0 };
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (image.getWidth() <= 0 || image.getHeight() <= 0 || image.getWidth() > maxTextureSize ||
+        image.getHeight() > maxTextureSize) {
+        return tl::unexpected{ fmt::format("Invalid texture size: {}x{}", image.getWidth(), image.getHeight()) };
+    }
+    if (image.getWidth() <= maxAtlasImageSize && image.getHeight() <= maxAtlasImageSize) {
+        return addToAtlas(image, format);
+    }
+    return addToArray(image, format);
+}
+
+std::optional<TextureManager::AtlasRegion> TextureManager::allocateAtlasRegion(int width, int height) noexcept {
+    if (!mAtlas) {
+        mAtlas = std::make_unique<TextureArray>(atlasSize, atlasSize);
+    }
+    for (std::size_t i = 0; i < mAtlasPages.size(); ++i) {
+        if (auto region = allocateOnPage(mAtlasPages[i], width, height)) {
+            region->layer = gsl::narrow_cast<GLint>(i);
+            return region;
+        }
+    }
+    const auto layer = mAtlas->addLayer();
+    if (!layer) {
+        return {};
+    }
+    auto region = allocateOnPage(mAtlasPages.emplace_back(), width, height);
+    region->layer = *layer;
+    return region;
+}
+
+std::optional<TextureManager::AtlasRegion> TextureManager::allocateOnPage(AtlasPage& page,
+                                                                            int width,
+                                                                            int height) noexcept {
+    // the lowest shelf that is high enough wastes the least space
+    Shelf* bestShelf{ nullptr };
+    for (auto& shelf : page.shelves) {
+        if (shelf.height >= height && shelf.usedWidth + width <= atlasSize &&
+            (bestShelf == nullptr || shelf.height < bestShelf->height)) {
+            bestShelf = &shelf;
+        }
+    }
+    if (bestShelf == nullptr) {
+        if (page.usedHeight + height > atlasSize) {
+            return {};
+        }
+        bestShelf = &page.shelves.emplace_back(Shelf{ .y = page.usedHeight, .height = height, .usedWidth = 0 });
+        page.usedHeight += height;
+    }
+    const auto result = AtlasRegion{ .layer = 0, .x = bestShelf->usedWidth, .y = bestShelf->y };
+    bestShelf->usedWidth += width;
+    return result;
+}
+
+tl::expected<Texture, std::string> TextureManager::addToAtlas(const Image& image, GLenum format) noexcept {
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    // one pixel of padding on every side
+    const auto region = allocateAtlasRegion(width + 2, height + 2);
+    if (!region) {
+        return tl::unexpected{ fmt::format("The texture atlas has no room left for an image of size {}x{}", width,
+                                           height) };
+    }
+    const int x = region->x + 1;
+    const int y = region->y + 1;
+    mAtlas->setSubImage(x, y, region->layer, width, height, format, image.getData());
+    // the padding repeats the edges, so that sampling at the edges behaves like GL_CLAMP_TO_EDGE
+    mAtlas->copyRegion(x, y, x - 1, y, region->layer, 1, height);
+    mAtlas->copyRegion(x + width - 1, y, x + width, y, region->layer, 1, height);
+    mAtlas->copyRegion(x - 1, y, x - 1, y - 1, region->layer, width + 2, 1);
+    mAtlas->copyRegion(x - 1, y + height - 1, x - 1, y + height, region->layer, width + 2, 1);
+
+    constexpr auto size = static_cast<float>(atlasSize);
+    Texture result;
+    result.mArray = mAtlas.get();
+    result.mLayer = region->layer;
+    result.mX = x;
+    result.mY = y;
+    result.mWidth = width;
+    result.mHeight = height;
+    result.mNumChannels = 4;
+    result.mUVRect = glm::vec4{ static_cast<float>(x) / size, static_cast<float>(y) / size,
+                                static_cast<float>(x + width) / size, static_cast<float>(y + height) / size };
+    return result;
+}
+
+tl::expected<Texture, std::string> TextureManager::addToArray(const Image& image, GLenum format) noexcept {
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    TextureArray* array{ nullptr };
+    std::optional<GLint> layer;
+    for (const auto& candidate : mArrays) {
+        if (candidate->getWidth() == width && candidate->getHeight() == height) {
+            layer = candidate->addLayer();
+            if (layer) {
+                array = candidate.get();
+                break;
+            }
+        }
+    }
+    if (array == nullptr) {
+        array = mArrays.emplace_back(std::make_unique<TextureArray>(width, height)).get();
+        layer = array->addLayer();
+        if (!layer) {
+            return tl::unexpected{ fmt::format("Could not create a texture array of size {}x{}", width, height) };
+        }
+    }
+    array->setSubImage(0, 0, *layer, width, height, format, image.getData());
+
+    Texture result;
+    result.mArray = array;
+    result.mLayer = *layer;
+    result.mWidth = width;
+    result.mHeight = height;
+    result.mNumChannels = 4;
+    return result;
+}
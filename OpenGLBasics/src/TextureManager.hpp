@@ -0,0 +1,57 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "TextureArray.hpp"
+#include "Texture.hpp"
+#include "Image.hpp"
+#include "expected/expected.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Keeps the textures in a few texture arrays, so that the renderer can draw thousands of them in a single batch.
+// Images up to maxAtlasImageSize are packed into the layers of an atlas array by a shelf packer and surrounded by a
+// copy of their edges, so that linear filtering does not bleed between neighbors. Larger images share arrays with
+// images of the same size, one image per layer. The manager must outlive its textures, and textures must not be
+// added between Renderer::beginFrame() and Renderer::endFrame() since a growing array gets a new name.
+class TextureManager final {
+public:
+    static constexpr int atlasSize = 2048;
+    static constexpr int maxAtlasImageSize = atlasSize / 4;
+
+    [[nodiscard]] tl::expected<Texture, std::string> add(const Image& image) noexcept;
+
+private:
+    // a row of images of at most the height of the shelf, filled from left to right
+    struct Shelf {
+        int y;
+        int height;
+        int usedWidth;
+    };
+
+    struct AtlasPage {
+        std::vector<Shelf> shelves;
+        int usedHeight{ 0 };
+    };
+
+    struct AtlasRegion {
+        GLint layer;
+        int x;
+        int y;
+    };
+
+    [[nodiscard]] std::optional<AtlasRegion> allocateAtlasRegion(int width, int height) noexcept;
+    [[nodiscard]] static std::optional<AtlasRegion> allocateOnPage(AtlasPage& page, int width, int height) noexcept;
+    [[nodiscard]] tl::expected<Texture, std::string> addToAtlas(const Image& image, GLenum format) noexcept;
+    [[nodiscard]] tl::expected<Texture, std::string> addToArray(const Image& image, GLenum format) noexcept;
+
+private:
+    std::unique_ptr<TextureArray> mAtlas;
+    std::vector<AtlasPage> mAtlasPages;
+    // the arrays of the large images, the textures point to them, so they must not move
+    std::vector<std::unique_ptr<TextureArray>> mArrays;
+};
@@ -3,6 +3,7 @@
 //
 
 #include "VertexBuffer.hpp"
+#include <cstdint>
 
 VertexBuffer::VertexBuffer() noexcept {
     glGenVertexArrays(1U, &mVertexArrayObjectName);
@@ -16,12 +17,19 @@ VertexBuffer::VertexBuffer(VertexBuffer&& other) noexcept {
     swap(mVertexBufferObjectName, other.mVertexBufferObjectName);
     swap(mElementBufferObjectName, other.mElementBufferObjectName);
     swap(mNumIndices, other.mNumIndices);
+    swap(mVertexRingBuffer, other.mVertexRingBuffer);
+    swap(mVertexSize, other.mVertexSize);
+    swap(mNumVertexAttributes, other.mNumVertexAttributes);
+    swap(mInstanceBufferObjectName, other.mInstanceBufferObjectName);
+    swap(mInstanceRingBuffer, other.mInstanceRingBuffer);
+    swap(mInstanceSize, other.mInstanceSize);
 }
 
 VertexBuffer::~VertexBuffer() {
     glDeleteBuffers(1U, &mVertexBufferObjectName);
     glDeleteVertexArrays(1U, &mVertexArrayObjectName);
     glDeleteBuffers(1U, &mElementBufferObjectName);
+    glDeleteBuffers(1U, &mInstanceBufferObjectName);
 }
 
 VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other) noexcept {
@@ -30,6 +38,12 @@ VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other) noexcept {
     swap(mVertexBufferObjectName, other.mVertexBufferObjectName);
     swap(mElementBufferObjectName, other.mElementBufferObjectName);
     swap(mNumIndices, other.mNumIndices);
+    swap(mVertexRingBuffer, other.mVertexRingBuffer);
+    swap(mVertexSize, other.mVertexSize);
+    swap(mNumVertexAttributes, other.mNumVertexAttributes);
+    swap(mInstanceBufferObjectName, other.mInstanceBufferObjectName);
+    swap(mInstanceRingBuffer, other.mInstanceRingBuffer);
+    swap(mInstanceSize, other.mInstanceSize);
     return *this;
 }
 
@@ -45,6 +59,57 @@ void VertexBuffer::unbind() noexcept {
     unbindVertexArrayObject();
 }
 
+void VertexBuffer::drawVertexSection(std::size_t numIndices) noexcept {
+    bind();
+    // the base vertex selects the section, so the vertex attribute layout and the indices stay the same for all of them
+    const auto baseVertex = mVertexRingBuffer.getSectionOffset() / mVertexSize;
+    glDrawElementsBaseVertex(GL_TRIANGLES, gsl::narrow_cast<GLsizei>(numIndices), GL_UNSIGNED_INT, nullptr,
+                             gsl::narrow_cast<GLint>(baseVertex));
+    mVertexRingBuffer.releaseSection();
+}
+
+void VertexBuffer::drawInstancedSection(std::size_t numInstances) noexcept {
+    bind();
+    // the base instance selects the section, the vertex and the index data is the same for all instances
+    const auto baseInstance = mInstanceRingBuffer.getSectionOffset() / mInstanceSize;
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, gsl::narrow_cast<GLsizei>(mNumIndices), GL_UNSIGNED_INT,
+                                        nullptr, gsl::narrow_cast<GLsizei>(numInstances),
+                                        gsl::narrow_cast<GLuint>(baseInstance));
+    mInstanceRingBuffer.releaseSection();
+}
+
+void VertexBuffer::setAttributeLayout(std::initializer_list<VertexAttributeDefinition> definitions,
+                                      GLuint firstLocation,
+                                      GLuint divisor) noexcept {
+    GLuint location{ firstLocation };
+    std::uintptr_t offset{ 0U };
+    GLsizei stride{ 0 };
+    // calculate stride
+    std::for_each(definitions.begin(), definitions.end(), [&stride](const VertexAttributeDefinition& definition) {
+        stride += gsl::narrow_cast<GLsizei>(GLUtils::getSizeOfGLType(definition.type) * definition.count);
+    });
+
+    // set vertex attributes
+    std::for_each(definitions.begin(), definitions.end(),
+                  [&location, &offset, stride, divisor](const VertexAttributeDefinition& definition) {
+                      if (GLUtils::isIntegralType(definition.type)) {
+                          glVertexAttribIPointer(location, definition.count, definition.type, stride, (void*) offset);
+                      } else {
+                          glVertexAttribPointer(location, definition.count, definition.type, definition.normalized,
+                                                stride, (void*) offset);
+                      }
+                      glVertexAttribDivisor(location, divisor);
+                      glEnableVertexAttribArray(location);
+                      spdlog::info(
+                              "Enabled vertex attribute {} (count {}, type {}, normalized {}, stride {}, "
+                              "offset {}, divisor {})",
+                              location, definition.count, definition.type, definition.normalized, stride, offset,
+                              divisor);
+                      ++location;
+                      offset += GLUtils::getSizeOfGLType(definition.type) * definition.count;
+                  });
+}
+
 void VertexBuffer::bindVertexArrayObject() const noexcept {
     if (sCurrentlyBoundVertexArrayObjectName != mVertexArrayObjectName) {
         glBindVertexArray(mVertexArrayObjectName);
@@ -7,6 +7,7 @@
 #include "VertexAttributeDefinition.hpp"
 #include "GLDataUsagePattern.hpp"
 #include "GlUtils.hpp"
+#include "RingBuffer.hpp"
 #include <glad/glad.h>
 #include <gsl/gsl_util>
 #include <concepts>
@@ -31,11 +32,14 @@ public:
     [[nodiscard]] std::size_t indicesCount() const noexcept {
         return mNumIndices;
     }
-    void setVertexAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args) const;
+    void setVertexAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args);
+    // the attributes follow the vertex attributes and advance once per instance, see allocateInstanceRingBuffer()
+    void setInstanceAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args);
 
     template<typename VertexData>
     void submitVertexData(std::span<VertexData> data, GLDataUsagePattern dataUsagePattern) noexcept {
         bindVertexArrayObject();
+        bindVertexBufferObject();
         glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(typename decltype(data)::value_type), data.data(),
                      static_cast<GLenum>(dataUsagePattern));
     }
@@ -47,6 +51,7 @@ public:
 
     template<typename IndexData>
     void submitIndexData(std::span<IndexData> data, GLDataUsagePattern dataUsagePattern) noexcept {
+        bindVertexArrayObject();
         bindElementBufferObject();
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.size() * sizeof(typename decltype(data)::value_type), data.data(),
                      static_cast<GLenum>(dataUsagePattern));
@@ -60,7 +65,55 @@ public:
         submitIndexData(std::span{ std::forward<IndexData>(data) }, dataUsagePattern);
     }
 
+    // Gives the vertex buffer persistently mapped storage for numSections batches of at most maxVertices vertices (see
+    // RingBuffer). Afterwards, the vertices of a batch are written directly into the section returned by
+    // acquireVertexSection() and drawn with drawVertexSection(), submitVertexData() must not be used anymore. The
+    // indices are submitted once and shared by all batches, so they have to be relative to the start of a section.
+    template<typename VertexData>
+    void allocateVertexRingBuffer(std::size_t maxVertices,
+                                  std::size_t numSections = RingBuffer::defaultNumSections) noexcept {
+        // the buffer objects only exist after their first binding
+        bind();
+        mVertexRingBuffer = RingBuffer{ mVertexBufferObjectName, maxVertices * sizeof(VertexData), numSections };
+        mVertexSize = sizeof(VertexData);
+    }
+
+    template<typename VertexData>
+    [[nodiscard]] std::span<VertexData> acquireVertexSection() noexcept {
+        const auto bytes = mVertexRingBuffer.acquireSection();
+        return std::span{ reinterpret_cast<VertexData*>(bytes.data()), bytes.size() / sizeof(VertexData) };
+    }
+
+    // draws triangles from the first numIndices submitted indices, which refer to the vertices of the current vertex
+    // section, and releases the section
+    void drawVertexSection(std::size_t numIndices) noexcept;
+
+    // Creates a third buffer with persistently mapped storage for numSections batches of at most maxInstances
+    // instances (see RingBuffer). The per-instance data of a batch is written into the section returned by
+    // acquireInstanceSection(), the submitted vertex and index data is drawn once per instance by
+    // drawInstancedSection().
+    template<typename InstanceData>
+    void allocateInstanceRingBuffer(std::size_t maxInstances,
+                                    std::size_t numSections = RingBuffer::defaultNumSections) noexcept {
+        glCreateBuffers(1U, &mInstanceBufferObjectName);
+        mInstanceRingBuffer = RingBuffer{ mInstanceBufferObjectName, maxInstances * sizeof(InstanceData), numSections };
+        mInstanceSize = sizeof(InstanceData);
+    }
+
+    template<typename InstanceData>
+    [[nodiscard]] std::span<InstanceData> acquireInstanceSection() noexcept {
+        const auto bytes = mInstanceRingBuffer.acquireSection();
+        return std::span{ reinterpret_cast<InstanceData*>(bytes.data()), bytes.size() / sizeof(InstanceData) };
+    }
+
+    // draws the submitted triangles for the first numInstances instances of the current instance section and
+    // releases the section
+    void drawInstancedSection(std::size_t numInstances) noexcept;
+
 private:
+    void setAttributeLayout(std::initializer_list<VertexAttributeDefinition> definitions,
+                            GLuint firstLocation,
+                            GLuint divisor) noexcept;
     void bindVertexArrayObject() const noexcept;
     void bindVertexBufferObject() const noexcept;
     void bindElementBufferObject() const noexcept;
@@ -76,34 +129,24 @@ private:
     GLuint mVertexBufferObjectName{ 0u };
     GLuint mElementBufferObjectName{ 0U };
     std::size_t mNumIndices{ 0U };
+    RingBuffer mVertexRingBuffer;
+    std::size_t mVertexSize{ 0U };
+    GLuint mNumVertexAttributes{ 0U };
+    GLuint mInstanceBufferObjectName{ 0U };
+    RingBuffer mInstanceRingBuffer;
+    std::size_t mInstanceSize{ 0U };
 };
 
-void VertexBuffer::setVertexAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args) const {
-    bind();
-    const auto values = { args... };
-    GLuint location{ 0U };
-    std::uintptr_t offset{ 0U };
-    GLsizei stride{ 0 };
-    // calculate stride
-    std::for_each(values.begin(), values.end(), [&stride](const VertexAttributeDefinition& definition) {
-        stride += gsl::narrow_cast<GLsizei>(GLUtils::getSizeOfGLType(definition.type) * definition.count);
-    });
-
-    // set vertex attributes
-    std::for_each(values.begin(), values.end(),
-                  [&location, &offset, stride](const VertexAttributeDefinition& definition) {
-                      if (GLUtils::isIntegralType(definition.type)) {
-                          glVertexAttribIPointer(location, definition.count, definition.type, stride, (void*) offset);
-                      } else {
-                          glVertexAttribPointer(location, definition.count, definition.type, definition.normalized,
-                                                stride, (void*) offset);
-                      }
-                      glEnableVertexAttribArray(location);
-                      spdlog::info(
-                              "Enabled vertex attribute {} (count {}, type {}, normalized {}, stride {}, "
-                              "offset {})",
-                              location, definition.count, definition.type, definition.normalized, stride, offset);
-                      ++location;
-                      offset += GLUtils::getSizeOfGLType(definition.type) * definition.count;
-                  });
+void VertexBuffer::setVertexAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args) {
+    bindVertexArrayObject();
+    bindVertexBufferObject();
+    setAttributeLayout({ args... }, 0U, 0U);
+    mNumVertexAttributes = gsl::narrow_cast<GLuint>(sizeof...(args));
+}
+
+void VertexBuffer::setInstanceAttributeLayout(std::convertible_to<VertexAttributeDefinition> auto... args) {
+    bindVertexArrayObject();
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBufferObjectName);
+    sCurrentlyBoundVertexBufferObjectName = mInstanceBufferObjectName;
+    setAttributeLayout({ args... }, mNumVertexAttributes, 1U);
 }
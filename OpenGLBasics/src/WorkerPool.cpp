@@ -0,0 +1,105 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(std::size_t numWorkers) {
+    mWorkers.reserve(numWorkers);
+    for (std::size_t i = 0; i < numWorkers; ++i) {
+        mWorkers.emplace_back([this](const std::stop_token& stopToken) { workerLoop(stopToken); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    // the workers are woken up by the stop requests of the jthreads
+    for (auto& worker : mWorkers) {
+        worker.request_stop();
+    }
+    mWorkers.clear();
+}
+
+void WorkerPool::parallelFor(std::size_t count, std::size_t minChunkSize, const Job& job) noexcept {
+    const auto chunkSize = std::max(minChunkSize, std::size_t{ 1 });
+    const auto numChunks = std::min((count + chunkSize - 1) / chunkSize, mWorkers.size() + 1);
+    if (numChunks <= 1) {
+        if (count > 0) {
+            job(0, count);
+        }
+        return;
+    }
+    {
+        std::scoped_lock lock{ mMutex };
+        mJob = &job;
+        mCount = count;
+        // spread evenly, so that no thread gets a much smaller chunk than the others
+        mChunkSize = (count + numChunks - 1) / numChunks;
+        mNumChunks = numChunks;
+        mNextChunk = 0U;
+        mNumFinishedChunks = 0U;
+        ++mGeneration;
+    }
+    mWorkAvailable.notify_all();
+    runChunks();
+    std::unique_lock lock{ mMutex };
+    // a worker that woke up late must not take chunks of the next job, so all of them have to be done with this one
+    mWorkDone.wait(lock, [this] { return mNumFinishedChunks == mNumChunks && mNumActiveWorkers == 0U; });
+    mJob = nullptr;
+}
+
+std::size_t WorkerPool::defaultNumWorkers() noexcept {
+    const auto numThreads = std::size_t{ std::thread::hardware_concurrency() };
+    return numThreads > 1U ? numThreads - 1U : 0U;
+}
+
+void WorkerPool::workerLoop(const std::stop_token& stopToken) noexcept {
+    std::size_t lastGeneration = 0U;
+    while (true) {
+        {
+            std::unique_lock lock{ mMutex };
+            if (!mWorkAvailable.wait(lock, stopToken, [&] { return mGeneration != lastGeneration; })) {
+                return;
+            }
+            lastGeneration = mGeneration;
+            if (mJob == nullptr) {
+                continue;
+            }
+            ++mNumActiveWorkers;
+        }
+        runChunks();
+        {
+            std::scoped_lock lock{ mMutex };
+            --mNumActiveWorkers;
+        }
+        mWorkDone.notify_one();
+    }
+}
+
+void WorkerPool::runChunks() noexcept {
+    while (true) {
+        std::size_t begin;
+        std::size_t end;
+        {
+            std::scoped_lock lock{ mMutex };
+            if (mNextChunk == mNumChunks) {
+                return;
+            }
+            begin = mNextChunk * mChunkSize;
+            end = std::min(begin + mChunkSize, mCount);
+            ++mNextChunk;
+        }
+        if (begin < end) {
+            (*mJob)(begin, end);
+        }
+        bool lastChunk;
+        {
+            std::scoped_lock lock{ mMutex };
+            ++mNumFinishedChunks;
+            lastChunk = (mNumFinishedChunks == mNumChunks);
+        }
+        if (lastChunk) {
+            mWorkDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that sleep until work is handed to them by parallelFor. The calling thread works on the
+// chunks as well, so a pool without workers runs everything on the calling thread.
+class WorkerPool final {
+public:
+    using Job = std::function<void(std::size_t begin, std::size_t end)>;
+
+    // one thread less than the hardware provides, since the calling thread takes part in the work
+    explicit WorkerPool(std::size_t numWorkers = defaultNumWorkers());
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    ~WorkerPool();
+
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    // Splits [0, count) into consecutive chunks of at least minChunkSize elements (apart from the last one) and calls
+    // job(begin, end) for each of them. Returns when all chunks are done. The job must not throw.
+    void parallelFor(std::size_t count, std::size_t minChunkSize, const Job& job) noexcept;
+    [[nodiscard]] std::size_t getNumWorkers() const noexcept {
+        return mWorkers.size();
+    }
+
+    [[nodiscard]] static std::size_t defaultNumWorkers() noexcept;
+
+private:
+    void workerLoop(const std::stop_token& stopToken) noexcept;
+    void runChunks() noexcept;
+
+private:
+    std::mutex mMutex;
+    std::condition_variable_any mWorkAvailable;
+    std::condition_variable mWorkDone;
+    // the current job, only valid while parallelFor runs
+    const Job* mJob{ nullptr };
+    std::size_t mCount{ 0U };
+    std::size_t mChunkSize{ 0U };
+    std::size_t mNumChunks{ 0U };
+    std::size_t mNextChunk{ 0U };
+    std::size_t mNumFinishedChunks{ 0U };
+    // workers that may still take chunks of the current job
+    std::size_t mNumActiveWorkers{ 0U };
+    std::size_t mGeneration{ 0U };
+    std::vector<std::jthread> mWorkers;
+};
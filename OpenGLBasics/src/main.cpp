@@ -3,7 +3,7 @@
 
 int main() {
     Sandbox sandbox{ "OpenGL application", WindowSize{ .width{ 800 }, .height{ 600 } },
-                     OpenGLVersion{ .major{ 4 }, .minor{ 3 } } };
+                     OpenGLVersion{ .major{ 4 }, .minor{ 5 } } };
     if (sandbox.hasError()) {
         return EXIT_FAILURE;
     }
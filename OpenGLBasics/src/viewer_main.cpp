@@ -0,0 +1,27 @@
+#include "RayTracerViewer.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    // the render starts right away and keeps running while the window is created
+    auto expectedSession = RayTracerSession::Create(argc, argv);
+    if (!expectedSession) {
+        spdlog::error("Could not start the ray tracer: {}", expectedSession.error());
+        return EXIT_FAILURE;
+    }
+    // one window pixel per image pixel, unless the image is too large
+    constexpr auto maxWindowWidth = 1600;
+    constexpr auto maxWindowHeight = 900;
+    const auto imageWidth = expectedSession->getWidth();
+    const auto imageHeight = expectedSession->getHeight();
+    const auto scale = std::min({ 1.0, static_cast<double>(maxWindowWidth) / static_cast<double>(imageWidth),
+                                  static_cast<double>(maxWindowHeight) / static_cast<double>(imageHeight) });
+    const auto windowSize = WindowSize{ .width{ std::max(1, static_cast<int>(scale * imageWidth)) },
+                                        .height{ std::max(1, static_cast<int>(scale * imageHeight)) } };
+    RayTracerViewer viewer{ std::move(expectedSession.value()), "Ray tracer", windowSize,
+                            OpenGLVersion{ .major{ 4 }, .minor{ 5 } } };
+    if (viewer.hasError()) {
+        return EXIT_FAILURE;
+    }
+    viewer.run();
+}
@@ -0,0 +1,122 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Ray.hpp"
+#include "Utility.hpp"
+#include "Vec3.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+// axis aligned bounding box, a default constructed box is empty and can be extended
+struct BoundingBox {
+    Point3 min{ infinity, infinity, infinity };
+    Point3 max{ -infinity, -infinity, -infinity };
+
+    [[nodiscard]] static BoundingBox ofSphere(const Point3& center, const double radius) {
+        const auto extent = Vec3{ radius, radius, radius };
+        return BoundingBox{ .min{ center - extent }, .max{ center + extent } };
+    }
+
+    // Conservative bounds of the part of the sphere that lies inside the clip box, empty if there is none. Each axis
+    // clips the sphere to a slab whose widest cross section bounds the other two axes, the result is the intersection
+    // of these three boxes. Much tighter than the clip box when only a small cap of a large sphere lies inside it.
+    [[nodiscard]] static BoundingBox ofClippedSphere(const Point3& center,
+                                                     const double radius,
+                                                     const BoundingBox& clip) {
+        auto result = ofSphere(center, radius).intersection(clip);
+        for (int axis = 0; axis < 3 && !result.isEmpty(); ++axis) {
+            const auto centerComponent = component(center, axis);
+            const auto lower = component(result.min, axis);
+            const auto upper = component(result.max, axis);
+            const auto distance = std::max({ lower - centerComponent, centerComponent - upper, 0.0 });
+            // padded, so that rays that graze the sphere never miss its box because of rounding
+            const auto crossSectionRadius =
+                    std::sqrt(std::max(radius * radius - distance * distance, 0.0)) + radius * 1.0e-9;
+            const auto extent = Vec3{ crossSectionRadius, crossSectionRadius, crossSectionRadius };
+            result = result.intersection(BoundingBox{ .min{ withComponent(center - extent, axis, lower) },
+                                                      .max{ withComponent(center + extent, axis, upper) } });
+        }
+        return result.isEmpty() ? BoundingBox{} : result;
+    }
+
+    [[nodiscard]] static double component(const Vec3& vector, const int axis) {
+        return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+    }
+
+    [[nodiscard]] static Vec3 withComponent(Vec3 vector, const int axis, const double value) {
+        (axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z)) = value;
+        return vector;
+    }
+
+    [[nodiscard]] bool isEmpty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    void extend(const BoundingBox& other) {
+        min = Point3{ std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z) };
+        max = Point3{ std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z) };
+    }
+
+    void extend(const Point3& point) {
+        extend(BoundingBox{ .min{ point }, .max{ point } });
+    }
+
+    // may be empty
+    [[nodiscard]] BoundingBox intersection(const BoundingBox& other) const {
+        return BoundingBox{
+            .min{ std::max(min.x, other.min.x), std::max(min.y, other.min.y), std::max(min.z, other.min.z) },
+            .max{ std::min(max.x, other.max.x), std::min(max.y, other.max.y), std::min(max.z, other.max.z) }
+        };
+    }
+
+    // 0 for empty boxes
+    [[nodiscard]] double surfaceArea() const {
+        if (isEmpty()) {
+            return 0.0;
+        }
+        const auto extent = max - min;
+        return 2.0 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    [[nodiscard]] Point3 centroid() const {
+        return 0.5 * (min + max);
+    }
+
+    [[nodiscard]] bool contains(const Point3& point) const {
+        return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z &&
+               point.z <= max.z;
+    }
+
+    [[nodiscard]] int longestAxis() const {
+        const auto extent = max - min;
+        if (extent.x >= extent.y && extent.x >= extent.z) {
+            return 0;
+        }
+        return extent.y >= extent.z ? 1 : 2;
+    }
+
+    // Distance at which the ray enters the box (or tMin if it starts inside), if it passes the box within
+    // [tMin, tMax]. Slab test, the divisions by zero of axis parallel rays produce infinities that compare correctly.
+    [[nodiscard]] std::optional<double> intersect(const Ray& ray, double tMin, double tMax) const {
+        for (int axis = 0; axis < 3; ++axis) {
+            const auto inverseDirection = 1.0 / component(ray.direction, axis);
+            const auto origin = component(ray.origin, axis);
+            auto tNear = (component(min, axis) - origin) * inverseDirection;
+            auto tFar = (component(max, axis) - origin) * inverseDirection;
+            if (inverseDirection < 0.0) {
+                std::swap(tNear, tFar);
+            }
+            tMin = std::max(tMin, tNear);
+            tMax = std::min(tMax, tFar);
+            if (tMax < tMin) {
+                return {};
+            }
+        }
+        return tMin;
+    }
+};
@@ -0,0 +1,563 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Hittable.hpp"
+#include "Ray.hpp"
+#include "Statistics.hpp"
+#include "Utility.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+enum class BvhType : std::uint32_t {
+    // the world stays a flat list that every ray is tested against
+    None,
+    // every object ends up in exactly one leaf
+    ObjectSplits,
+    // objects that straddle a split plane may be clipped into both children (SBVH)
+    SpatialSplits,
+};
+
+struct BvhSettings {
+    BvhType type{ BvhType::SpatialSplits };
+    std::size_t maxLeafSize{ 4 };
+    // Spatial splits are only considered where the children of the best object split overlap by more than this
+    // fraction of the surface area of the root. Keeps the duplication to the parts of the scene that need it.
+    double minOverlap{ 1.0e-5 };
+    // cap of the memory growth: spatial splits may add at most this many references per object
+    double maxDuplication{ 1.0 };
+    int numSpatialBins{ 32 };
+};
+
+// Bounding volume hierarchy over the objects of a World. The leaves store indices into the object list, so the
+// hierarchy does not own the objects. With spatial splits (Stich et al., "Spatial Splits in Bounding Volume
+// Hierarchies"), the builder chooses between object splits, which partition the references of a node, and spatial
+// splits, which cut the node at a plane and put references that straddle it into both children, clipped to their
+// side. This keeps large objects like the ground sphere of the demo scene from inflating every node they are in.
+class Bvh {
+public:
+    struct Statistics {
+        std::size_t numNodes{ 0 };
+        std::size_t numLeaves{ 0 };
+        // references to objects in the leaves, more than the number of objects if spatial splits duplicated any
+        std::size_t numReferences{ 0 };
+        std::size_t numSpatialSplits{ 0 };
+        std::size_t numUnboundedObjects{ 0 };
+    };
+
+    // objects that are added to the world later are tested against every ray
+    [[nodiscard]] static Bvh build(const std::vector<std::unique_ptr<Hittable>>& objects, const BvhSettings& settings);
+    // hierarchy over plain boxes whose leaves store indices into boxes, traversed with visitLeaves()
+    [[nodiscard]] static Bvh build(const std::vector<BoundingBox>& boxes, const BvhSettings& settings);
+
+    // Same result as testing all objects in order: the closest hit, and of several hits at the same distance the
+    // one of the object with the lowest index. ObjectType can be the concrete type of all objects of the world.
+    template<typename ObjectType = Hittable>
+    [[nodiscard]] std::optional<std::pair<double, std::size_t>> closestHit(
+            const std::vector<std::unique_ptr<Hittable>>& objects,
+            const Ray& ray,
+            const double tMin,
+            const double tMax,
+            RenderStatistics& statistics) const {
+        std::optional<std::pair<double, std::size_t>> result;
+        const auto test = [&](const std::size_t objectIndex) {
+            ++statistics.intersectionTests;
+            const auto& object = static_cast<const ObjectType&>(*objects[objectIndex]);
+            const auto hit = object.hit(ray, tMin, result ? result->first : tMax);
+            if (hit && (!result || *hit < result->first || (*hit == result->first && objectIndex < result->second))) {
+                result = std::pair{ *hit, objectIndex };
+            }
+        };
+        traverse(ray, tMin, [&]() { return result ? result->first : tMax; }, statistics, [&](const Node& leaf) {
+            for (std::uint32_t i = 0; i < leaf.count; ++i) {
+                test(mReferences[leaf.offset + i]);
+            }
+            return false;
+        });
+        for (const auto objectIndex : mUnboundedObjects) {
+            test(objectIndex);
+        }
+        for (auto i = mNumObjects; i < objects.size(); ++i) {
+            test(i);
+        }
+        return result;
+    }
+
+    template<typename ObjectType = Hittable>
+    [[nodiscard]] bool anyHit(const std::vector<std::unique_ptr<Hittable>>& objects,
+                              const Ray& ray,
+                              const double tMin,
+                              const double tMax,
+                              RenderStatistics& statistics) const {
+        const auto test = [&](const std::size_t objectIndex) {
+            ++statistics.intersectionTests;
+            return static_cast<bool>(static_cast<const ObjectType&>(*objects[objectIndex]).hit(ray, tMin, tMax));
+        };
+        const auto found = traverse(ray, tMin, [tMax]() { return tMax; }, statistics, [&](const Node& leaf) {
+            for (std::uint32_t i = 0; i < leaf.count; ++i) {
+                if (test(mReferences[leaf.offset + i])) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (found) {
+            return true;
+        }
+        for (const auto objectIndex : mUnboundedObjects) {
+            if (test(objectIndex)) {
+                return true;
+            }
+        }
+        for (auto i = mNumObjects; i < objects.size(); ++i) {
+            if (test(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls visitLeaf with the indices stored in every leaf whose box the ray enters before currentTMax(), front to
+    // back, for hierarchies whose leaves don't refer to the objects of a world. Stops as soon as visitLeaf returns true.
+    template<typename CurrentTMax, typename VisitLeaf>
+    void visitLeaves(const Ray& ray,
+                     const double tMin,
+                     CurrentTMax currentTMax,
+                     RenderStatistics& statistics,
+                     VisitLeaf visitLeaf) const {
+        traverse(ray, tMin, currentTMax, statistics, [&](const Node& leaf) {
+            return visitLeaf(std::span{ mReferences.data() + leaf.offset, leaf.count });
+        });
+    }
+
+    [[nodiscard]] const Statistics& statistics() const {
+        return mStatistics;
+    }
+
+private:
+    friend class BvhBuilder;
+
+    // the nodes are stored depth first, so the first child of an inner node directly follows it
+    struct Node {
+        BoundingBox bounds;
+        // leaves: first index into mReferences, inner nodes: index of the second child
+        std::uint32_t offset;
+        // 0 for inner nodes
+        std::uint32_t count;
+        // inner nodes: the axis of the split, rays that point towards -axis visit the second child first
+        std::uint32_t axis;
+    };
+
+    // the depth of the hierarchy is limited, so a fixed stack suffices
+    static constexpr std::size_t maxDepth = 64;
+
+    // Calls visitLeaf for the leaves whose boxes the ray enters before currentTMax(), front to back. Stops as soon as
+    // visitLeaf returns true and returns whether it did.
+    template<typename CurrentTMax, typename VisitLeaf>
+    bool traverse(const Ray& ray,
+                  const double tMin,
+                  CurrentTMax currentTMax,
+                  RenderStatistics& statistics,
+                  VisitLeaf visitLeaf) const {
+        if (mNodes.empty()) {
+            return false;
+        }
+        const auto negativeDirection =
+                std::array{ ray.direction.x < 0.0, ray.direction.y < 0.0, ray.direction.z < 0.0 };
+        std::array<std::uint32_t, maxDepth + 1> stack;
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const auto& node = mNodes[stack[--stackSize]];
+            ++statistics.nodeVisits;
+            if (!node.bounds.intersect(ray, tMin, currentTMax())) {
+                continue;
+            }
+            if (node.count > 0) {
+                if (visitLeaf(node)) {
+                    return true;
+                }
+                continue;
+            }
+            const auto firstChild = static_cast<std::uint32_t>(&node - mNodes.data()) + 1;
+            if (negativeDirection[node.axis]) {
+                stack[stackSize++] = firstChild;
+                stack[stackSize++] = node.offset;
+            } else {
+                stack[stackSize++] = node.offset;
+                stack[stackSize++] = firstChild;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Node> mNodes;
+    std::vector<std::uint32_t> mReferences;
+    // objects without bounds
+    std::vector<std::uint32_t> mUnboundedObjects;
+    // objects that existed when the hierarchy was built
+    std::size_t mNumObjects{ 0 };
+    Statistics mStatistics;
+};
+
+class BvhBuilder {
+public:
+    // clippedBounds(i, clip) returns the bounds of the part of object i that lies inside clip, see Hittable
+    using ClippedBounds = std::function<std::optional<BoundingBox>(std::size_t, const BoundingBox&)>;
+
+    BvhBuilder(const std::size_t numObjects, ClippedBounds clippedBounds, const BvhSettings& settings)
+        : mNumObjects{ numObjects },
+          mClippedBounds{ std::move(clippedBounds) },
+          mSettings{ settings } { }
+
+    [[nodiscard]] Bvh build() {
+        std::vector<Reference> references;
+        auto bounds = BoundingBox{};
+        for (std::size_t i = 0; i < mNumObjects; ++i) {
+            const auto objectBounds = mClippedBounds(i, everything);
+            if (!objectBounds) {
+                mResult.mUnboundedObjects.push_back(static_cast<std::uint32_t>(i));
+            } else if (!objectBounds->isEmpty()) {
+                references.push_back(
+                        Reference{ .bounds{ *objectBounds }, .objectIndex{ static_cast<std::uint32_t>(i) } });
+                bounds.extend(*objectBounds);
+            }
+        }
+        mResult.mNumObjects = mNumObjects;
+        mRootArea = bounds.surfaceArea();
+        mRemainingDuplicates =
+                static_cast<std::size_t>(mSettings.maxDuplication * static_cast<double>(references.size()));
+        if (!references.empty()) {
+            buildNode(std::move(references), bounds, 0);
+        }
+        mResult.mStatistics.numNodes = mResult.mNodes.size();
+        mResult.mStatistics.numReferences = mResult.mReferences.size();
+        mResult.mStatistics.numUnboundedObjects = mResult.mUnboundedObjects.size();
+        return std::move(mResult);
+    }
+
+private:
+    // the part of an object that belongs to a node
+    struct Reference {
+        BoundingBox bounds;
+        std::uint32_t objectIndex;
+    };
+
+    enum class SplitType {
+        None,
+        Object,
+        Spatial,
+    };
+
+    struct Split {
+        SplitType type{ SplitType::None };
+        double cost{ infinity };
+        int axis{ 0 };
+        // object splits: the number of references in the first child after sorting by centroid along the axis
+        std::size_t numLeft{ 0 };
+        // spatial splits
+        double position{ 0.0 };
+        BoundingBox left;
+        BoundingBox right;
+    };
+
+    struct Bin {
+        BoundingBox bounds;
+        // references that start and end in this bin
+        std::size_t numEntries{ 0 };
+        std::size_t numExits{ 0 };
+    };
+
+    // relative to the cost of one intersection test
+    static constexpr double traversalCost = 1.0;
+
+    static constexpr BoundingBox everything{ .min{ -infinity, -infinity, -infinity },
+                                             .max{ infinity, infinity, infinity } };
+
+    std::uint32_t buildNode(std::vector<Reference> references, const BoundingBox& bounds, const std::size_t depth) {
+        const auto nodeIndex = static_cast<std::uint32_t>(mResult.mNodes.size());
+        mResult.mNodes.push_back(Bvh::Node{ .bounds{ bounds }, .offset{ 0 }, .count{ 0 }, .axis{ 0 } });
+        if (references.size() <= mSettings.maxLeafSize || depth >= Bvh::maxDepth) {
+            makeLeaf(nodeIndex, references);
+            return nodeIndex;
+        }
+        const auto objectSplit = findObjectSplit(references, bounds);
+        auto split = objectSplit;
+        if (mSettings.type == BvhType::SpatialSplits && mRemainingDuplicates > 0 && mRootArea > 0.0 &&
+            objectSplit.left.intersection(objectSplit.right).surfaceArea() > mSettings.minOverlap * mRootArea) {
+            if (auto spatialSplit = findSpatialSplit(references, bounds); spatialSplit.cost < split.cost) {
+                split = spatialSplit;
+            }
+        }
+        std::vector<Reference> left;
+        std::vector<Reference> right;
+        if (split.type == SplitType::Spatial) {
+            performSpatialSplit(references, split, left, right);
+        }
+        if (left.empty() || right.empty()) {
+            // no spatial split, or one that did not separate anything
+            split = objectSplit;
+            left.clear();
+            right.clear();
+            performObjectSplit(references, split, left, right);
+        } else {
+            ++mResult.mStatistics.numSpatialSplits;
+        }
+        references = {};
+        mResult.mNodes[nodeIndex].axis = static_cast<std::uint32_t>(split.axis);
+        buildNode(std::move(left), split.left, depth + 1);
+        const auto secondChild = buildNode(std::move(right), split.right, depth + 1);
+        mResult.mNodes[nodeIndex].offset = secondChild;
+        return nodeIndex;
+    }
+
+    void makeLeaf(const std::uint32_t nodeIndex, const std::vector<Reference>& references) {
+        auto& node = mResult.mNodes[nodeIndex];
+        node.offset = static_cast<std::uint32_t>(mResult.mReferences.size());
+        node.count = static_cast<std::uint32_t>(references.size());
+        for (const auto& reference : references) {
+            mResult.mReferences.push_back(reference.objectIndex);
+        }
+        ++mResult.mStatistics.numLeaves;
+    }
+
+    // cost of a split according to the surface area heuristic
+    [[nodiscard]] static double splitCost(const double nodeArea,
+                                          const BoundingBox& left,
+                                          const std::size_t numLeft,
+                                          const BoundingBox& right,
+                                          const std::size_t numRight) {
+        return traversalCost + (left.surfaceArea() * static_cast<double>(numLeft) +
+                                right.surfaceArea() * static_cast<double>(numRight)) /
+                                       nodeArea;
+    }
+
+    // sorts by the centroids along the axis, ties are broken by the object index to make the result deterministic
+    static void sortByCentroid(std::vector<Reference>& references, const int axis) {
+        std::sort(references.begin(), references.end(), [axis](const Reference& lhs, const Reference& rhs) {
+            const auto lhsCentroid = BoundingBox::component(lhs.bounds.centroid(), axis);
+            const auto rhsCentroid = BoundingBox::component(rhs.bounds.centroid(), axis);
+            return lhsCentroid < rhsCentroid || (lhsCentroid == rhsCentroid && lhs.objectIndex < rhs.objectIndex);
+        });
+    }
+
+    // best partition of the references sorted along one of the axes, evaluated for every possible position
+    [[nodiscard]] static Split findObjectSplit(std::vector<Reference> references, const BoundingBox& bounds) {
+        const auto nodeArea = std::max(bounds.surfaceArea(), std::numeric_limits<double>::min());
+        Split result;
+        std::vector<BoundingBox> rightBounds(references.size());
+        for (int axis = 0; axis < 3; ++axis) {
+            sortByCentroid(references, axis);
+            auto accumulated = BoundingBox{};
+            for (auto i = references.size(); i-- > 1;) {
+                accumulated.extend(references[i].bounds);
+                rightBounds[i] = accumulated;
+            }
+            auto leftBounds = BoundingBox{};
+            for (std::size_t numLeft = 1; numLeft < references.size(); ++numLeft) {
+                leftBounds.extend(references[numLeft - 1].bounds);
+                const auto cost = splitCost(nodeArea, leftBounds, numLeft, rightBounds[numLeft],
+                                            references.size() - numLeft);
+                if (cost < result.cost) {
+                    result = Split{ .type{ SplitType::Object },
+                                    .cost{ cost },
+                                    .axis{ axis },
+                                    .numLeft{ numLeft },
+                                    .position{ 0.0 },
+                                    .left{ leftBounds },
+                                    .right{ rightBounds[numLeft] } };
+                }
+            }
+        }
+        return result;
+    }
+
+    void performObjectSplit(std::vector<Reference>& references,
+                            const Split& split,
+                            std::vector<Reference>& left,
+                            std::vector<Reference>& right) const {
+        sortByCentroid(references, split.axis);
+        const auto middle = references.begin() + static_cast<std::ptrdiff_t>(split.numLeft);
+        left.assign(references.begin(), middle);
+        right.assign(middle, references.end());
+    }
+
+    // the part of the box on one side of the plane
+    [[nodiscard]] static BoundingBox clipToSide(const BoundingBox& box,
+                                                const int axis,
+                                                const double position,
+                                                const bool lowerSide) {
+        auto result = box;
+        auto& limit = lowerSide ? result.max : result.min;
+        const auto current = BoundingBox::component(limit, axis);
+        limit = BoundingBox::withComponent(limit, axis,
+                                           lowerSide ? std::min(current, position) : std::max(current, position));
+        return result;
+    }
+
+    [[nodiscard]] BoundingBox clippedReference(const Reference& reference, const BoundingBox& clip) const {
+        const auto clippedBounds = reference.bounds.intersection(clip);
+        return mClippedBounds(reference.objectIndex, clippedBounds).value_or(clippedBounds);
+    }
+
+    // Bins the references along each axis, clipping them to every bin they overlap, and evaluates the planes
+    // between the bins.
+    [[nodiscard]] Split findSpatialSplit(const std::vector<Reference>& references, const BoundingBox& bounds) const {
+        const auto nodeArea = bounds.surfaceArea();
+        const auto numBins = static_cast<std::size_t>(std::max(mSettings.numSpatialBins, 2));
+        Split result;
+        std::vector<Bin> bins(numBins);
+        std::vector<BoundingBox> rightBounds(numBins);
+        std::vector<std::size_t> numRightReferences(numBins);
+        for (int axis = 0; axis < 3; ++axis) {
+            const auto origin = BoundingBox::component(bounds.min, axis);
+            const auto binWidth = (BoundingBox::component(bounds.max, axis) - origin) / static_cast<double>(numBins);
+            if (binWidth <= 0.0) {
+                continue;
+            }
+            const auto planePosition = [&](const std::size_t plane) {
+                return origin + binWidth * static_cast<double>(plane);
+            };
+            const auto binIndex = [&](const double position) {
+                const auto index = std::floor((position - origin) / binWidth);
+                return static_cast<std::size_t>(std::clamp(index, 0.0, static_cast<double>(numBins - 1)));
+            };
+            std::fill(bins.begin(), bins.end(), Bin{});
+            for (const auto& reference : references) {
+                const auto firstBin = binIndex(BoundingBox::component(reference.bounds.min, axis));
+                const auto lastBin = binIndex(BoundingBox::component(reference.bounds.max, axis));
+                for (auto bin = firstBin; bin <= lastBin; ++bin) {
+                    auto slab = everything;
+                    if (bin > 0) {
+                        slab = clipToSide(slab, axis, planePosition(bin), false);
+                    }
+                    if (bin + 1 < numBins) {
+                        slab = clipToSide(slab, axis, planePosition(bin + 1), true);
+                    }
+                    bins[bin].bounds.extend(clippedReference(reference, slab));
+                }
+                ++bins[firstBin].numEntries;
+                ++bins[lastBin].numExits;
+            }
+            auto accumulated = BoundingBox{};
+            std::size_t numExits = 0;
+            for (auto plane = numBins; plane-- > 1;) {
+                accumulated.extend(bins[plane].bounds);
+                numExits += bins[plane].numExits;
+                rightBounds[plane] = accumulated;
+                numRightReferences[plane] = numExits;
+            }
+            auto leftBounds = BoundingBox{};
+            std::size_t numEntries = 0;
+            for (std::size_t plane = 1; plane < numBins; ++plane) {
+                leftBounds.extend(bins[plane - 1].bounds);
+                numEntries += bins[plane - 1].numEntries;
+                const auto cost = splitCost(nodeArea, leftBounds, numEntries, rightBounds[plane],
+                                            numRightReferences[plane]);
+                if (cost < result.cost) {
+                    result = Split{ .type{ SplitType::Spatial },
+                                    .cost{ cost },
+                                    .axis{ axis },
+                                    .numLeft{ numEntries },
+                                    .position{ planePosition(plane) },
+                                    .left{ leftBounds },
+                                    .right{ rightBounds[plane] } };
+                }
+            }
+        }
+        return result;
+    }
+
+    // Distributes the references, those that straddle the plane are clipped into both children unless moving them
+    // to one side entirely is cheaper (reference unsplitting) or the duplication budget is used up. Updates the
+    // bounds of the split to the actual children.
+    void performSpatialSplit(const std::vector<Reference>& references,
+                             Split& split,
+                             std::vector<Reference>& left,
+                             std::vector<Reference>& right) {
+        auto leftBounds = BoundingBox{};
+        auto rightBounds = BoundingBox{};
+        std::vector<Reference> straddling;
+        for (const auto& reference : references) {
+            if (BoundingBox::component(reference.bounds.max, split.axis) <= split.position) {
+                left.push_back(reference);
+                leftBounds.extend(reference.bounds);
+            } else if (BoundingBox::component(reference.bounds.min, split.axis) >= split.position) {
+                right.push_back(reference);
+                rightBounds.extend(reference.bounds);
+            } else {
+                straddling.push_back(reference);
+            }
+        }
+        const auto leftSide = clipToSide(everything, split.axis, split.position, true);
+        const auto rightSide = clipToSide(everything, split.axis, split.position, false);
+        for (const auto& reference : straddling) {
+            const auto leftPart = clippedReference(reference, leftSide);
+            const auto rightPart = clippedReference(reference, rightSide);
+            auto withLeft = leftBounds;
+            withLeft.extend(reference.bounds);
+            auto withRight = rightBounds;
+            withRight.extend(reference.bounds);
+            auto splitLeft = leftBounds;
+            splitLeft.extend(leftPart);
+            auto splitRight = rightBounds;
+            splitRight.extend(rightPart);
+            const auto numLeft = static_cast<double>(left.size());
+            const auto numRight = static_cast<double>(right.size());
+            const auto duplicateCost = splitLeft.surfaceArea() * (numLeft + 1.0) +
+                                       splitRight.surfaceArea() * (numRight + 1.0);
+            const auto leftCost = withLeft.surfaceArea() * (numLeft + 1.0) + rightBounds.surfaceArea() * numRight;
+            const auto rightCost = leftBounds.surfaceArea() * numLeft + withRight.surfaceArea() * (numRight + 1.0);
+            const auto canDuplicate = mRemainingDuplicates > 0 && !leftPart.isEmpty() && !rightPart.isEmpty();
+            if (canDuplicate && duplicateCost < leftCost && duplicateCost < rightCost) {
+                left.push_back(Reference{ .bounds{ leftPart }, .objectIndex{ reference.objectIndex } });
+                right.push_back(Reference{ .bounds{ rightPart }, .objectIndex{ reference.objectIndex } });
+                leftBounds = splitLeft;
+                rightBounds = splitRight;
+                --mRemainingDuplicates;
+            } else if (leftCost <= rightCost) {
+                left.push_back(reference);
+                leftBounds = withLeft;
+            } else {
+                right.push_back(reference);
+                rightBounds = withRight;
+            }
+        }
+        split.left = leftBounds;
+        split.right = rightBounds;
+    }
+
+    std::size_t mNumObjects;
+    ClippedBounds mClippedBounds;
+    BvhSettings mSettings;
+    double mRootArea{ 0.0 };
+    std::size_t mRemainingDuplicates{ 0 };
+    Bvh mResult;
+};
+
+inline Bvh Bvh::build(const std::vector<std::unique_ptr<Hittable>>& objects, const BvhSettings& settings) {
+    const auto clippedBounds = [&objects](const std::size_t index, const BoundingBox& clip) {
+        return objects[index]->clippedBounds(clip);
+    };
+    return BvhBuilder{ objects.size(), clippedBounds, settings }.build();
+}
+
+inline Bvh Bvh::build(const std::vector<BoundingBox>& boxes, const BvhSettings& settings) {
+    const auto clippedBounds = [&boxes](const std::size_t index, const BoundingBox& clip) {
+        return std::optional{ boxes[index].intersection(clip) };
+    };
+    return BvhBuilder{ boxes.size(), clippedBounds, settings }.build();
+}
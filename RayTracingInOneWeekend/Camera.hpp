@@ -6,41 +6,86 @@
 
 #include "Ray.hpp"
 #include "Utility.hpp"
+#include "Sampler.hpp"
 #include <cmath>
 
+struct CameraSettings {
+    Point3 lookFrom{ 13.0, 2.0, 3.0 };
+    Point3 lookAt{ 0.0, 0.0, 0.0 };
+    Vec3 up{ 0.0, 1.0, 0.0 };
+    double verticalFOV{ 20.0 };
+    double aspectRatio{ 3.0 / 2.0 };//16.0 / 9.0;
+    double aperture{ 0.1 };
+    double focusDistance{ 10.0 };//(lookAt - lookFrom).length();
+};
+
 class Camera {
 public:
-    [[nodiscard]] static Ray getRay(const double s, const double t) {
-        const auto randomVecInsideRadiusSizedDisk = lensRadius * Random::randomInsideUnitDisk();
+    explicit Camera(const CameraSettings& settings = CameraSettings{})
+        : w{ (settings.lookFrom - settings.lookAt).normalized() },
+          u{ settings.up.cross(w).normalized() },
+          v{ w.cross(u) },
+          lensRadius{ settings.aperture / 2.0 },
+          origin{ settings.lookFrom } {
+        const auto halfVerticalHeight = std::tan(toRadians(settings.verticalFOV) / 2.0);
+        const auto viewportHeight = 2.0 * halfVerticalHeight;
+        const auto viewportWidth = settings.aspectRatio * viewportHeight;
+        horizontalDimension = settings.focusDistance * viewportWidth * u;
+        verticalDimension = settings.focusDistance * viewportHeight * v;
+        lowerLeftCorner = origin - horizontalDimension / 2 - verticalDimension / 2 - settings.focusDistance * w;
+    }
+
+    [[nodiscard]] Ray getRay(const double s, const double t, Sampler& sampler) const {
+        const auto rayStartPosition = lensPosition(Sampling::concentricDisk(sampler.get2D()));
+        return Ray{ rayStartPosition, pointOnFocusPlane(s, t) - rayStartPosition };
+    }
+
+    // The differential contains the rays through the same lens position that are ds/dt further along the image, with
+    // ds/dt being the distance between two samples on the image.
+    [[nodiscard]] Ray getRay(const double s,
+                             const double t,
+                             const double ds,
+                             const double dt,
+                             Sampler& sampler,
+                             RayDifferential& differential) const {
+        return getRay(s, t, ds, dt, Sampling::concentricDisk(sampler.get2D()), differential);
+    }
+
+    // same as above with the lens position already drawn, lensSample is a point on the unit disk
+    [[nodiscard]] Ray getRay(const double s,
+                             const double t,
+                             const double ds,
+                             const double dt,
+                             const Vec3& lensSample,
+                             RayDifferential& differential) const {
+        const auto rayStartPosition = lensPosition(lensSample);
+        differential = RayDifferential{
+            .originX{ rayStartPosition },
+            .directionX{ (pointOnFocusPlane(s + ds, t) - rayStartPosition).normalized() },
+            .originY{ rayStartPosition },
+            .directionY{ (pointOnFocusPlane(s, t + dt) - rayStartPosition).normalized() },
+        };
+        return Ray{ rayStartPosition, pointOnFocusPlane(s, t) - rayStartPosition };
+    }
+
+private:
+    [[nodiscard]] Point3 lensPosition(const Vec3& lensSample) const {
+        const auto randomVecInsideRadiusSizedDisk = lensRadius * lensSample;
         const auto offset = u * randomVecInsideRadiusSizedDisk.x + v * randomVecInsideRadiusSizedDisk.y;
-        const auto rayStartPosition = origin + offset;
-        return Ray{ rayStartPosition,
-                    lowerLeftCorner + s * horizontalDimension + t * verticalDimension - rayStartPosition };
+        return origin + offset;
     }
 
-public:
-    static constexpr auto verticalFOV = 20.0;
-    static constexpr auto aspectRatio = 3.0 / 2.0; //16.0 / 9.0;
+    [[nodiscard]] Point3 pointOnFocusPlane(const double s, const double t) const {
+        return lowerLeftCorner + s * horizontalDimension + t * verticalDimension;
+    }
 
 private:
-    static constexpr auto theta = toRadians(verticalFOV);
-    static inline const auto halfVerticalHeight = std::tan(theta / 2.0);
-    static constexpr auto lookFrom = Vec3{ 13.0, 2.0, 3.0 };
-    static constexpr auto lookAt = Vec3{ 0.0, 0.0, 0.0 };
-    static constexpr auto up = Vec3{ 0.0, 1.0, 0.0 };
-    static inline const auto w = (lookFrom - lookAt).normalized();
-    static inline const auto u = up.cross(w).normalized();
-    static inline const auto v = w.cross(u);
-
-    static constexpr auto aperture = 0.1;
-    static constexpr auto lensRadius = aperture / 2.0;
-    static inline const auto focusDistance = 10.0;//(lookAt - lookFrom).length();
-
-    static inline const auto viewportHeight = 2.0 * halfVerticalHeight;
-    static inline const auto viewportWidth = aspectRatio * viewportHeight;
-    static inline const auto origin = lookFrom;
-    static inline const auto horizontalDimension = focusDistance * viewportWidth * u;
-    static inline const auto verticalDimension = focusDistance * viewportHeight * v;
-    static inline const auto lowerLeftCorner =
-            origin - horizontalDimension / 2 - verticalDimension / 2 - focusDistance * w;
-};
\ No newline at end of file
+    Vec3 w;
+    Vec3 u;
+    Vec3 v;
+    double lensRadius;
+    Point3 origin;
+    Vec3 horizontalDimension;
+    Vec3 verticalDimension;
+    Point3 lowerLeftCorner;
+};
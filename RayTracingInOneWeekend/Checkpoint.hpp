@@ -0,0 +1,162 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "MappedFile.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+// Render progress stored in a memory-mapped file: the float accumulation buffers and the per-pixel sample counts.
+// Nothing else is needed to continue, since the random numbers of every (pixel, sample) pair only depend on the pair
+// itself. The file contains two slots that are written alternately. A slot only becomes active after it has been
+// flushed completely, so a crash while saving never destroys the previous checkpoint.
+// The header contains a fingerprint of everything that determines the image (see renderFingerprint() in main.cpp),
+// so that the samples of a different render are never added to the restored ones.
+class Checkpoint {
+public:
+    [[nodiscard]] static std::optional<Checkpoint> create(const std::string& path,
+                                                          const int width,
+                                                          const int height,
+                                                          const std::uint32_t samplesPerPixel,
+                                                          const std::uint64_t fingerprint) {
+        const auto numPixels = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        auto file = MappedFile::create(path, fileSize(numPixels));
+        if (!file) {
+            return {};
+        }
+        const auto header = Header{ .magic{ fileMagic },
+                                    .version{ fileVersion },
+                                    .width{ static_cast<std::uint32_t>(width) },
+                                    .height{ static_cast<std::uint32_t>(height) },
+                                    .samplesPerPixel{ samplesPerPixel },
+                                    .activeSlot{ noActiveSlot },
+                                    .fingerprint{ fingerprint } };
+        std::memcpy(file->data().data(), &header, sizeof(header));
+        file->flush(0, sizeof(header));
+        return Checkpoint{ std::move(*file), header };
+    }
+
+    // opens an existing checkpoint, fails if the file is no valid checkpoint or has never been saved
+    [[nodiscard]] static std::optional<Checkpoint> open(const std::string& path) {
+        auto file = MappedFile::open(path);
+        if (!file || file->size() < sizeof(Header)) {
+            return {};
+        }
+        Header header;
+        std::memcpy(&header, file->data().data(), sizeof(header));
+        const auto numPixels = static_cast<std::size_t>(header.width) * static_cast<std::size_t>(header.height);
+        if (header.magic != fileMagic || header.version != fileVersion || file->size() != fileSize(numPixels) ||
+            header.activeSlot == noActiveSlot || header.activeSlot > 2) {
+            return {};
+        }
+        return Checkpoint{ std::move(*file), header };
+    }
+
+    [[nodiscard]] int width() const {
+        return static_cast<int>(mHeader.width);
+    }
+
+    [[nodiscard]] int height() const {
+        return static_cast<int>(mHeader.height);
+    }
+
+    [[nodiscard]] std::uint32_t samplesPerPixel() const {
+        return mHeader.samplesPerPixel;
+    }
+
+    [[nodiscard]] std::uint64_t fingerprint() const {
+        return mHeader.fingerprint;
+    }
+
+    bool save(const FrameBuffer& frameBuffer) {
+        assert(frameBuffer.width == width() && frameBuffer.height == height());
+        const auto targetSlot = (mHeader.activeSlot == 1 ? 2U : 1U);
+        auto* const slot = mFile.data().data() + slotOffset(targetSlot);
+
+        for (std::size_t i = 0; i < frameBuffer.numPixels(); ++i) {
+            const auto& color = frameBuffer.color[i];
+            const auto& albedo = frameBuffer.albedo[i];
+            const auto& normal = frameBuffer.normal[i];
+            const auto record = PixelRecord{
+                .values{ static_cast<float>(color.r), static_cast<float>(color.g), static_cast<float>(color.b),
+                         static_cast<float>(albedo.r), static_cast<float>(albedo.g), static_cast<float>(albedo.b),
+                         static_cast<float>(normal.x), static_cast<float>(normal.y), static_cast<float>(normal.z),
+                         static_cast<float>(frameBuffer.depth[i]) },
+                .sampleCount{ frameBuffer.sampleCount[i] }
+            };
+            std::memcpy(slot + i * sizeof(PixelRecord), &record, sizeof(record));
+        }
+        if (!mFile.flush(slotOffset(targetSlot), slotSize(frameBuffer.numPixels()))) {
+            return false;
+        }
+
+        // switching the active slot is a single aligned 4 byte write
+        mHeader.activeSlot = targetSlot;
+        std::memcpy(mFile.data().data(), &mHeader, sizeof(mHeader));
+        return mFile.flush(0, sizeof(mHeader));
+    }
+
+    void restore(FrameBuffer& frameBuffer) const {
+        assert(frameBuffer.width == width() && frameBuffer.height == height());
+        const auto* const slot = mFile.data().data() + slotOffset(mHeader.activeSlot);
+        for (std::size_t i = 0; i < frameBuffer.numPixels(); ++i) {
+            PixelRecord record;
+            std::memcpy(&record, slot + i * sizeof(PixelRecord), sizeof(record));
+            const auto& values = record.values;
+            frameBuffer.color[i] = Color{ values[0], values[1], values[2] };
+            frameBuffer.albedo[i] = Color{ values[3], values[4], values[5] };
+            frameBuffer.normal[i] = Vec3{ values[6], values[7], values[8] };
+            frameBuffer.depth[i] = values[9];
+            frameBuffer.sampleCount[i] = record.sampleCount;
+        }
+    }
+
+private:
+    static constexpr std::array<char, 8> fileMagic{ 'R', 'T', 'C', 'H', 'E', 'C', 'K', '\0' };
+    static constexpr std::uint32_t fileVersion = 3;
+    static constexpr std::uint32_t noActiveSlot = 0;
+
+    struct Header {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t samplesPerPixel;
+        std::uint32_t activeSlot;// 1 or 2, noActiveSlot before the first save
+        std::uint32_t padding{ 0 };
+        std::uint64_t fingerprint;
+    };
+
+    struct PixelRecord {
+        std::array<float, 10> values;// color, albedo, normal, depth
+        std::uint32_t sampleCount;
+    };
+
+    Checkpoint(MappedFile file, const Header& header) : mFile{ std::move(file) }, mHeader{ header } { }
+
+    [[nodiscard]] static std::size_t slotSize(const std::size_t numPixels) {
+        return numPixels * sizeof(PixelRecord);
+    }
+
+    [[nodiscard]] static std::size_t fileSize(const std::size_t numPixels) {
+        return sizeof(Header) + 2 * slotSize(numPixels);
+    }
+
+    [[nodiscard]] std::size_t slotOffset(const std::uint32_t slot) const {
+        assert(slot == 1 || slot == 2);
+        const auto numPixels = static_cast<std::size_t>(mHeader.width) * static_cast<std::size_t>(mHeader.height);
+        return sizeof(Header) + (slot - 1) * slotSize(numPixels);
+    }
+
+private:
+    MappedFile mFile;
+    Header mHeader;
+};
@@ -0,0 +1,512 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "BoundingBox.hpp"
+#include "Bvh.hpp"
+#include "Hittable.hpp"
+#include "MappedFile.hpp"
+#include "Scene.hpp"
+#include "Sphere.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Out-of-core geometry for scenes whose spheres do not fit into memory. The spheres are stored in a file in chunks of
+// nearby spheres, each of which can be memory-mapped on its own. Only the small table of chunk bounds is kept in
+// memory, a BVH over them finds the chunks a ray passes through. The chunks are mapped when they are needed and
+// unmapped again by a clock cache as soon as the mapped chunks exceed the memory budget.
+//
+// File layout: FileHeader, the MaterialDescriptions, the ChunkRecords and the SphereDescriptions of every chunk,
+// starting at offsets that are multiples of MappedFile::allocationGranularity.
+namespace ChunkedGeometry {
+    inline constexpr std::array<char, 8> fileMagic{ 'R', 'T', 'G', 'E', 'O', 'M', '\0', '\0' };
+    inline constexpr std::uint32_t fileVersion = 1;
+    inline constexpr std::size_t defaultSpheresPerChunk = 1024;
+
+    struct FileHeader {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t numMaterials;
+        std::uint64_t numChunks;
+        std::uint64_t numSpheres;
+    };
+
+    struct ChunkRecord {
+        BoundingBox bounds;
+        std::uint64_t offset;
+        std::uint64_t numSpheres;
+
+        [[nodiscard]] std::size_t sizeInBytes() const {
+            return static_cast<std::size_t>(numSpheres) * sizeof(SphereDescription);
+        }
+    };
+}// namespace ChunkedGeometry
+
+namespace ChunkedGeometryDetail {
+    [[nodiscard]] inline std::uint64_t alignOffset(const std::uint64_t offset) {
+        constexpr auto alignment = MappedFile::allocationGranularity;
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Splits the spheres at the median of their centers along the axis in which the centers are spread the most,
+    // until every part fits into a chunk. This keeps nearby spheres in the same chunk and the bounds of the chunks
+    // small.
+    inline void partition(const std::span<SphereDescription> spheres,
+                          const std::size_t spheresPerChunk,
+                          std::vector<std::span<const SphereDescription>>& chunks) {
+        if (spheres.size() <= spheresPerChunk) {
+            chunks.emplace_back(spheres);
+            return;
+        }
+        BoundingBox centers;
+        for (const auto& sphere : spheres) {
+            centers.extend(sphere.center);
+        }
+        const auto axis = centers.longestAxis();
+        const auto half = spheres.size() / 2;
+        std::nth_element(spheres.begin(), spheres.begin() + static_cast<std::ptrdiff_t>(half), spheres.end(),
+                         [axis](const SphereDescription& lhs, const SphereDescription& rhs) {
+                             return BoundingBox::component(lhs.center, axis) <
+                                    BoundingBox::component(rhs.center, axis);
+                         });
+        partition(spheres.first(half), spheresPerChunk, chunks);
+        partition(spheres.subspan(half), spheresPerChunk, chunks);
+    }
+}// namespace ChunkedGeometryDetail
+
+namespace ChunkedGeometry {
+    // writes the materials and spheres of the scene, textures and the environment are not part of a geometry file
+    [[nodiscard]] inline bool write(const std::string& path, const Scene& scene, const std::size_t spheresPerChunk) {
+        if (scene.spheres.empty() || spheresPerChunk == 0) {
+            std::cerr << "A geometry file needs at least one sphere and chunk\n";
+            return false;
+        }
+        if (std::any_of(scene.materials.cbegin(), scene.materials.cend(), [](const MaterialDescription& material) {
+                return material.textureIndex != MaterialDescription::noTexture;
+            })) {
+            std::cerr << "Textured materials cannot be written into a geometry file\n";
+            return false;
+        }
+        auto spheres = scene.spheres;
+        std::vector<std::span<const SphereDescription>> chunkSpheres;
+        ChunkedGeometryDetail::partition(spheres, spheresPerChunk, chunkSpheres);
+
+        const auto metadataSize = sizeof(FileHeader) + scene.materials.size() * sizeof(MaterialDescription) +
+                                  chunkSpheres.size() * sizeof(ChunkRecord);
+        std::vector<ChunkRecord> chunks;
+        auto fileSize = static_cast<std::uint64_t>(metadataSize);
+        for (const auto& part : chunkSpheres) {
+            BoundingBox bounds;
+            for (const auto& sphere : part) {
+                bounds.extend(BoundingBox::ofSphere(sphere.center, sphere.radius));
+            }
+            const auto offset = ChunkedGeometryDetail::alignOffset(fileSize);
+            chunks.push_back(ChunkRecord{ .bounds{ bounds }, .offset{ offset }, .numSpheres{ part.size() } });
+            fileSize = offset + chunks.back().sizeInBytes();
+        }
+
+        auto file = MappedFile::create(path, static_cast<std::size_t>(fileSize));
+        if (!file) {
+            std::cerr << std::format("Unable to create geometry file {}\n", path);
+            return false;
+        }
+        auto* const data = file->data().data();
+        const auto header = FileHeader{ .magic{ fileMagic },
+                                        .version{ fileVersion },
+                                        .numMaterials{ static_cast<std::uint32_t>(scene.materials.size()) },
+                                        .numChunks{ chunks.size() },
+                                        .numSpheres{ spheres.size() } };
+        std::memcpy(data, &header, sizeof(header));
+        auto offset = sizeof(header);
+        std::memcpy(data + offset, scene.materials.data(), scene.materials.size() * sizeof(MaterialDescription));
+        offset += scene.materials.size() * sizeof(MaterialDescription);
+        std::memcpy(data + offset, chunks.data(), chunks.size() * sizeof(ChunkRecord));
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            std::memcpy(data + chunks[i].offset, chunkSpheres[i].data(), chunks[i].sizeInBytes());
+        }
+        if (!file->flush(0, file->size())) {
+            std::cerr << std::format("Unable to write geometry file {}\n", path);
+            return false;
+        }
+        std::cout << std::format("Wrote {} spheres in {} chunks to {}\n", spheres.size(), chunks.size(), path);
+        return true;
+    }
+
+    // the part of a geometry file that stays in memory
+    struct GeometryFile {
+        std::string path;
+        std::vector<MaterialDescription> materials;
+        std::vector<ChunkRecord> chunks;
+        std::uint64_t numSpheres;
+
+        // reads and validates everything but the spheres
+        [[nodiscard]] static std::optional<GeometryFile> load(const std::string& path) {
+            std::error_code error;
+            const auto fileSize = std::filesystem::file_size(path, error);
+            std::ifstream file{ path, std::ios::binary };
+            FileHeader header;
+            if (error || !file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+                header.magic != fileMagic || header.version != fileVersion || header.numMaterials == 0 ||
+                header.numChunks == 0 ||
+                header.numMaterials > (fileSize - sizeof(header)) / sizeof(MaterialDescription) ||
+                header.numChunks > (fileSize - sizeof(header)) / sizeof(ChunkRecord)) {
+                return {};
+            }
+            GeometryFile result{ .path{ path }, .materials{}, .chunks{}, .numSpheres{ header.numSpheres } };
+            result.materials.resize(header.numMaterials);
+            result.chunks.resize(static_cast<std::size_t>(header.numChunks));
+            if (!file.read(reinterpret_cast<char*>(result.materials.data()),
+                           static_cast<std::streamsize>(result.materials.size() * sizeof(MaterialDescription))) ||
+                !file.read(reinterpret_cast<char*>(result.chunks.data()),
+                           static_cast<std::streamsize>(result.chunks.size() * sizeof(ChunkRecord)))) {
+                return {};
+            }
+            if (!std::all_of(result.materials.cbegin(), result.materials.cend(), [](const MaterialDescription& m) {
+                    return m.type <= MaterialType::Dielectric && m.textureIndex == MaterialDescription::noTexture;
+                })) {
+                return {};
+            }
+            std::uint64_t totalSpheres = 0;
+            for (const auto& chunk : result.chunks) {
+                if (chunk.numSpheres == 0 || chunk.offset % MappedFile::allocationGranularity != 0 ||
+                    chunk.offset < static_cast<std::uint64_t>(file.tellg()) || chunk.offset > fileSize ||
+                    chunk.numSpheres > (fileSize - chunk.offset) / sizeof(SphereDescription)) {
+                    return {};
+                }
+                totalSpheres += chunk.numSpheres;
+            }
+            if (totalSpheres != header.numSpheres) {
+                return {};
+            }
+            return result;
+        }
+    };
+
+    // Keeps the recently used chunks mapped while the sum of their sizes stays within the memory budget. It is shared
+    // by all render threads (and all replicas of the world). Pinning a chunk that is already mapped only touches the
+    // atomics of the chunk, the mutex is only taken to map a chunk and to evict others for it. Eviction follows the
+    // clock algorithm, an approximation of least recently used that only needs a flag per chunk.
+    class ChunkCache {
+    public:
+        struct Statistics {
+            std::uint64_t loads;
+            std::uint64_t evictions;
+            std::uint64_t failures;
+            std::size_t peakResidentBytes;
+        };
+
+        // keeps a chunk mapped as long as it exists
+        class Pin {
+        public:
+            Pin() = default;
+            Pin(const Pin&) = delete;
+            Pin(Pin&& other) noexcept
+                : mPins{ std::exchange(other.mPins, nullptr) },
+                  mMapping{ std::exchange(other.mMapping, nullptr) } { }
+            Pin& operator=(const Pin&) = delete;
+            Pin& operator=(Pin&& other) noexcept {
+                std::swap(mPins, other.mPins);
+                std::swap(mMapping, other.mMapping);
+                return *this;
+            }
+            ~Pin() {
+                if (mPins != nullptr) {
+                    mPins->fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            [[nodiscard]] explicit operator bool() const {
+                return mMapping != nullptr;
+            }
+
+            [[nodiscard]] std::span<const std::byte> data() const {
+                return mMapping->data();
+            }
+
+        private:
+            friend class ChunkCache;
+
+            Pin(std::atomic<std::uint32_t>& pins, const MappedFile& mapping) : mPins{ &pins }, mMapping{ &mapping } { }
+
+            std::atomic<std::uint32_t>* mPins{ nullptr };
+            const MappedFile* mMapping{ nullptr };
+        };
+
+        ChunkCache(GeometryFile file, const std::size_t memoryBudget)
+            : mFile{ std::move(file) },
+              mMemoryBudget{ memoryBudget },
+              mEntries(mFile.chunks.size()) { }
+
+        [[nodiscard]] const GeometryFile& file() const {
+            return mFile;
+        }
+
+        // Pins the chunk, maps it first if it is not resident. Returns an empty pin if the chunk cannot be mapped at
+        // all, which leaves its spheres out of the image instead of failing the render.
+        [[nodiscard]] Pin acquire(const std::size_t chunkIndex) {
+            auto& entry = mEntries[chunkIndex];
+            // The chunk is pinned before its mapping is read, and evict() unpublishes the mapping before it reads the
+            // pins (all sequentially consistent). So either the mapping is seen here and not unmapped, or evict()
+            // sees the pin and keeps the mapping.
+            entry.pins.fetch_add(1);
+            if (const auto* const mapping = entry.mapping.load()) {
+                // reading first keeps the cache line shared between the threads that use the chunk
+                if (!entry.recentlyUsed.load(std::memory_order_relaxed)) {
+                    entry.recentlyUsed.store(true, std::memory_order_relaxed);
+                }
+                return Pin{ entry.pins, *mapping };
+            }
+            entry.pins.fetch_sub(1);
+            return load(chunkIndex);
+        }
+
+        [[nodiscard]] Statistics statistics() const {
+            const auto lock = std::scoped_lock{ mMutex };
+            return mStatistics;
+        }
+
+    private:
+        [[nodiscard]] Pin load(const std::size_t chunkIndex) {
+            const auto lock = std::scoped_lock{ mMutex };
+            auto& entry = mEntries[chunkIndex];
+            // only evict() unmaps chunks, and it cannot run while the mutex is held
+            entry.pins.fetch_add(1);
+            entry.recentlyUsed.store(true, std::memory_order_relaxed);
+            if (entry.resident) {
+                // another thread has mapped the chunk in the meantime
+                return Pin{ entry.pins, *entry.resident };
+            }
+            const auto& chunk = mFile.chunks[chunkIndex];
+            const auto size = chunk.sizeInBytes();
+            evict(mMemoryBudget - std::min(mMemoryBudget, size));
+            auto mapping = MappedFile::openReadOnly(mFile.path, chunk.offset, size);
+            if (!mapping) {
+                // possibly out of address space or mappings, retry with as few chunks mapped as possible
+                evict(0);
+                mapping = MappedFile::openReadOnly(mFile.path, chunk.offset, size);
+            }
+            if (!mapping) {
+                entry.pins.fetch_sub(1);
+                if (mStatistics.failures++ == 0) {
+                    std::cerr << std::format("Unable to map chunk {} of {}, its spheres are left out\n", chunkIndex,
+                                             mFile.path);
+                }
+                return {};
+            }
+            ++mStatistics.loads;
+            entry.resident = std::make_unique<const MappedFile>(std::move(*mapping));
+            entry.mapping.store(entry.resident.get());
+            mResidentBytes += size;
+            mStatistics.peakResidentBytes = std::max(mStatistics.peakResidentBytes, mResidentBytes);
+            return Pin{ entry.pins, *entry.resident };
+        }
+
+        // Unmaps chunks that have not been used since the clock hand passed them the last time, until at most
+        // maxResidentBytes are mapped. Pinned chunks cannot be unmapped, if they don't fit, the budget is exceeded
+        // until they are released. Must be called with the mutex held.
+        void evict(const std::size_t maxResidentBytes) {
+            // after one round all flags have been cleared, so two rounds visit every chunk that can be unmapped
+            for (std::size_t step = 0; step < 2 * mEntries.size() && mResidentBytes > maxResidentBytes; ++step) {
+                auto& entry = mEntries[mClockHand];
+                mClockHand = (mClockHand + 1) % mEntries.size();
+                if (!entry.resident || entry.recentlyUsed.exchange(false, std::memory_order_relaxed)) {
+                    continue;
+                }
+                entry.mapping.store(nullptr);
+                if (entry.pins.load() > 0) {
+                    entry.mapping.store(entry.resident.get());
+                    continue;
+                }
+                mResidentBytes -= entry.resident->size();
+                entry.resident.reset();
+                ++mStatistics.evictions;
+            }
+        }
+
+    private:
+        // one cache line per chunk, so that pinning different chunks does not contend
+        struct alignas(cacheLineSize) Entry {
+            std::atomic<std::uint32_t> pins{ 0 };
+            // the published mapping, nullptr while the chunk is not resident or being evicted
+            std::atomic<const MappedFile*> mapping{ nullptr };
+            std::atomic<bool> recentlyUsed{ false };
+            // owns the mapping, only accessed with the mutex held
+            std::unique_ptr<const MappedFile> resident;
+        };
+
+        GeometryFile mFile;
+        std::size_t mMemoryBudget;
+        mutable std::mutex mMutex;
+        std::vector<Entry> mEntries;
+        std::size_t mClockHand{ 0 };
+        std::size_t mResidentBytes{ 0 };
+        Statistics mStatistics{};
+    };
+
+    // All spheres of a geometry file as a single object of the world. A hierarchy over the bounds of the chunks
+    // finds the chunks that a ray passes through front to back, and the spheres of a chunk are only read if the ray
+    // enters its bounds before the closest hit found so far.
+    class StreamedSpheres final : public Hittable {
+    public:
+        explicit StreamedSpheres(std::shared_ptr<ChunkCache> cache)
+            : mCache{ std::move(cache) },
+              mChunkBvh{ buildChunkBvh(mCache->file()) } {
+            const std::vector<std::shared_ptr<const Texture>> noTextures;
+            for (const auto& material : mCache->file().materials) {
+                mMaterials.push_back(Scene::buildMaterial(material, noTextures));
+            }
+        }
+
+        [[nodiscard]] std::optional<double> hit(const Ray& ray, const double tMin, const double tMax) const override {
+            const auto result = closestSphere(ray, tMin, tMax);
+            if (!result) {
+                return {};
+            }
+            // the sphere is kept for getIntersectionInfo(), which is called for the closest hit right after it has
+            // been found
+            lastHit = LastHit{ .owner{ this },
+                               .origin{ ray.origin },
+                               .direction{ ray.direction },
+                               .hit{ *result } };
+            return result->t;
+        }
+
+        [[nodiscard]] IntersectionInfo getIntersectionInfo(const Ray& ray, const double t) const override {
+            auto sphere = std::optional<SphereDescription>{};
+            if (lastHit.owner == this && lastHit.hit.t == t && lastHit.origin == ray.origin &&
+                lastHit.direction == ray.direction) {
+                sphere = lastHit.hit.sphere;
+            } else if (const auto result = closestSphere(ray, t * (1.0 - intersectionTolerance),
+                                                         t * (1.0 + intersectionTolerance))) {
+                sphere = result->sphere;
+            } else {
+                // the chunk of the sphere could not be mapped again, the sphere of the last hit is the best guess
+                assert(lastHit.owner == this);
+                sphere = lastHit.hit.sphere;
+            }
+            const auto& material = mMaterials[sphere->materialIndex];
+            return Sphere{ sphere->center, sphere->radius, material }.getIntersectionInfo(ray, t);
+        }
+
+        [[nodiscard]] std::optional<BoundingBox> clippedBounds(const BoundingBox& clip) const override {
+            auto result = BoundingBox{};
+            for (const auto& chunk : mCache->file().chunks) {
+                if (const auto clipped = chunk.bounds.intersection(clip); !clipped.isEmpty()) {
+                    result.extend(clipped);
+                }
+            }
+            return result;
+        }
+
+        // every type of material that occurs in the geometry file
+        [[nodiscard]] std::vector<MaterialType> materialTypes() const {
+            std::vector<MaterialType> result;
+            for (const auto& material : mCache->file().materials) {
+                if (std::find(result.cbegin(), result.cend(), material.type) == result.cend()) {
+                    result.push_back(material.type);
+                }
+            }
+            return result;
+        }
+
+    private:
+        struct SphereHit {
+            double t;
+            SphereDescription sphere;
+        };
+
+        // relative distance within which getIntersectionInfo() looks for the sphere again if it was not the last hit
+        static constexpr double intersectionTolerance = 1.0e-9;
+
+        [[nodiscard]] static Bvh buildChunkBvh(const GeometryFile& file) {
+            std::vector<BoundingBox> bounds;
+            bounds.reserve(file.chunks.size());
+            for (const auto& chunk : file.chunks) {
+                bounds.push_back(chunk.bounds);
+            }
+            // one chunk per leaf, so that a chunk is only pinned if the ray enters its own bounds
+            return Bvh::build(bounds, BvhSettings{ .type{ BvhType::ObjectSplits }, .maxLeafSize{ 1 } });
+        }
+
+        [[nodiscard]] std::optional<SphereHit> closestSphere(const Ray& ray, const double tMin, double tMax) const {
+            const auto& chunks = mCache->file().chunks;
+            const auto numMaterials = mMaterials.size();
+            // the Hittable interface does not pass the statistics of the render thread
+            thread_local RenderStatistics ignoredStatistics;
+            std::optional<SphereHit> result;
+            mChunkBvh.visitLeaves(ray, tMin, [&tMax]() { return tMax; }, ignoredStatistics,
+                                  [&](const std::span<const std::uint32_t> chunkIndices) {
+                                      for (const auto chunkIndex : chunkIndices) {
+                                          const auto pin = mCache->acquire(chunkIndex);
+                                          if (!pin) {
+                                              continue;
+                                          }
+                                          const auto* const data = pin.data().data();
+                                          for (std::size_t i = 0; i < chunks[chunkIndex].numSpheres; ++i) {
+                                              SphereDescription sphere;
+                                              std::memcpy(&sphere, data + i * sizeof(SphereDescription),
+                                                          sizeof(sphere));
+                                              // the spheres are not validated when they are loaded, skip corrupted
+                                              // ones
+                                              if (sphere.materialIndex >= numMaterials) {
+                                                  continue;
+                                              }
+                                              if (const auto t = Sphere::intersect(sphere.center, sphere.radius, ray,
+                                                                                   tMin, tMax)) {
+                                                  tMax = *t;
+                                                  result = SphereHit{ .t{ *t }, .sphere{ sphere } };
+                                              }
+                                          }
+                                      }
+                                      return false;
+                                  });
+            return result;
+        }
+
+    private:
+        struct LastHit {
+            const StreamedSpheres* owner;
+            Point3 origin;
+            Vec3 direction;
+            SphereHit hit;
+        };
+
+        static inline thread_local LastHit lastHit{};
+
+        std::shared_ptr<ChunkCache> mCache;
+        Bvh mChunkBvh;
+        std::vector<std::shared_ptr<Material>> mMaterials;
+    };
+
+    // adds the spheres of the geometry file to the world
+    inline void addToWorld(World& world, const std::shared_ptr<ChunkCache>& cache) {
+        auto spheres = std::make_unique<StreamedSpheres>(cache);
+        for (const auto type : spheres->materialTypes()) {
+            if (std::find(world.materialTypes.cbegin(), world.materialTypes.cend(), type) ==
+                world.materialTypes.cend()) {
+                world.materialTypes.push_back(type);
+            }
+        }
+        world.objects.push_back(std::move(spheres));
+    }
+}// namespace ChunkedGeometry
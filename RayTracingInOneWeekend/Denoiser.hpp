@@ -0,0 +1,244 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+struct DenoiserSettings {
+    int numIterations{ 5 };
+    float colorSigma{ 0.6f };// halved after every iteration
+    float normalSigma{ 0.3f };
+    float albedoSigma{ 0.1f };
+    float depthSigma{ 0.05f };// relative to the depth of the center pixel
+};
+
+// Edge-avoiding a-trous wavelet filter, see Dammertz et al.: "Edge-Avoiding A-Trous Wavelet Transform for fast
+// Global Illumination Filtering" (2010). The 5x5 B3 spline kernel is widened by inserting holes (1, 2, 4, ... pixels)
+// in every iteration, the edge-stopping function uses the color, albedo, normal and depth of both pixels.
+// All buffers are stored as separate float planes so that the inner loop over a row runs on contiguous memory and
+// can be vectorized, the rows are distributed over multiple threads.
+class Denoiser {
+public:
+    // distance in pixels up to which the neighbors of a pixel influence its filtered value
+    [[nodiscard]] static int footprintRadius(const DenoiserSettings& settings) {
+        // 2 * (1 + 2 + 4 + ...) since the taps of the iterations are 2 * step pixels apart
+        return 2 * ((1 << settings.numIterations) - 1);
+    }
+
+    [[nodiscard]] static std::vector<Color> denoise(const FrameBuffer& frameBuffer,
+                                                    const DenoiserSettings& settings,
+                                                    const unsigned int numThreads) {
+        const auto numPixels = frameBuffer.numPixels();
+        Planes guide{ numPixels };
+        Planes current{ numPixels };
+        Planes next{ numPixels };
+        for (std::size_t i = 0; i < numPixels; ++i) {
+            current.set(i, frameBuffer.color[i]);
+            guide.set(i, frameBuffer.albedo[i]);
+        }
+        std::vector<float> normalX(numPixels);
+        std::vector<float> normalY(numPixels);
+        std::vector<float> normalZ(numPixels);
+        std::vector<float> depth(numPixels);
+        for (std::size_t i = 0; i < numPixels; ++i) {
+            normalX[i] = static_cast<float>(frameBuffer.normal[i].x);
+            normalY[i] = static_cast<float>(frameBuffer.normal[i].y);
+            normalZ[i] = static_cast<float>(frameBuffer.normal[i].z);
+            depth[i] = static_cast<float>(frameBuffer.depth[i]);
+        }
+
+        auto colorSigma = settings.colorSigma;
+        for (int iteration = 0; iteration < settings.numIterations; ++iteration) {
+            const auto pass = Pass{ .width{ frameBuffer.width },
+                                    .height{ frameBuffer.height },
+                                    .step{ 1 << iteration },
+                                    .inverseColorVariance{ 1.0f / (colorSigma * colorSigma) },
+                                    .inverseNormalVariance{ 1.0f / (settings.normalSigma * settings.normalSigma) },
+                                    .inverseAlbedoVariance{ 1.0f / (settings.albedoSigma * settings.albedoSigma) },
+                                    .inverseDepthVariance{ 1.0f / (settings.depthSigma * settings.depthSigma) },
+                                    .input{ &current },
+                                    .output{ &next },
+                                    .albedo{ &guide },
+                                    .normalX{ normalX.data() },
+                                    .normalY{ normalY.data() },
+                                    .normalZ{ normalZ.data() },
+                                    .depth{ depth.data() } };
+            const auto numWorkers = std::max(1U, std::min(numThreads, static_cast<unsigned int>(pass.height)));
+            const auto rowsPerWorker = (pass.height + static_cast<int>(numWorkers) - 1) / static_cast<int>(numWorkers);
+            {
+                std::vector<std::jthread> workers;
+                for (int startRow = 0; startRow < pass.height; startRow += rowsPerWorker) {
+                    workers.emplace_back([&pass, startRow, endRow = std::min(startRow + rowsPerWorker, pass.height)]() {
+                        filterRows(pass, startRow, endRow);
+                    });
+                }
+            }
+            std::swap(current, next);
+            colorSigma *= 0.5f;
+        }
+
+        std::vector<Color> result(numPixels);
+        for (std::size_t i = 0; i < numPixels; ++i) {
+            result[i] = current.get(i);
+        }
+        return result;
+    }
+
+private:
+    struct Planes {
+        explicit Planes(const std::size_t numPixels) : r(numPixels), g(numPixels), b(numPixels) { }
+
+        void set(const std::size_t index, const Color& color) {
+            r[index] = static_cast<float>(color.r);
+            g[index] = static_cast<float>(color.g);
+            b[index] = static_cast<float>(color.b);
+        }
+
+        [[nodiscard]] Color get(const std::size_t index) const {
+            return Color{ static_cast<double>(r[index]), static_cast<double>(g[index]), static_cast<double>(b[index]) };
+        }
+
+        std::vector<float> r;
+        std::vector<float> g;
+        std::vector<float> b;
+    };
+
+    struct Pass {
+        int width;
+        int height;
+        int step;
+        float inverseColorVariance;
+        float inverseNormalVariance;
+        float inverseAlbedoVariance;
+        float inverseDepthVariance;
+        const Planes* input;
+        Planes* output;
+        const Planes* albedo;
+        const float* normalX;
+        const float* normalY;
+        const float* normalZ;
+        const float* depth;
+    };
+
+    static constexpr std::array<float, 5> kernel{ 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+    // (1 - x/16)^16 for x in [0, 16] and 0 above, a cheap stand-in for exp(-x) that is good enough for edge-stopping.
+    // (b + |b|) / 2 is max(0, b) without a comparison: GCC turns std::max into a branch that skips the squarings,
+    // and that branch keeps the tap loop from being vectorized.
+    [[nodiscard]] static float approximateExpNegative(const float x) {
+        const auto base = 1.0f - x * (1.0f / 16.0f);
+        auto result = (base + std::abs(base)) * 0.5f;
+        result *= result;
+        result *= result;
+        result *= result;
+        result *= result;
+        return result;
+    }
+
+    static void filterRows(const Pass& pass, const int startRow, const int endRow) {
+        const auto width = static_cast<std::size_t>(pass.width);
+        std::vector<float> sumR(width);
+        std::vector<float> sumG(width);
+        std::vector<float> sumB(width);
+        std::vector<float> weightSum(width);
+        for (int y = startRow; y < endRow; ++y) {
+            std::fill(sumR.begin(), sumR.end(), 0.0f);
+            std::fill(sumG.begin(), sumG.end(), 0.0f);
+            std::fill(sumB.begin(), sumB.end(), 0.0f);
+            std::fill(weightSum.begin(), weightSum.end(), 0.0f);
+            const auto rowOffset = static_cast<std::size_t>(y) * width;
+            for (int kernelY = -2; kernelY <= 2; ++kernelY) {
+                const auto sampleY = y + kernelY * pass.step;
+                if (sampleY < 0 || sampleY >= pass.height) {
+                    continue;
+                }
+                for (int kernelX = -2; kernelX <= 2; ++kernelX) {
+                    const auto offsetX = kernelX * pass.step;
+                    // taps that would leave the image are skipped, the weight sum renormalizes the result
+                    const auto startX = static_cast<std::size_t>(std::clamp(-offsetX, 0, pass.width));
+                    const auto endX = static_cast<std::size_t>(std::clamp(pass.width - offsetX, 0, pass.width));
+                    const auto sampleOffset =
+                            static_cast<std::size_t>(sampleY) * width + static_cast<std::size_t>(offsetX);
+                    const auto kernelWeight = kernel[static_cast<std::size_t>(kernelX + 2)] *
+                                              kernel[static_cast<std::size_t>(kernelY + 2)];
+                    accumulateTap(pass, rowOffset, sampleOffset, startX, endX, kernelWeight, sumR.data(), sumG.data(),
+                                  sumB.data(), weightSum.data());
+                }
+            }
+            normalizeRow(width, sumR.data(), sumG.data(), sumB.data(), weightSum.data(),
+                         pass.output->r.data() + rowOffset, pass.output->g.data() + rowOffset,
+                         pass.output->b.data() + rowOffset);
+        }
+    }
+
+    // The outputs of both row loops are __restrict (understood by GCC, Clang and MSVC): without it the compiler needs
+    // a runtime alias check between every pair of planes, there are more of them than GCC is willing to emit, and the
+    // loops would not be vectorized.
+    static void normalizeRow(const std::size_t width,
+                             const float* const sumR,
+                             const float* const sumG,
+                             const float* const sumB,
+                             const float* const weightSum,
+                             float* __restrict const outputR,
+                             float* __restrict const outputG,
+                             float* __restrict const outputB) {
+        for (std::size_t x = 0; x < width; ++x) {
+            const auto inverseWeightSum = 1.0f / weightSum[x];
+            outputR[x] = sumR[x] * inverseWeightSum;
+            outputG[x] = sumG[x] * inverseWeightSum;
+            outputB[x] = sumB[x] * inverseWeightSum;
+        }
+    }
+
+    // Adds the contribution of one kernel tap to every pixel in [startX, endX) of a row. The sample position is
+    // (sampleOffset + x) (unsigned wrap-around takes care of negative horizontal offsets).
+    static void accumulateTap(const Pass& pass,
+                              const std::size_t rowOffset,
+                              const std::size_t sampleOffset,
+                              const std::size_t startX,
+                              const std::size_t endX,
+                              const float kernelWeight,
+                              float* __restrict const sumR,
+                              float* __restrict const sumG,
+                              float* __restrict const sumB,
+                              float* __restrict const weightSum) {
+        const auto* const colorR = pass.input->r.data();
+        const auto* const colorG = pass.input->g.data();
+        const auto* const colorB = pass.input->b.data();
+        const auto* const albedoR = pass.albedo->r.data();
+        const auto* const albedoG = pass.albedo->g.data();
+        const auto* const albedoB = pass.albedo->b.data();
+        for (auto x = startX; x < endX; ++x) {
+            const auto p = rowOffset + x;
+            const auto q = sampleOffset + x;
+            const auto colorDistance = square(colorR[p] - colorR[q]) + square(colorG[p] - colorG[q]) +
+                                       square(colorB[p] - colorB[q]);
+            const auto albedoDistance = square(albedoR[p] - albedoR[q]) + square(albedoG[p] - albedoG[q]) +
+                                        square(albedoB[p] - albedoB[q]);
+            const auto normalDistance = square(pass.normalX[p] - pass.normalX[q]) +
+                                        square(pass.normalY[p] - pass.normalY[q]) +
+                                        square(pass.normalZ[p] - pass.normalZ[q]);
+            const auto depthDistance = square((pass.depth[p] - pass.depth[q]) / pass.depth[p]);
+            const auto weight = kernelWeight * approximateExpNegative(colorDistance * pass.inverseColorVariance +
+                                                                      albedoDistance * pass.inverseAlbedoVariance +
+                                                                      normalDistance * pass.inverseNormalVariance +
+                                                                      depthDistance * pass.inverseDepthVariance);
+            sumR[x] += weight * colorR[q];
+            sumG[x] += weight * colorG[q];
+            sumB[x] += weight * colorB[q];
+            weightSum[x] += weight;
+        }
+    }
+
+    [[nodiscard]] static float square(const float value) {
+        return value * value;
+    }
+};
@@ -0,0 +1,374 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "Integrator.hpp"
+#include "Network.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Scene.hpp"
+#include "Serialization.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Distributed rendering: a coordinator process owns the scene and the frame buffer, any number of worker processes
+// connect to it over TCP. The coordinator sends the scene to every new worker and then hands out tiles whenever a
+// worker asks for more work. Workers render tiles with all of their threads and send back the float sums of the
+// rendered samples, the coordinator assembles them into the image. Tiles of workers that disconnect are handed out
+// again.
+//
+// Messages (see Network.hpp for the framing):
+//   coordinator -> worker: SceneData (RenderSettings + serialized Scene), Tile, Finished (empty)
+//   worker -> coordinator: RequestTiles (number of additional tiles), TileResult (Network::TileResultHeader followed
+//   by the pixels of the tile)
+namespace DistributedDetail {
+    enum class MessageType : std::uint32_t {
+        SceneData,
+        RequestTiles,
+        Tile,
+        TileResult,
+        Finished,
+    };
+
+    [[nodiscard]] inline std::vector<std::byte> encodeTileResult(const Tile& tile,
+                                                                 const RenderStatistics& statistics,
+                                                                 const double seconds,
+                                                                 const FrameBuffer& tileBuffer) {
+        ByteWriter writer;
+        Network::writeTileResult(
+                writer,
+                Network::TileResultHeader{ .tile{ tile }, .statistics{ statistics }, .seconds{ seconds } },
+                tileBuffer);
+        return Network::encodeMessage(MessageType::TileResult, writer.release());
+    }
+}// namespace DistributedDetail
+
+class RenderCoordinator {
+public:
+    explicit RenderCoordinator(const std::uint16_t port) : mPort{ port } {
+        Network::ignoreBrokenPipes();
+        mSockets.listen(port);
+        if (!mSockets.succeeded()) {
+            return;
+        }
+        mSockets.on_connection([this](const Socket socket, IPAddress) { onConnection(socket); });
+        mIsListening = true;
+    }
+
+    RenderCoordinator(const RenderCoordinator&) = delete;
+    RenderCoordinator& operator=(const RenderCoordinator&) = delete;
+
+    [[nodiscard]] bool isListening() const {
+        return mIsListening;
+    }
+
+    // blocks until all tiles of the crop window have been rendered by the connected workers
+    [[nodiscard]] FrameBuffer render(const Scene& scene, const RenderSettings& settings, const int tileSize) {
+        assert(mIsListening && tileSize > 0);
+        ByteWriter sceneWriter;
+        sceneWriter.write(settings);
+        sceneWriter.writeBytes(scene.serialize());
+        mSceneMessage = Network::encodeMessage(DistributedDetail::MessageType::SceneData, sceneWriter.release());
+        const auto& cropWindow = settings.cropWindow;
+        mCropWindow = cropWindow;
+        mFrameBuffer.emplace(cropWindow.width(), cropWindow.height());
+        const auto tiles = createTiles(cropWindow, tileSize);
+        mOpenTiles.assign(tiles.cbegin(), tiles.cend());
+        mNumTiles = tiles.size();
+        mNumFinishedTiles = 0;
+        mStatistics = RenderStatistics{};
+        mTileTimes.clear();
+        for (auto& [socket, connection] : mConnections) {
+            Network::send(socket, mSceneMessage);
+        }
+
+        std::cout << std::format("Waiting for workers on port {}...\n", mPort) << std::flush;
+        while (mNumFinishedTiles < mNumTiles) {
+            mReceivedData = false;
+            mSockets.update();
+            // the socket collection only polls, don't burn a whole core while the workers are busy
+            if (!mReceivedData) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            }
+        }
+
+        const auto finished = Network::encodeMessage(DistributedDetail::MessageType::Finished);
+        for (auto& [socket, connection] : mConnections) {
+            Network::send(socket, finished);
+        }
+        return std::move(*mFrameBuffer);
+    }
+
+    // statistics of the last render, merged from the results of all workers
+    [[nodiscard]] const RenderStatistics& statistics() const {
+        return mStatistics;
+    }
+
+    // time the workers needed for the tiles of the last render
+    [[nodiscard]] const std::vector<TileTime>& tileTimes() const {
+        return mTileTimes;
+    }
+
+private:
+    struct Connection {
+        Network::MessageBuffer<DistributedDetail::MessageType> receiveBuffer;
+        std::vector<Tile> assignedTiles;
+        std::uint32_t requestedTiles{ 0 };
+    };
+
+    void onConnection(const Socket socket) {
+        mSockets.add_already_connected_socket(socket);
+        if (!mSockets.succeeded()) {
+            return;
+        }
+        auto* const handle = mSockets.handle();
+        mSockets.on_data([this](Socket* const dataSocket, void* const data, const int size) {
+                    onData(dataSocket, data, size);
+                })
+                .on_error([this](Socket* const errorSocket) { onDisconnect(errorSocket); });
+        mConnections.emplace(handle, Connection{});
+        std::cout << std::format("Worker connected ({} connected)\n", mConnections.size()) << std::flush;
+        if (!mSceneMessage.empty()) {
+            Network::send(handle, mSceneMessage);
+        }
+    }
+
+    void onDisconnect(Socket* const socket) {
+        const auto connection = mConnections.find(socket);
+        if (connection == mConnections.end()) {
+            return;
+        }
+        // unfinished tiles are handed out again before any other tile
+        for (const auto& tile : connection->second.assignedTiles) {
+            mOpenTiles.push_front(tile);
+        }
+        mConnections.erase(connection);
+        std::cout << std::format("Worker disconnected ({} connected)\n", mConnections.size()) << std::flush;
+        assignTiles();
+    }
+
+    void onData(Socket* const socket, const void* const data, const int size) {
+        const auto connection = mConnections.find(socket);
+        if (connection == mConnections.end() || size <= 0) {
+            return;
+        }
+        mReceivedData = true;
+        auto& buffer = connection->second.receiveBuffer;
+        buffer.append(data, size);
+        while (const auto message = buffer.next()) {
+            if (!handleMessage(connection->second, message->type, message->payload)) {
+                std::cerr << "Received an invalid message from a worker\n";
+                socol_close(socket);
+                return;
+            }
+        }
+        if (buffer.isCorrupted()) {
+            socol_close(socket);
+        }
+    }
+
+    [[nodiscard]] bool handleMessage(Connection& connection,
+                                     const DistributedDetail::MessageType type,
+                                     const std::span<const std::byte> payload) {
+        using DistributedDetail::MessageType;
+        ByteReader reader{ payload };
+        switch (type) {
+            case MessageType::RequestTiles: {
+                const auto count = reader.read<std::uint32_t>();
+                if (!count) {
+                    return false;
+                }
+                connection.requestedTiles += *count;
+                assignTiles();
+                return true;
+            }
+            case MessageType::TileResult:
+                return storeTileResult(connection, reader);
+            default:
+                return false;
+        }
+    }
+
+    [[nodiscard]] bool storeTileResult(Connection& connection, ByteReader& reader) {
+        const auto header = reader.read<Network::TileResultHeader>();
+        if (!header) {
+            return false;
+        }
+        const auto& tile = header->tile;
+        const auto assignedTile = std::find_if(connection.assignedTiles.cbegin(), connection.assignedTiles.cend(),
+                                               [&](const Tile& other) {
+                                                   return other.startX == tile.startX && other.startY == tile.startY &&
+                                                          other.endX == tile.endX && other.endY == tile.endY;
+                                               });
+        if (assignedTile == connection.assignedTiles.cend() ||
+            !Network::readTilePixels(reader, tile, *mFrameBuffer, mCropWindow.startX, mCropWindow.startY)) {
+            return false;
+        }
+        connection.assignedTiles.erase(assignedTile);
+        mStatistics += header->statistics;
+        mTileTimes.push_back(TileTime{ .tile{ tile }, .seconds{ header->seconds } });
+        ++mNumFinishedTiles;
+        std::cout << std::format("Finished tile {} of {}\n", mNumFinishedTiles, mNumTiles) << std::flush;
+        return true;
+    }
+
+    // hands out open tiles to the workers that asked for them
+    void assignTiles() {
+        const auto tileMessageType = DistributedDetail::MessageType::Tile;
+        for (auto& [socket, connection] : mConnections) {
+            while (connection.requestedTiles > 0 && !mOpenTiles.empty()) {
+                const auto tile = mOpenTiles.front();
+                mOpenTiles.pop_front();
+                --connection.requestedTiles;
+                connection.assignedTiles.push_back(tile);
+                ByteWriter writer;
+                writer.write(tile);
+                Network::send(socket, Network::encodeMessage(tileMessageType, writer.release()));
+            }
+        }
+    }
+
+private:
+    std::uint16_t mPort;
+    bool mIsListening{ false };
+    bool mReceivedData{ false };
+    SocketCollection mSockets;
+    std::unordered_map<Socket*, Connection> mConnections;
+    std::vector<std::byte> mSceneMessage;
+    std::optional<FrameBuffer> mFrameBuffer;
+    Tile mCropWindow{};
+    std::deque<Tile> mOpenTiles;
+    std::size_t mNumTiles{ 0 };
+    std::size_t mNumFinishedTiles{ 0 };
+    RenderStatistics mStatistics;
+    std::vector<TileTime> mTileTimes;
+};
+
+class RenderWorker {
+public:
+    // connects to the coordinator and renders tiles until the image is finished, returns false on errors
+    [[nodiscard]] static bool run(const std::string& host, const std::string& port, const unsigned int numThreads) {
+        using namespace DistributedDetail;
+        Network::ignoreBrokenPipes();
+        TCPSocket socket;
+        if (!socket.connect(host, port)) {
+            std::cerr << std::format("Unable to connect to the coordinator at {}:{}\n", host, port);
+            return false;
+        }
+        const auto sceneMessage = Network::receiveMessage<MessageType>(socket);
+        if (!sceneMessage || sceneMessage->type != MessageType::SceneData) {
+            std::cerr << "Unable to receive the scene from the coordinator\n";
+            return false;
+        }
+        ByteReader sceneReader{ sceneMessage->payload };
+        const auto settings = sceneReader.read<RenderSettings>();
+        const auto scene =
+                Scene::deserialize(std::span{ sceneMessage->payload }.subspan(sizeof(RenderSettings)));
+        if (!settings || !scene) {
+            std::cerr << "Received an invalid scene from the coordinator\n";
+            return false;
+        }
+        const auto world = scene->buildWorld();
+        const auto samplerPrototype = createSampler(settings->samplerType);
+        const auto kernel = selectRenderKernel(*settings, world);
+        std::cout << std::format("Render kernel: {}\n", kernel.description) << std::flush;
+
+        std::mutex mutex;
+        std::condition_variable tilesAvailable;
+        std::deque<Tile> tiles;
+        bool stopped = false;
+        bool finished = false;
+        std::mutex sendMutex;
+        const auto sendMessage = [&](const std::vector<std::byte>& message) {
+            auto lock = std::scoped_lock{ sendMutex };
+            return socket.send_exact(message.data(), static_cast<std::uint32_t>(message.size())) != 0;
+        };
+        const auto requestTiles = [&](const std::uint32_t count) {
+            ByteWriter writer;
+            writer.write(count);
+            return sendMessage(Network::encodeMessage(MessageType::RequestTiles, writer.release()));
+        };
+
+        // two tiles per thread, so that no thread waits for the round trip to the coordinator
+        if (!requestTiles(2 * numThreads)) {
+            return false;
+        }
+        {
+            std::vector<std::jthread> renderThreads;
+            for (unsigned int i = 0; i < numThreads; ++i) {
+                renderThreads.emplace_back([&]() {
+                    const auto sampler = samplerPrototype->clone();
+                    while (true) {
+                        Tile tile;
+                        {
+                            auto lock = std::unique_lock{ mutex };
+                            tilesAvailable.wait(lock, [&]() { return stopped || !tiles.empty(); });
+                            if (tiles.empty()) {
+                                break;
+                            }
+                            tile = tiles.front();
+                            tiles.pop_front();
+                        }
+                        FrameBuffer tileBuffer{ tile.width(), tile.height() };
+                        RenderStatistics statistics;
+                        const auto seconds = kernel.renderTile(tile, world, *settings, settings->samplesPerPixel,
+                                                               *sampler, statistics, tileBuffer, tile.startX,
+                                                               tile.startY);
+                        if (!sendMessage(encodeTileResult(tile, statistics, seconds, tileBuffer)) ||
+                            !requestTiles(1)) {
+                            break;
+                        }
+                    }
+                });
+            }
+
+            while (true) {
+                const auto message = Network::receiveMessage<MessageType>(socket);
+                if (!message || message->type != MessageType::Tile) {
+                    finished = (message && message->type == MessageType::Finished);
+                    break;
+                }
+                ByteReader tileReader{ message->payload };
+                const auto tile = tileReader.read<Tile>();
+                if (!tile || tile->isEmpty() || !settings->cropWindow.contains(*tile) ||
+                    !Tile::wholeImage(settings->imageWidth, settings->imageHeight).contains(*tile)) {
+                    break;
+                }
+                {
+                    auto lock = std::scoped_lock{ mutex };
+                    tiles.push_back(*tile);
+                }
+                tilesAvailable.notify_one();
+            }
+            // the coordinator only finishes after all results have arrived, the remaining tiles would be lost anyway
+            {
+                auto lock = std::scoped_lock{ mutex };
+                stopped = true;
+                tiles.clear();
+            }
+            tilesAvailable.notify_all();
+        }
+        if (!finished) {
+            std::cerr << "Lost the connection to the coordinator\n";
+        }
+        return finished;
+    }
+};
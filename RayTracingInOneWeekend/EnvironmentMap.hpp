@@ -0,0 +1,206 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Color.hpp"
+#include "Sampling.hpp"
+#include "Vec3.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <vector>
+
+// linear RGB image in the equirectangular projection, the rows are ordered from the top (+y) to the bottom (-y)
+struct EnvironmentImage {
+    static constexpr int maxDimension = 16384;
+
+    int width;
+    int height;
+    std::vector<float> rgb;
+
+    [[nodiscard]] bool isValid() const {
+        return width > 0 && height > 0 && width <= maxDimension && height <= maxDimension &&
+               rgb.size() == static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3;
+    }
+
+    // HDR files are loaded as they are, other formats are converted to linear colors by stb_image
+    [[nodiscard]] static std::optional<EnvironmentImage> load(const std::string& filename) {
+        int width = 0;
+        int height = 0;
+        int channelsInFile = 0;
+        auto* const data = stbi_loadf(filename.c_str(), &width, &height, &channelsInFile, 3);
+        if (data == nullptr) {
+            return {};
+        }
+        auto result = EnvironmentImage{
+            .width{ width },
+            .height{ height },
+            .rgb{ std::vector<float>(data, data + static_cast<std::ptrdiff_t>(width) * height * 3) }
+        };
+        stbi_image_free(data);
+        if (!result.isValid()) {
+            return {};
+        }
+        return result;
+    }
+};
+
+namespace EnvironmentMapDetail {
+    // piecewise constant distribution on [0, 1), see "Physically Based Rendering", chapter 13.3
+    class Distribution1D {
+    public:
+        explicit Distribution1D(std::vector<double> function) : mFunction{ std::move(function) } {
+            assert(!mFunction.empty());
+            const auto size = static_cast<double>(mFunction.size());
+            mCdf.resize(mFunction.size() + 1);
+            mCdf[0] = 0.0;
+            for (std::size_t i = 0; i < mFunction.size(); ++i) {
+                mCdf[i + 1] = mCdf[i] + mFunction[i] / size;
+            }
+            mIntegral = mCdf.back();
+            if (mIntegral <= 0.0) {
+                // nothing to importance sample, fall back to a uniform distribution
+                for (std::size_t i = 1; i < mCdf.size(); ++i) {
+                    mCdf[i] = static_cast<double>(i) / size;
+                }
+            } else {
+                for (auto& value : mCdf) {
+                    value /= mIntegral;
+                }
+            }
+        }
+
+        // returns the sampled value in [0, 1), its density and the index of the piece it lies in
+        [[nodiscard]] double sample(const double u, double& pdf, std::size_t& index) const {
+            const auto upper = std::upper_bound(mCdf.cbegin(), mCdf.cend(), u);
+            index = static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(upper - mCdf.cbegin() - 1, 0,
+                                                                        static_cast<std::ptrdiff_t>(size()) - 1));
+            const auto pieceWidth = mCdf[index + 1] - mCdf[index];
+            const auto offset = pieceWidth > 0.0 ? (u - mCdf[index]) / pieceWidth : 0.0;
+            pdf = density(index);
+            return std::min((static_cast<double>(index) + offset) / static_cast<double>(size()), 1.0 - 1e-12);
+        }
+
+        [[nodiscard]] double density(const std::size_t index) const {
+            return mIntegral > 0.0 ? mFunction[index] / mIntegral : 1.0;
+        }
+
+        [[nodiscard]] double integral() const {
+            return mIntegral;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return mFunction.size();
+        }
+
+    private:
+        std::vector<double> mFunction;
+        std::vector<double> mCdf;
+        double mIntegral;
+    };
+}// namespace EnvironmentMapDetail
+
+struct EnvironmentSample {
+    Vec3 direction;
+    Color radiance;
+    // with respect to solid angle
+    double pdf;
+};
+
+// Infinitely far away light around the whole scene. Directions are importance sampled proportional to the luminance
+// of the texels (weighted by the area the texels cover on the sphere), using a marginal distribution over the rows and
+// one conditional distribution over the texels of every row.
+class EnvironmentMap {
+public:
+    explicit EnvironmentMap(EnvironmentImage image) : mImage{ std::move(image) } {
+        assert(mImage.isValid());
+        std::vector<double> rowIntegrals;
+        rowIntegrals.reserve(static_cast<std::size_t>(mImage.height));
+        for (int y = 0; y < mImage.height; ++y) {
+            const auto sinTheta = std::sin(std::numbers::pi * (static_cast<double>(y) + 0.5) / mImage.height);
+            std::vector<double> row(static_cast<std::size_t>(mImage.width));
+            for (int x = 0; x < mImage.width; ++x) {
+                row[static_cast<std::size_t>(x)] = luminance(texel(x, y)) * sinTheta;
+            }
+            mRows.emplace_back(std::move(row));
+            rowIntegrals.push_back(mRows.back().integral());
+        }
+        mMarginal.emplace(std::move(rowIntegrals));
+    }
+
+    [[nodiscard]] Color radiance(const Vec3& direction) const {
+        const auto [x, y] = texelCoordinates(direction);
+        return texel(x, y);
+    }
+
+    [[nodiscard]] EnvironmentSample sample(const Sample2D& sample) const {
+        double rowPdf = 0.0;
+        double columnPdf = 0.0;
+        std::size_t row = 0;
+        std::size_t column = 0;
+        const auto v = mMarginal->sample(sample.v, rowPdf, row);
+        const auto u = mRows[row].sample(sample.u, columnPdf, column);
+        const auto theta = v * std::numbers::pi;
+        const auto phi = u * 2.0 * std::numbers::pi;
+        const auto sinTheta = std::sin(theta);
+        const auto direction = Vec3{ sinTheta * std::cos(phi), std::cos(theta), sinTheta * std::sin(phi) };
+        return EnvironmentSample{ .direction{ direction },
+                                  .radiance{ texel(static_cast<int>(column), static_cast<int>(row)) },
+                                  .pdf{ toSolidAngle(rowPdf * columnPdf, sinTheta) } };
+    }
+
+    // density of sample() for the given (normalized) direction with respect to solid angle
+    [[nodiscard]] double pdf(const Vec3& direction) const {
+        const auto [x, y] = texelCoordinates(direction);
+        const auto row = static_cast<std::size_t>(y);
+        const auto sinTheta = std::sqrt(std::max(0.0, 1.0 - direction.y * direction.y));
+        return toSolidAngle(mMarginal->density(row) * mRows[row].density(static_cast<std::size_t>(x)), sinTheta);
+    }
+
+private:
+    struct TexelCoordinates {
+        int x;
+        int y;
+    };
+
+    [[nodiscard]] static double luminance(const Color& color) {
+        return 0.2126 * color.r + 0.7152 * color.g + 0.0722 * color.b;
+    }
+
+    // the density over the image is spread over 2 pi^2 sin(theta) steradians per unit area of the image
+    [[nodiscard]] static double toSolidAngle(const double imageDensity, const double sinTheta) {
+        if (sinTheta <= 0.0) {
+            return 0.0;
+        }
+        return imageDensity / (2.0 * std::numbers::pi * std::numbers::pi * sinTheta);
+    }
+
+    [[nodiscard]] TexelCoordinates texelCoordinates(const Vec3& direction) const {
+        auto u = std::atan2(direction.z, direction.x) / (2.0 * std::numbers::pi);
+        if (u < 0.0) {
+            u += 1.0;
+        }
+        const auto v = std::acos(std::clamp(direction.y, -1.0, 1.0)) / std::numbers::pi;
+        return TexelCoordinates{ .x{ std::clamp(static_cast<int>(u * mImage.width), 0, mImage.width - 1) },
+                                 .y{ std::clamp(static_cast<int>(v * mImage.height), 0, mImage.height - 1) } };
+    }
+
+    [[nodiscard]] Color texel(const int x, const int y) const {
+        const auto index = (static_cast<std::size_t>(y) * static_cast<std::size_t>(mImage.width) +
+                            static_cast<std::size_t>(x)) *
+                           3;
+        return Color{ mImage.rgb[index], mImage.rgb[index + 1], mImage.rgb[index + 2] };
+    }
+
+private:
+    EnvironmentImage mImage;
+    std::vector<EnvironmentMapDetail::Distribution1D> mRows;
+    std::optional<EnvironmentMapDetail::Distribution1D> mMarginal;
+};
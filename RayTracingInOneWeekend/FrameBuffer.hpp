@@ -0,0 +1,95 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Vec3.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// first-hit information of a camera ray (arbitrary output variables), used to guide the denoiser
+struct AovSample {
+    static constexpr auto missDepth = 1.0e6;
+
+    Color albedo;
+    Vec3 normal;
+    double depth{ missDepth };
+};
+
+// Linear (not gamma corrected) color plus the AOVs of every pixel. While rendering, the buffers hold the sums of all
+// samples taken so far, resolved() divides them by the per-pixel sample counts.
+struct FrameBuffer {
+    FrameBuffer(const int width, const int height)
+        : width{ width },
+          height{ height },
+          color(numPixels()),
+          albedo(numPixels()),
+          normal(numPixels()),
+          depth(numPixels()),
+          sampleCount(numPixels()) { }
+
+    [[nodiscard]] std::size_t numPixels() const {
+        return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    }
+
+    [[nodiscard]] std::size_t index(const int x, const int y) const {
+        assert(x >= 0 && x < width && y >= 0 && y < height);
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(width) + static_cast<std::size_t>(x);
+    }
+
+    void addSamples(const std::size_t index,
+                    const Color& colorSum,
+                    const AovSample& aovSum,
+                    const std::uint32_t numSamples) {
+        color[index] += colorSum;
+        albedo[index] += aovSum.albedo;
+        normal[index] += aovSum.normal;
+        depth[index] += aovSum.depth;
+        sampleCount[index] += numSamples;
+    }
+
+    [[nodiscard]] FrameBuffer resolved() const {
+        auto result = *this;
+        for (std::size_t i = 0; i < numPixels(); ++i) {
+            if (sampleCount[i] == 0) {
+                result.depth[i] = AovSample::missDepth;
+                continue;
+            }
+            const auto inverseSampleCount = 1.0 / static_cast<double>(sampleCount[i]);
+            result.color[i] *= inverseSampleCount;
+            result.albedo[i] *= inverseSampleCount;
+            result.normal[i] *= inverseSampleCount;
+            result.depth[i] *= inverseSampleCount;
+        }
+        return result;
+    }
+
+    // copy of the pixels [x, x + regionWidth) x [y, y + regionHeight)
+    [[nodiscard]] FrameBuffer region(const int x, const int y, const int regionWidth, const int regionHeight) const {
+        assert(x >= 0 && y >= 0 && x + regionWidth <= width && y + regionHeight <= height);
+        FrameBuffer result{ regionWidth, regionHeight };
+        for (int row = 0; row < regionHeight; ++row) {
+            for (int column = 0; column < regionWidth; ++column) {
+                const auto sourceIndex = index(x + column, y + row);
+                const auto targetIndex = result.index(column, row);
+                result.color[targetIndex] = color[sourceIndex];
+                result.albedo[targetIndex] = albedo[sourceIndex];
+                result.normal[targetIndex] = normal[sourceIndex];
+                result.depth[targetIndex] = depth[sourceIndex];
+                result.sampleCount[targetIndex] = sampleCount[sourceIndex];
+            }
+        }
+        return result;
+    }
+
+    int width;
+    int height;
+    std::vector<Color> color;
+    std::vector<Color> albedo;
+    std::vector<Vec3> normal;
+    std::vector<double> depth;
+    std::vector<std::uint32_t> sampleCount;
+};
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "BoundingBox.hpp"
 #include "Ray.hpp"
 #include "Material.hpp"
 #include <optional>
@@ -14,4 +15,10 @@ public:
 
     [[nodiscard]] virtual std::optional<double> hit(const Ray& ray, double tMin, double tMax) const = 0;
     [[nodiscard]] virtual IntersectionInfo getIntersectionInfo(const Ray& ray, double t) const = 0;
+
+    // Bounds of the part of the object that lies inside the clip box (an empty box if there is none), used to build
+    // acceleration structures (see Bvh.hpp). Objects that cannot tell are unbounded and tested against every ray.
+    [[nodiscard]] virtual std::optional<BoundingBox> clippedBounds([[maybe_unused]] const BoundingBox& clip) const {
+        return {};
+    }
 };
\ No newline at end of file
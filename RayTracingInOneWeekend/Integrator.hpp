@@ -0,0 +1,274 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "Material.hpp"
+#include "Ray.hpp"
+#include "RayFootprint.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Scene.hpp"
+#include "Sphere.hpp"
+#include "Statistics.hpp"
+#include "Wavefront.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Render kernels that are specialized at compile time on the concrete sampler, the maximum path length and the set of
+// materials that can occur in the scene. They require a world that consists of spheres only (which is what
+// Scene::buildWorld() creates). Knowing the concrete types, the compiler inlines the intersection tests, the samplers
+// and the scatter functions of the materials, and the constant maximum depth turns the recursion of rayColor() into a
+// loop over a fixed size array. The results are identical to those of the generic kernel (renderTile() in
+// Render.hpp).
+
+// the concrete material classes a specialized kernel expects, other materials still work through virtual calls
+template<typename... Materials>
+struct MaterialSet {
+    // calls the function with the material downcast to its concrete type, if it is part of the set
+    template<typename Function>
+    static decltype(auto) visit(const Material& material, Function&& function) {
+        return visitImpl<Materials...>(material, function);
+    }
+
+    [[nodiscard]] static bool containsAll(const std::vector<MaterialType>& types) {
+        return std::all_of(types.cbegin(), types.cend(), [](const MaterialType type) {
+            return ((type == Materials::materialType) || ...);
+        });
+    }
+
+private:
+    template<typename... Remaining, typename Function>
+    static decltype(auto) visitImpl(const Material& material, Function& function) {
+        if constexpr (sizeof...(Remaining) == 0) {
+            return function(material);
+        } else {
+            return visitFirst<Remaining...>(material, function);
+        }
+    }
+
+    template<typename First, typename... Rest, typename Function>
+    static decltype(auto) visitFirst(const Material& material, Function& function) {
+        if (material.type() == First::materialType) {
+            return function(static_cast<const First&>(material));
+        }
+        return visitImpl<Rest...>(material, function);
+    }
+};
+
+using AllMaterials = MaterialSet<Lambertian, Metal, Dielectric>;
+using DiffuseMaterials = MaterialSet<Lambertian>;
+
+namespace IntegratorDetail {
+    // Same path as rayColor(), but iterative. The direct light and the attenuation of every vertex are stored and
+    // combined from the end of the path to its start, which keeps the order of the floating point operations of the
+    // recursive version.
+    template<typename SamplerType, int maxDepth, typename Materials>
+    [[nodiscard]] Color tracePath(const Ray& cameraRay,
+                                  const RayFootprint& cameraFootprint,
+                                  const World& world,
+                                  SamplerType& sampler,
+                                  RenderStatistics& statistics,
+                                  AovSample& aovSample) {
+        struct Vertex {
+            Color directLight;
+            Color attenuation;
+        };
+        std::array<Vertex, static_cast<std::size_t>(maxDepth)> vertices;
+        std::size_t numVertices = 0;
+        // rays can't be assigned to
+        std::optional<Ray> currentRay{ cameraRay };
+        auto footprint = cameraFootprint;
+        auto scatterPdf = 0.0;
+        // radiance arriving at the last vertex
+        Color pathEnd{};
+        for (int bounce = 0;; ++bounce) {
+            if (bounce == maxDepth) {
+                statistics.countPathEnd(bounce);
+                break;
+            }
+            const auto& ray = *currentRay;
+            statistics.countRay(bounce);
+            const auto hit = closestHit<Sphere>(world, ray, statistics);
+            if (!hit) {
+                statistics.countPathEnd(bounce + 1);
+                const auto backgroundColor = background(world, ray);
+                if (bounce == 0) {
+                    aovSample = AovSample{ .albedo{ backgroundColor }, .normal{}, .depth{ AovSample::missDepth } };
+                }
+                if (world.environment && scatterPdf > 0.0) {
+                    // the environment has been sampled directly at the origin of this ray as well
+                    pathEnd = powerHeuristic(scatterPdf, world.environment->pdf(ray.direction)) * backgroundColor;
+                } else {
+                    pathEnd = backgroundColor;
+                }
+                break;
+            }
+            const auto [t, hittableIndex] = *hit;
+            const auto& sphere = static_cast<const Sphere&>(*world.objects[hittableIndex]);
+            auto intersectionInfo = sphere.getIntersectionInfo(ray, t);
+            intersectionInfo.footprintWidth = footprint.widthAt(ray, t, intersectionInfo);
+            const auto scatterResult = Materials::visit(*intersectionInfo.material, [&](const auto& material) {
+                if (bounce == 0) {
+                    aovSample = AovSample{ .albedo{ material.getAlbedo(intersectionInfo) },
+                                           .normal{ intersectionInfo.normal },
+                                           .depth{ t } };
+                }
+                auto result = std::pair{ material.scatter(ray, intersectionInfo, sampler), Color{} };
+                if (result.first && world.environment && result.first->pdf > 0.0) {
+                    result.second = sampleEnvironment<Sphere>(world, intersectionInfo, material, sampler, statistics);
+                }
+                return result;
+            });
+            const auto& [scattered, directLight] = scatterResult;
+            if (!scattered) {
+                statistics.countPathEnd(bounce + 1);
+                break;
+            }
+            vertices[numVertices++] = Vertex{ .directLight{ directLight }, .attenuation{ scattered->attenuation } };
+            footprint = footprint.scattered(intersectionInfo.footprintWidth, scattered->spreadAngle);
+            currentRay.emplace(scattered->ray);
+            scatterPdf = scattered->pdf;
+        }
+        auto result = pathEnd;
+        while (numVertices > 0) {
+            --numVertices;
+            result = vertices[numVertices].directLight + vertices[numVertices].attenuation * result;
+        }
+        return result;
+    }
+
+    // has the signature of renderTile()
+    template<typename SamplerType, int maxDepth, typename Materials>
+    double renderTile(const Tile& tile,
+                      const World& world,
+                      const RenderSettings& settings,
+                      const std::uint32_t endSample,
+                      Sampler& sampler,
+                      RenderStatistics& statistics,
+                      FrameBuffer& frameBuffer,
+                      const int originX,
+                      const int originY) {
+        assert(settings.maxDepth == maxDepth && dynamic_cast<SamplerType*>(&sampler) != nullptr);
+        auto& concreteSampler = static_cast<SamplerType&>(sampler);
+        return RenderDetail::renderTile(
+                tile, settings, endSample, concreteSampler, frameBuffer, originX, originY,
+                [&](const Ray& ray, const RayFootprint& footprint, AovSample& aovSample) {
+                    return tracePath<SamplerType, maxDepth, Materials>(ray, footprint, world, concreteSampler,
+                                                                       statistics, aovSample);
+                });
+    }
+
+    template<typename SamplerType>
+    [[nodiscard]] constexpr const char* samplerName() {
+        if constexpr (std::is_same_v<SamplerType, RandomSampler>) {
+            return "random";
+        } else if constexpr (std::is_same_v<SamplerType, SobolSampler>) {
+            return "Sobol";
+        } else {
+            return "blue noise";
+        }
+    }
+}// namespace IntegratorDetail
+
+using RenderTileFunction = double (*)(const Tile&,
+                                      const World&,
+                                      const RenderSettings&,
+                                      std::uint32_t,
+                                      Sampler&,
+                                      RenderStatistics&,
+                                      FrameBuffer&,
+                                      int,
+                                      int);
+
+struct RenderKernel {
+    RenderTileFunction renderTile;
+    std::string description;
+};
+
+namespace IntegratorDetail {
+    template<typename SamplerType, int maxDepth, typename Materials>
+    [[nodiscard]] RenderKernel createKernel(const char* const materialsName) {
+        return RenderKernel{ .renderTile{ &renderTile<SamplerType, maxDepth, Materials> },
+                             .description{ std::format("{} sampler, max depth {}, {}", samplerName<SamplerType>(),
+                                                       maxDepth, materialsName) } };
+    }
+
+    template<typename SamplerType, typename Materials>
+    [[nodiscard]] std::optional<RenderKernel> selectMaxDepth(const int maxDepth, const char* const materialsName) {
+        // only the common maximum depths are compiled into specialized kernels
+        switch (maxDepth) {
+            case 8:
+                return createKernel<SamplerType, 8, Materials>(materialsName);
+            case 50:
+                return createKernel<SamplerType, 50, Materials>(materialsName);
+            default:
+                return {};
+        }
+    }
+
+    template<typename SamplerType>
+    [[nodiscard]] RenderKernel createWavefrontKernel(const bool onlySpheres) {
+        if (onlySpheres) {
+            return RenderKernel{ .renderTile{ &WavefrontDetail::renderTile<SamplerType, Sphere> },
+                                 .description{ std::format("wavefront, {} sampler, spheres",
+                                                           samplerName<SamplerType>()) } };
+        }
+        return RenderKernel{ .renderTile{ &WavefrontDetail::renderTile<SamplerType, Hittable> },
+                             .description{ std::format("wavefront, {} sampler", samplerName<SamplerType>()) } };
+    }
+
+    template<typename SamplerType>
+    [[nodiscard]] std::optional<RenderKernel> selectMaterials(const RenderSettings& settings, const World& world) {
+        if (DiffuseMaterials::containsAll(world.materialTypes)) {
+            return selectMaxDepth<SamplerType, DiffuseMaterials>(settings.maxDepth, "diffuse materials");
+        }
+        return selectMaxDepth<SamplerType, AllMaterials>(settings.maxDepth, "all materials");
+    }
+}// namespace IntegratorDetail
+
+// Picks the wavefront kernel if the settings ask for it, otherwise the precompiled kernel for the settings and the
+// materials of the world, or the generic kernel if there is none. The sampler that is passed to the kernel must have
+// been created by createSampler(settings.samplerType).
+[[nodiscard]] inline RenderKernel selectRenderKernel(const RenderSettings& settings, const World& world) {
+    using namespace IntegratorDetail;
+    const auto onlySpheres = std::all_of(world.objects.cbegin(), world.objects.cend(), [](const auto& object) {
+        return dynamic_cast<const Sphere*>(object.get()) != nullptr;
+    });
+    if (settings.pathScheduling == PathScheduling::Wavefront) {
+        switch (settings.samplerType) {
+            case SamplerType::Random:
+                return createWavefrontKernel<RandomSampler>(onlySpheres);
+            case SamplerType::Sobol:
+                return createWavefrontKernel<SobolSampler>(onlySpheres);
+            case SamplerType::BlueNoise:
+                return createWavefrontKernel<BlueNoiseSampler>(onlySpheres);
+        }
+    }
+    std::optional<RenderKernel> result;
+    switch (settings.samplerType) {
+        case SamplerType::Random:
+            result = selectMaterials<RandomSampler>(settings, world);
+            break;
+        case SamplerType::Sobol:
+            result = selectMaterials<SobolSampler>(settings, world);
+            break;
+        case SamplerType::BlueNoise:
+            result = selectMaterials<BlueNoiseSampler>(settings, world);
+            break;
+    }
+    if (!onlySpheres || !result) {
+        return RenderKernel{ .renderTile{ &renderTile }, .description{ "generic" } };
+    }
+    return *result;
+}
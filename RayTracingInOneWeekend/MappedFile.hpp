@@ -0,0 +1,245 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// read-write memory mapping of a whole file, or a read-only mapping of a part of it
+class MappedFile {
+public:
+    // offsets of read-only mappings must be multiples of this (the allocation granularity of Windows, which is a
+    // multiple of the page size everywhere)
+    static constexpr std::uint64_t allocationGranularity = 64 * 1024;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : mData{ std::exchange(other.mData, nullptr) },
+          mSize{ std::exchange(other.mSize, 0) }
+#ifdef _WIN32
+          ,
+          mFile{ std::exchange(other.mFile, INVALID_HANDLE_VALUE) },
+          mMapping{ std::exchange(other.mMapping, nullptr) }
+#else
+          ,
+          mFileDescriptor{ std::exchange(other.mFileDescriptor, -1) }
+#endif
+    {
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            mData = std::exchange(other.mData, nullptr);
+            mSize = std::exchange(other.mSize, 0);
+#ifdef _WIN32
+            mFile = std::exchange(other.mFile, INVALID_HANDLE_VALUE);
+            mMapping = std::exchange(other.mMapping, nullptr);
+#else
+            mFileDescriptor = std::exchange(other.mFileDescriptor, -1);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    // creates (or truncates) the file with the given size and maps it
+    [[nodiscard]] static std::optional<MappedFile> create(const std::string& path, const std::size_t size) {
+        return map(path, size, true);
+    }
+
+    // maps an existing file with its current size
+    [[nodiscard]] static std::optional<MappedFile> open(const std::string& path) {
+        return map(path, 0, false);
+    }
+
+    // Maps length bytes starting at offset read-only, the range must lie within the file. The offset must be a multiple
+    // of allocationGranularity. The file is closed again right away, the mapping stays valid without it.
+    [[nodiscard]] static std::optional<MappedFile> openReadOnly(const std::string& path,
+                                                                const std::uint64_t offset,
+                                                                const std::size_t length) {
+        if (offset % allocationGranularity != 0 || length == 0) {
+            return {};
+        }
+        MappedFile result;
+#ifdef _WIN32
+        const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return {};
+        }
+        LARGE_INTEGER fileSize;
+        const auto end = offset + length;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &fileSize) != 0 && end <= static_cast<std::uint64_t>(fileSize.QuadPart)) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        if (mapping != nullptr) {
+            result.mData = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ,
+                                                                 static_cast<DWORD>(offset >> 32),
+                                                                 static_cast<DWORD>(offset & 0xffffffffU), length));
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+#else
+        const auto fileDescriptor = ::open(path.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            return {};
+        }
+        struct stat fileStatus {};
+        if (fstat(fileDescriptor, &fileStatus) == 0 &&
+            offset + length <= static_cast<std::uint64_t>(fileStatus.st_size)) {
+            auto* const address =
+                    mmap(nullptr, length, PROT_READ, MAP_SHARED, fileDescriptor, static_cast<off_t>(offset));
+            if (address != MAP_FAILED) {
+                result.mData = static_cast<std::byte*>(address);
+            }
+        }
+        ::close(fileDescriptor);
+#endif
+        if (result.mData == nullptr) {
+            return {};
+        }
+        result.mSize = length;
+        return result;
+    }
+
+    [[nodiscard]] std::span<std::byte> data() const {
+        return { mData, mSize };
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return mSize;
+    }
+
+    // blocks until the given range has been written back to the disk
+    bool flush(const std::size_t offset, const std::size_t length) const {
+#ifdef _WIN32
+        return FlushViewOfFile(mData + offset, length) != 0 && FlushFileBuffers(mFile) != 0;
+#else
+        // msync needs a page aligned start address
+        const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const auto alignedOffset = offset / pageSize * pageSize;
+        return msync(mData + alignedOffset, length + (offset - alignedOffset), MS_SYNC) == 0;
+#endif
+    }
+
+private:
+    MappedFile() = default;
+
+    [[nodiscard]] static std::optional<MappedFile> map(const std::string& path, std::size_t size, const bool create) {
+        MappedFile result;
+#ifdef _WIN32
+        result.mFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                   create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (result.mFile == INVALID_HANDLE_VALUE) {
+            return {};
+        }
+        if (!create) {
+            LARGE_INTEGER fileSize;
+            if (GetFileSizeEx(result.mFile, &fileSize) == 0) {
+                return {};
+            }
+            size = static_cast<std::size_t>(fileSize.QuadPart);
+        }
+        if (size == 0) {
+            return {};
+        }
+        const auto size64 = static_cast<std::uint64_t>(size);
+        result.mMapping = CreateFileMappingA(result.mFile, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                             static_cast<DWORD>(size64 & 0xffffffffU), nullptr);
+        if (result.mMapping == nullptr) {
+            return {};
+        }
+        result.mData = static_cast<std::byte*>(MapViewOfFile(result.mMapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        if (result.mData == nullptr) {
+            return {};
+        }
+#else
+        result.mFileDescriptor = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+        if (result.mFileDescriptor < 0) {
+            return {};
+        }
+        if (create) {
+            if (ftruncate(result.mFileDescriptor, static_cast<off_t>(size)) != 0) {
+                return {};
+            }
+        } else {
+            struct stat fileStatus {};
+            if (fstat(result.mFileDescriptor, &fileStatus) != 0) {
+                return {};
+            }
+            size = static_cast<std::size_t>(fileStatus.st_size);
+        }
+        if (size == 0) {
+            return {};
+        }
+        auto* const address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, result.mFileDescriptor, 0);
+        if (address == MAP_FAILED) {
+            return {};
+        }
+        result.mData = static_cast<std::byte*>(address);
+#endif
+        result.mSize = size;
+        return result;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (mData != nullptr) {
+            UnmapViewOfFile(mData);
+        }
+        if (mMapping != nullptr) {
+            CloseHandle(mMapping);
+        }
+        if (mFile != INVALID_HANDLE_VALUE) {
+            CloseHandle(mFile);
+        }
+        mMapping = nullptr;
+        mFile = INVALID_HANDLE_VALUE;
+#else
+        if (mData != nullptr) {
+            munmap(mData, mSize);
+        }
+        if (mFileDescriptor >= 0) {
+            ::close(mFileDescriptor);
+        }
+        mFileDescriptor = -1;
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+
+private:
+    std::byte* mData{ nullptr };
+    std::size_t mSize{ 0 };
+#ifdef _WIN32
+    HANDLE mFile{ INVALID_HANDLE_VALUE };
+    HANDLE mMapping{ nullptr };
+#else
+    int mFileDescriptor{ -1 };
+#endif
+};
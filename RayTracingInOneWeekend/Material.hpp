@@ -7,16 +7,43 @@
 #include "Ray.hpp"
 #include "Color.hpp"
 #include "Utility.hpp"
+#include "Sampler.hpp"
+#include "Texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <numbers>
 #include <optional>
 
 class Material;
 
+enum class MaterialType : std::uint32_t {
+    Lambertian,
+    Metal,
+    Dielectric,
+};
+
 struct IntersectionInfo {
     Point3 intersectionPoint;
     Vec3 normal;
     bool isFrontFace;
     std::shared_ptr<Material> material;
+    TextureCoordinates textureCoordinates{ .u{ 0.0 }, .v{ 0.0 } };
+    // partial derivatives of the intersection point by the texture coordinates
+    Vec3 dpdu{};
+    Vec3 dpdv{};
+    // width of the area around the intersection point that is covered by the ray, see RayFootprint
+    double footprintWidth{ 0.0 };
+
+    // the footprint of the ray converted into texture coordinates, textureScale is applied to the coordinates
+    [[nodiscard]] double textureFootprint(const double textureScale) const {
+        const auto surfacePerTextureArea = dpdu.cross(dpdv).length();
+        if (surfacePerTextureArea <= 0.0) {
+            return infinity;
+        }
+        return footprintWidth / std::sqrt(surfacePerTextureArea) * textureScale;
+    }
 
     void setFaceNormal(const Ray& ray, const Vec3& outwardsNormal) {
         isFrontFace = outwardsNormal.dot(ray.direction) < 0.0;
@@ -27,42 +54,132 @@ struct IntersectionInfo {
 struct ScatterResult {
     Color attenuation;
     Ray ray;
+    // additional angle by which the footprint of the scattered ray widens, 0 for perfectly specular scattering
+    double spreadAngle;
+    // density of the direction of the ray with respect to solid angle, 0 if the material cannot evaluate its
+    // density for arbitrary directions (which excludes it from light sampling)
+    double pdf;
 };
 
+// The concrete materials are final and additionally offer scatter() as a template on the type of the sampler. Kernels
+// that know the concrete types (see Integrator.hpp) can use type() to downcast and have all calls inlined.
 class Material {
 public:
+    [[nodiscard]] MaterialType type() const {
+        return mType;
+    }
+
     [[nodiscard]] virtual std::optional<ScatterResult> scatter(const Ray& intersectionRay,
-                                                               const IntersectionInfo& intersectionInfo) = 0;
+                                                               const IntersectionInfo& intersectionInfo,
+                                                               Sampler& sampler) const = 0;
+
+    // reflectance of the surface, written into the albedo AOV that guides the denoiser
+    [[nodiscard]] virtual Color getAlbedo(const IntersectionInfo& intersectionInfo) const = 0;
+
+    // BSDF times the cosine term for light arriving from the given direction, see ScatterResult::pdf
+    [[nodiscard]] virtual Color evaluate(const IntersectionInfo&, const Vec3&) const {
+        return Color{};
+    }
+
+    // density with which scatter() would choose the given direction
+    [[nodiscard]] virtual double pdf(const IntersectionInfo&, const Vec3&) const {
+        return 0.0;
+    }
+
+protected:
+    explicit Material(const MaterialType type) : mType{ type } { }
+
+private:
+    MaterialType mType;
 };
 
-class Lambertian : public Material {
+class Lambertian final : public Material {
 public:
-    explicit Lambertian(Color albedo) : albedo{ albedo } { }
+    static constexpr auto materialType = MaterialType::Lambertian;
+    // diffuse reflection scatters into the whole hemisphere, this only serves to select blurrier mip levels
+    static constexpr auto spreadAngle = std::numbers::pi / 8.0;
 
-    [[nodiscard]] std::optional<ScatterResult> scatter(const Ray&, const IntersectionInfo& intersectionInfo) override {
-        const auto newRayDirection = [&]() {
-            const auto temp = intersectionInfo.normal + Random::randomUnitVector();
-            return temp.isNearZero() ? intersectionInfo.normal : temp;
-        }();
-        // alternatively use Random::randomVecInsideUnitSphere() or Random::randomVecInsideHemisphere(normal)
-        // to generate the scattered ray target
-        return ScatterResult{ .attenuation{ albedo },
-                              .ray{ Ray{ intersectionInfo.intersectionPoint, newRayDirection } } };
+    explicit Lambertian(Color albedo) : Material{ materialType }, albedo{ albedo } { }
+
+    // The texture is repeated textureRepeat times along v and twice as often along u, which keeps the texels square
+    // with the texture coordinates of a sphere.
+    Lambertian(std::shared_ptr<const Texture> texture, const double textureRepeat)
+        : Material{ materialType },
+          albedo{ Color{ 1.0, 1.0, 1.0 } },
+          texture{ std::move(texture) },
+          textureRepeat{ textureRepeat } { }
+
+    [[nodiscard]] std::optional<ScatterResult> scatter(const Ray& intersectionRay,
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       Sampler& sampler) const override {
+        return scatter<Sampler>(intersectionRay, intersectionInfo, sampler);
+    }
+
+    template<typename SamplerType>
+    [[nodiscard]] std::optional<ScatterResult> scatter(const Ray&,
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       SamplerType& sampler) const {
+        const auto newRayDirection = Sampling::cosineHemisphere(sampler.get2D(), intersectionInfo.normal);
+        const auto ray = Ray{ intersectionInfo.intersectionPoint, newRayDirection };
+        return ScatterResult{ .attenuation{ getAlbedo(intersectionInfo) },
+                              .ray{ ray },
+                              .spreadAngle{ spreadAngle },
+                              .pdf{ pdf(intersectionInfo, ray.direction) } };
+    }
+
+    [[nodiscard]] Color getAlbedo(const IntersectionInfo& intersectionInfo) const override {
+        if (!texture) {
+            return albedo;
+        }
+        const auto& coordinates = intersectionInfo.textureCoordinates;
+        return texture->sample(
+                TextureCoordinates{ .u{ 2.0 * textureRepeat * coordinates.u }, .v{ textureRepeat * coordinates.v } },
+                intersectionInfo.textureFootprint(std::numbers::sqrt2 * textureRepeat));
+    }
+
+    [[nodiscard]] Color evaluate(const IntersectionInfo& intersectionInfo, const Vec3& direction) const override {
+        return getAlbedo(intersectionInfo) * pdf(intersectionInfo, direction);
+    }
+
+    // cosine weighted, which equals the cosine term of the BSDF divided by pi
+    [[nodiscard]] double pdf(const IntersectionInfo& intersectionInfo, const Vec3& direction) const override {
+        return std::max(intersectionInfo.normal.dot(direction), 0.0) / std::numbers::pi;
     }
 
 public:
     const Color albedo;
+    const std::shared_ptr<const Texture> texture;
+    const double textureRepeat{ 1.0 };
 };
 
-class Metal : public Material {
+class Metal final : public Material {
 public:
-    Metal(Color albedo, double fuzz) : albedo{ albedo }, fuzz{ fuzz } { }
+    static constexpr auto materialType = MaterialType::Metal;
+
+    Metal(Color albedo, double fuzz) : Material{ materialType }, albedo{ albedo }, fuzz{ fuzz } { }
+
+    [[nodiscard]] std::optional<ScatterResult> scatter(const Ray& intersectionRay,
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       Sampler& sampler) const override {
+        return scatter<Sampler>(intersectionRay, intersectionInfo, sampler);
+    }
 
+    template<typename SamplerType>
     [[nodiscard]] std::optional<ScatterResult> scatter(const Ray& intersectionRay,
-                                                       const IntersectionInfo& intersectionInfo) override {
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       SamplerType& sampler) const {
+        const auto directionSample = sampler.get2D();
         const auto reflected = intersectionRay.direction.normalized().reflect(intersectionInfo.normal) +
-                               fuzz * Random::randomVecInsideUnitSphere();
-        return ScatterResult{ .attenuation{ albedo }, .ray{ Ray{ intersectionInfo.intersectionPoint, reflected } } };
+                               fuzz * Sampling::uniformBall(directionSample, sampler.get1D());
+        // the fuzz ball has the radius fuzz around the tip of the unit length reflection direction
+        return ScatterResult{ .attenuation{ albedo },
+                              .ray{ Ray{ intersectionInfo.intersectionPoint, reflected } },
+                              .spreadAngle{ std::atan(fuzz) },
+                              .pdf{ 0.0 } };
+    }
+
+    [[nodiscard]] Color getAlbedo(const IntersectionInfo&) const override {
+        return albedo;
     }
 
 public:
@@ -70,12 +187,22 @@ public:
     const double fuzz;
 };
 
-class Dielectric : public Material {
+class Dielectric final : public Material {
 public:
-    explicit Dielectric(double refractionIndex) : refractionIndex{ refractionIndex } { }
+    static constexpr auto materialType = MaterialType::Dielectric;
+
+    explicit Dielectric(double refractionIndex) : Material{ materialType }, refractionIndex{ refractionIndex } { }
 
     [[nodiscard]] std::optional<ScatterResult> scatter(const Ray& intersectionRay,
-                                                       const IntersectionInfo& intersectionInfo) override {
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       Sampler& sampler) const override {
+        return scatter<Sampler>(intersectionRay, intersectionInfo, sampler);
+    }
+
+    template<typename SamplerType>
+    [[nodiscard]] std::optional<ScatterResult> scatter(const Ray& intersectionRay,
+                                                       const IntersectionInfo& intersectionInfo,
+                                                       SamplerType& sampler) const {
         constexpr auto airRefractionIndex = 1.0;
         const auto refractionIndexRatio = intersectionInfo.isFrontFace ? (airRefractionIndex / refractionIndex)
                                                                        : (refractionIndex / airRefractionIndex);
@@ -83,14 +210,22 @@ public:
         const auto cosTheta = std::min(-intersectionRay.direction.dot(intersectionInfo.normal), 1.0);
         const auto sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
         const auto cannotRefract = (refractionIndexRatio * sinTheta > 1.0);
+        // drawn even on total internal reflection, so that every path uses the same sampler dimensions
+        const auto reflectionSample = sampler.get1D();
         const auto outgoingRayDirection = [&]() {
-            if (cannotRefract || reflectance(cosTheta, refractionIndexRatio) > Random::randomDouble()) {
+            if (cannotRefract || reflectance(cosTheta, refractionIndexRatio) > reflectionSample) {
                 return intersectionRay.direction.reflect(intersectionInfo.normal);
             }
             return intersectionRay.direction.refract(intersectionInfo.normal, refractionIndexRatio);
         }();
         return ScatterResult{ .attenuation{ Color{ 1.0, 1.0, 1.0 } },
-                              .ray{ Ray{ intersectionInfo.intersectionPoint, outgoingRayDirection } } };
+                              .ray{ Ray{ intersectionInfo.intersectionPoint, outgoingRayDirection } },
+                              .spreadAngle{ 0.0 },
+                              .pdf{ 0.0 } };
+    }
+
+    [[nodiscard]] Color getAlbedo(const IntersectionInfo&) const override {
+        return Color{ 1.0, 1.0, 1.0 };
     }
 
 public:
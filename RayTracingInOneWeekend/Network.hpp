@@ -0,0 +1,188 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "Render.hpp"
+#include "Serialization.hpp"
+#include "Statistics.hpp"
+#include <array>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#ifndef NET_USE_CPP
+#define NET_USE_CPP
+#endif
+#include "net.h"
+
+// Message framing on top of the TCP sockets of net.h, shared by the distributed renderer and the render server.
+// Every message starts with a MessageHeader followed by size bytes of payload, the meaning of the type is defined by
+// the MessageType enum of the respective protocol.
+namespace Network {
+    inline constexpr std::uint32_t maxMessageSize = 64 * 1024 * 1024;
+
+    struct MessageHeader {
+        std::uint32_t type;
+        std::uint32_t size;
+    };
+
+    template<typename MessageType>
+    struct Message {
+        MessageType type;
+        std::vector<std::byte> payload;
+    };
+
+    template<typename MessageType>
+    [[nodiscard]] std::vector<std::byte> encodeMessage(const MessageType type,
+                                                       const std::span<const std::byte> payload = {}) {
+        ByteWriter writer;
+        writer.write(MessageHeader{ .type{ static_cast<std::uint32_t>(type) },
+                                    .size{ static_cast<std::uint32_t>(payload.size()) } });
+        writer.writeBytes(payload);
+        return writer.release();
+    }
+
+    // blocks until a complete message has been received
+    template<typename MessageType>
+    [[nodiscard]] std::optional<Message<MessageType>> receiveMessage(TCPSocket& socket) {
+        MessageHeader header;
+        if (!socket.receive_exact(&header, sizeof(header)) || header.size > maxMessageSize) {
+            return {};
+        }
+        auto message = Message<MessageType>{ .type{ static_cast<MessageType>(header.type) },
+                                             .payload{ std::vector<std::byte>(header.size) } };
+        if (header.size > 0 && !socket.receive_exact(message.payload.data(), static_cast<int>(header.size))) {
+            return {};
+        }
+        return message;
+    }
+
+    // sends a whole message through a socket of a SocketCollection, errors are reported by its next update
+    inline void send(Socket* const socket, const std::vector<std::byte>& message) {
+        static_cast<void>(tcp_send_exact(socket, message.data(), static_cast<int>(message.size())));
+    }
+
+    // reassembles the messages from the chunks of data a SocketCollection delivers
+    template<typename MessageType>
+    class MessageBuffer {
+    public:
+        void append(const void* const data, const int size) {
+            const auto* const bytes = static_cast<const std::byte*>(data);
+            mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+        }
+
+        // returns the next complete message, if any
+        [[nodiscard]] std::optional<Message<MessageType>> next() {
+            if (mBuffer.size() - mOffset < sizeof(MessageHeader)) {
+                compact();
+                return {};
+            }
+            MessageHeader header;
+            std::memcpy(&header, mBuffer.data() + mOffset, sizeof(header));
+            if (header.size > maxMessageSize) {
+                mIsCorrupted = true;
+                return {};
+            }
+            if (mBuffer.size() - mOffset - sizeof(header) < header.size) {
+                compact();
+                return {};
+            }
+            const auto payloadBegin = mBuffer.cbegin() + static_cast<std::ptrdiff_t>(mOffset + sizeof(header));
+            auto result = Message<MessageType>{
+                .type{ static_cast<MessageType>(header.type) },
+                .payload{ std::vector<std::byte>(payloadBegin, payloadBegin + header.size) }
+            };
+            mOffset += sizeof(header) + header.size;
+            return result;
+        }
+
+        [[nodiscard]] bool isCorrupted() const {
+            return mIsCorrupted;
+        }
+
+    private:
+        void compact() {
+            mBuffer.erase(mBuffer.begin(), mBuffer.begin() + static_cast<std::ptrdiff_t>(mOffset));
+            mOffset = 0;
+        }
+
+    private:
+        std::vector<std::byte> mBuffer;
+        std::size_t mOffset{ 0 };
+        bool mIsCorrupted{ false };
+    };
+
+    // Rendered tile as it is sent over the network: this header, followed by one TilePixel per pixel of the tile
+    struct TileResultHeader {
+        Tile tile;
+        RenderStatistics statistics;
+        double seconds;
+    };
+
+    // sums of the samples of one pixel, see FrameBuffer
+    struct TilePixel {
+        std::array<float, 10> values;// color, albedo, normal, depth
+        std::uint32_t sampleCount;
+    };
+
+    inline void writeTileResult(ByteWriter& writer, const TileResultHeader& header, const FrameBuffer& tileBuffer) {
+        writer.write(header);
+        for (std::size_t i = 0; i < tileBuffer.numPixels(); ++i) {
+            const auto& color = tileBuffer.color[i];
+            const auto& albedo = tileBuffer.albedo[i];
+            const auto& normal = tileBuffer.normal[i];
+            writer.write(TilePixel{
+                    .values{ static_cast<float>(color.r), static_cast<float>(color.g), static_cast<float>(color.b),
+                             static_cast<float>(albedo.r), static_cast<float>(albedo.g), static_cast<float>(albedo.b),
+                             static_cast<float>(normal.x), static_cast<float>(normal.y), static_cast<float>(normal.z),
+                             static_cast<float>(tileBuffer.depth[i]) },
+                    .sampleCount{ tileBuffer.sampleCount[i] } });
+        }
+    }
+
+    // Reads the pixels that follow a TileResultHeader into the frame buffer. The frame buffer may cover only a part of
+    // the image, its bottom left pixel is the image pixel (originX, originY).
+    [[nodiscard]] inline bool readTilePixels(ByteReader& reader,
+                                             const Tile& tile,
+                                             FrameBuffer& frameBuffer,
+                                             const int originX = 0,
+                                             const int originY = 0) {
+        const auto numPixels = static_cast<std::size_t>(tile.width()) * static_cast<std::size_t>(tile.height());
+        const auto frameBufferRegion = Tile{ .startX{ originX },
+                                             .startY{ originY },
+                                             .endX{ originX + frameBuffer.width },
+                                             .endY{ originY + frameBuffer.height } };
+        if (tile.isEmpty() || !frameBufferRegion.contains(tile) ||
+            reader.remaining() != numPixels * sizeof(TilePixel)) {
+            return false;
+        }
+        for (auto y = tile.startY; y < tile.endY; ++y) {
+            for (auto x = tile.startX; x < tile.endX; ++x) {
+                const auto pixel = *reader.read<TilePixel>();
+                const auto& values = pixel.values;
+                frameBuffer.addSamples(frameBuffer.index(x - originX, y - originY),
+                                       Color{ values[0], values[1], values[2] },
+                                       AovSample{ .albedo{ Color{ values[3], values[4], values[5] } },
+                                                  .normal{ Vec3{ values[6], values[7], values[8] } },
+                                                  .depth{ values[9] } },
+                                       pixel.sampleCount);
+            }
+        }
+        return true;
+    }
+
+    inline void ignoreBrokenPipes() {
+#ifndef _WIN32
+        // writing to a socket whose peer has disconnected must not terminate the process
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+    }
+}// namespace Network
@@ -0,0 +1,233 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace NumaDetail {
+    // parses lists like "0-3,8-11" as they are used by sysfs
+    [[nodiscard]] inline std::vector<int> parseCpuList(const std::string_view text) {
+        std::vector<int> result;
+        std::size_t start = 0;
+        while (start < text.size()) {
+            const auto separator = std::min(text.find(',', start), text.size());
+            const auto range = text.substr(start, separator - start);
+            const auto dash = range.find('-');
+            int first = 0;
+            int last = 0;
+            const auto firstText = range.substr(0, dash);
+            const auto lastText = dash == std::string_view::npos ? firstText : range.substr(dash + 1);
+            if (std::from_chars(firstText.data(), firstText.data() + firstText.size(), first).ec == std::errc{} &&
+                std::from_chars(lastText.data(), lastText.data() + lastText.size(), last).ec == std::errc{}) {
+                for (auto cpu = first; cpu <= last; ++cpu) {
+                    result.push_back(cpu);
+                }
+            }
+            start = separator + 1;
+        }
+        return result;
+    }
+}// namespace NumaDetail
+
+// Thread pinning and NUMA placement without depending on libnuma. The topology is read from sysfs on Linux and from
+// the Win32 API on Windows, every other platform is treated as a single node whose threads cannot be pinned.
+namespace Numa {
+    struct Node {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    // the NUMA nodes with the CPUs this process may run on, nodes without such CPUs are left out
+    [[nodiscard]] inline std::vector<Node> topology() {
+        std::vector<Node> result;
+#ifdef _WIN32
+        ULONG highestNode = 0;
+        if (GetNumaHighestNodeNumber(&highestNode)) {
+            DWORD_PTR processMask = 0;
+            DWORD_PTR systemMask = 0;
+            GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+            for (ULONG id = 0; id <= highestNode; ++id) {
+                ULONGLONG nodeMask = 0;
+                if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(id), &nodeMask)) {
+                    continue;
+                }
+                Node node{ .id{ static_cast<int>(id) }, .cpus{} };
+                for (int cpu = 0; cpu < 64; ++cpu) {
+                    if ((nodeMask & processMask & (ULONGLONG{ 1 } << cpu)) != 0) {
+                        node.cpus.push_back(cpu);
+                    }
+                }
+                if (!node.cpus.empty()) {
+                    result.push_back(std::move(node));
+                }
+            }
+        }
+#elif defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const auto hasAffinity = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+        for (int id = 0;; ++id) {
+            std::ifstream file{ "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist" };
+            if (!file) {
+                break;
+            }
+            std::string cpuList;
+            std::getline(file, cpuList);
+            Node node{ .id{ id }, .cpus{} };
+            for (const auto cpu : NumaDetail::parseCpuList(cpuList)) {
+                if (!hasAffinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                result.push_back(std::move(node));
+            }
+        }
+#endif
+        if (result.empty()) {
+            Node node{ .id{ 0 }, .cpus{} };
+            const auto numCpus = std::max(1U, std::thread::hardware_concurrency());
+            for (unsigned int cpu = 0; cpu < numCpus; ++cpu) {
+                node.cpus.push_back(static_cast<int>(cpu));
+            }
+            result.push_back(std::move(node));
+        }
+        return result;
+    }
+
+    // returns false if the platform does not support pinning threads
+    inline bool pinCurrentThread(const int cpu) {
+#ifdef _WIN32
+        if (cpu >= 64) {
+            return false;
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu) != 0;
+#elif defined(__linux__)
+        if (cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        static_cast<void>(cpu);
+        return false;
+#endif
+    }
+
+    // Calls the function while the memory the calling thread allocates (and touches first) is spread round-robin over
+    // the pages of all nodes. Without support for memory policies, the function is just called.
+    template<typename Function>
+    auto withInterleavedMemory(const std::vector<Node>& nodes, Function&& function) {
+#ifdef __linux__
+        // see set_mempolicy(2), the constants are those of <numaif.h>
+        constexpr int policyDefault = 0;
+        constexpr int policyInterleave = 3;
+        constexpr auto bitsPerWord = sizeof(unsigned long) * 8;
+        const auto maxNode = std::max_element(nodes.cbegin(), nodes.cend(), [](const Node& lhs, const Node& rhs) {
+                                 return lhs.id < rhs.id;
+                             })->id;
+        std::vector<unsigned long> nodeMask(static_cast<std::size_t>(maxNode) / bitsPerWord + 1);
+        for (const auto& node : nodes) {
+            const auto id = static_cast<std::size_t>(node.id);
+            nodeMask[id / bitsPerWord] |= 1UL << (id % bitsPerWord);
+        }
+        const auto isInterleaved = syscall(SYS_set_mempolicy, policyInterleave, nodeMask.data(),
+                                           nodeMask.size() * bitsPerWord + 1) == 0;
+        struct ResetPolicy {
+            bool isActive;
+            ~ResetPolicy() {
+                if (isActive) {
+                    syscall(SYS_set_mempolicy, policyDefault, nullptr, 0);
+                }
+            }
+        } resetPolicy{ isInterleaved };
+        return function();
+#else
+        static_cast<void>(nodes);
+        return function();
+#endif
+    }
+
+    // Gives the zero-initialized memory of the vector back to the operating system, so that every page is allocated
+    // again on the node of the thread that writes to it first. This only works for types whose zero value consists of
+    // zero bytes, on platforms other than Linux, the memory stays where it is.
+    template<typename T>
+    void releaseForFirstTouch(std::vector<T>& values) {
+#ifdef __linux__
+        const auto pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        const auto begin = reinterpret_cast<std::uintptr_t>(values.data());
+        const auto end = begin + values.size() * sizeof(T);
+        // pages that are shared with other allocations must be kept
+        const auto firstPage = (begin + pageSize - 1) / pageSize * pageSize;
+        const auto lastPage = end / pageSize * pageSize;
+        if (firstPage < lastPage) {
+            static_cast<void>(madvise(reinterpret_cast<void*>(firstPage), lastPage - firstPage, MADV_DONTNEED));
+        }
+#else
+        static_cast<void>(values);
+#endif
+    }
+
+    // where the render threads run: thread i is pinned to cpus[i] (if any) and belongs to the node with the index
+    // nodeIndices[i] in the topology
+    struct ThreadPlacement {
+        std::vector<std::optional<int>> cpus;
+        std::vector<std::size_t> nodeIndices;
+        std::size_t numNodes;
+
+        [[nodiscard]] unsigned int numThreads() const {
+            return static_cast<unsigned int>(cpus.size());
+        }
+
+        [[nodiscard]] static ThreadPlacement unpinned(const unsigned int numThreads) {
+            return ThreadPlacement{ .cpus{ std::vector<std::optional<int>>(numThreads) },
+                                    .nodeIndices{ std::vector<std::size_t>(numThreads, 0) },
+                                    .numNodes{ 1 } };
+        }
+
+        // spreads the threads evenly over the CPUs of all nodes, so that every node gets its share of the threads
+        [[nodiscard]] static ThreadPlacement pinned(const std::vector<Node>& nodes, const unsigned int numThreads) {
+            std::vector<std::pair<int, std::size_t>> cpus;
+            for (std::size_t i = 0; i < nodes.size(); ++i) {
+                for (const auto cpu : nodes[i].cpus) {
+                    cpus.emplace_back(cpu, i);
+                }
+            }
+            ThreadPlacement result{ .cpus{}, .nodeIndices{}, .numNodes{ nodes.size() } };
+            for (std::size_t i = 0; i < numThreads; ++i) {
+                const auto& [cpu, nodeIndex] = cpus[i * cpus.size() / numThreads];
+                result.cpus.emplace_back(cpu);
+                result.nodeIndices.push_back(nodeIndex);
+            }
+            return result;
+        }
+    };
+}// namespace Numa
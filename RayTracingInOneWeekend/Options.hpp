@@ -0,0 +1,429 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Camera.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Vec3.hpp"
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// rectangle of the output image in pixels, measured from its top left corner
+struct CropRectangle {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// how the render threads of a local render read the scene on machines with several NUMA nodes
+enum class NumaPlacement {
+    None,
+    // every node gets its own copy of the world in its local memory
+    Replicate,
+    // a single copy of the world, spread over the memory of all nodes
+    Interleave,
+};
+
+struct Options {
+    int imageWidth{ 1200 };
+    // low discrepancy samplers converge a lot faster than independent random numbers, use a power of two
+    std::uint32_t samplesPerPixel{ 32 };
+    CameraSettings camera;
+    SamplerType samplerType{ SamplerType::Sobol };
+    PathScheduling pathScheduling{ PathScheduling::PerPath };
+    BvhType bvhType{ BvhType::SpatialSplits };
+    // 0 = 7/8 of the hardware threads, the image does not depend on the number of threads
+    unsigned int numThreads{ 0 };
+    // only this part of the image is rendered and written
+    std::optional<CropRectangle> crop;
+    // render previews at 1/previewFactor, 1/(previewFactor/2), ..., 1/2 of the resolution first (0 = no previews)
+    int previewFactor{ 0 };
+    // filter the noise out of the final image, see Denoiser.hpp
+    bool denoise{ true };
+    bool pinThreads{ false };
+    // implies pinThreads
+    NumaPlacement numaPlacement{ NumaPlacement::None };
+    // image that replaces the color of the ground of the demo scene
+    std::optional<std::string> groundTexturePath;
+    // equirectangular (HDR) image that lights the scene instead of the background gradient
+    std::optional<std::string> environmentPath;
+    // spheres that are streamed from a geometry file instead of the demo scene, see ChunkedGeometry.hpp
+    std::optional<std::string> geometryPath;
+    std::size_t geometryBudgetMiB{ 1024 };
+    // only write the spheres of the demo scene into this geometry file
+    std::optional<std::string> writeGeometryPath;
+    std::size_t spheresPerChunk{ 1024 };
+    // compare the written image to this one, the exit code tells whether they are identical
+    std::optional<std::string> goldenImagePath;
+    bool resume{ false };
+    std::string checkpointPath{ "raytracer.checkpoint" };
+    double checkpointIntervalSeconds{ 60.0 };
+    // distributed rendering, see Distributed.hpp
+    std::optional<std::uint16_t> coordinatorPort;
+    unsigned int numLoopbackWorkers{ 0 };
+    std::optional<std::string> workerHost;
+    std::string workerPort;
+    // render server, see RenderServer.hpp
+    std::optional<std::uint16_t> serverPort;
+    std::optional<std::string> clientHost;
+    std::string clientPort;
+    std::string sceneName{ "demo" };
+    std::int32_t priority{ 0 };
+};
+
+class CommandLine {
+public:
+    [[nodiscard]] static std::optional<Options> parse(const int argc, const char* const* const argv) {
+        const auto arguments = std::vector<std::string_view>(argv + 1, argv + argc);
+        Options options;
+        for (std::size_t i = 0; i < arguments.size(); ++i) {
+            const auto argument = arguments[i];
+            const auto nextArgument = [&]() -> std::optional<std::string_view> {
+                if (i + 1 >= arguments.size()) {
+                    std::cerr << std::format("Missing value for option {}\n", argument);
+                    return {};
+                }
+                return arguments[++i];
+            };
+            if (argument == "--width") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.imageWidth)) {
+                    return {};
+                }
+            } else if (argument == "--samples") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.samplesPerPixel)) {
+                    return {};
+                }
+            } else if (argument == "--look-from") {
+                const auto value = nextArgument();
+                if (!value || !parseVector(*value, options.camera.lookFrom)) {
+                    return {};
+                }
+            } else if (argument == "--look-at") {
+                const auto value = nextArgument();
+                if (!value || !parseVector(*value, options.camera.lookAt)) {
+                    return {};
+                }
+            } else if (argument == "--sampler") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                if (*value == "random") {
+                    options.samplerType = SamplerType::Random;
+                } else if (*value == "sobol") {
+                    options.samplerType = SamplerType::Sobol;
+                } else if (*value == "blue-noise") {
+                    options.samplerType = SamplerType::BlueNoise;
+                } else {
+                    std::cerr << std::format("Invalid sampler (expected random, sobol or blue-noise): {}\n", *value);
+                    return {};
+                }
+            } else if (argument == "--wavefront") {
+                options.pathScheduling = PathScheduling::Wavefront;
+            } else if (argument == "--bvh") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                if (*value == "none") {
+                    options.bvhType = BvhType::None;
+                } else if (*value == "object") {
+                    options.bvhType = BvhType::ObjectSplits;
+                } else if (*value == "spatial") {
+                    options.bvhType = BvhType::SpatialSplits;
+                } else {
+                    std::cerr << std::format("Invalid BVH (expected none, object or spatial): {}\n", *value);
+                    return {};
+                }
+            } else if (argument == "--threads") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.numThreads)) {
+                    return {};
+                }
+            } else if (argument == "--compare") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.goldenImagePath = std::string{ *value };
+            } else if (argument == "--crop") {
+                const auto value = nextArgument();
+                CropRectangle crop{};
+                if (!value || !parseCropRectangle(*value, crop)) {
+                    return {};
+                }
+                options.crop = crop;
+            } else if (argument == "--preview") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.previewFactor)) {
+                    return {};
+                }
+                if (options.previewFactor != 2 && options.previewFactor != 4 && options.previewFactor != 8) {
+                    std::cerr << std::format("Invalid preview factor (expected 2, 4 or 8): {}\n", *value);
+                    return {};
+                }
+            } else if (argument == "--no-denoise") {
+                options.denoise = false;
+            } else if (argument == "--pin-threads") {
+                options.pinThreads = true;
+            } else if (argument == "--numa") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                if (*value == "replicate") {
+                    options.numaPlacement = NumaPlacement::Replicate;
+                } else if (*value == "interleave") {
+                    options.numaPlacement = NumaPlacement::Interleave;
+                } else {
+                    std::cerr << std::format("Invalid NUMA placement (expected replicate or interleave): {}\n", *value);
+                    return {};
+                }
+            } else if (argument == "--ground-texture") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.groundTexturePath = std::string{ *value };
+            } else if (argument == "--environment") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.environmentPath = std::string{ *value };
+            } else if (argument == "--geometry") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.geometryPath = std::string{ *value };
+            } else if (argument == "--geometry-budget") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.geometryBudgetMiB)) {
+                    return {};
+                }
+            } else if (argument == "--write-geometry") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.writeGeometryPath = std::string{ *value };
+            } else if (argument == "--chunk-size") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.spheresPerChunk)) {
+                    return {};
+                }
+                if (options.spheresPerChunk == 0) {
+                    std::cerr << "The chunk size must be positive\n";
+                    return {};
+                }
+            } else if (argument == "--resume") {
+                options.resume = true;
+            } else if (argument == "--checkpoint") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.checkpointPath = std::string{ *value };
+            } else if (argument == "--checkpoint-interval") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.checkpointIntervalSeconds)) {
+                    return {};
+                }
+            } else if (argument == "--coordinator") {
+                const auto value = nextArgument();
+                std::uint16_t port = 0;
+                if (!value || !parseNumber(*value, port)) {
+                    return {};
+                }
+                options.coordinatorPort = port;
+            } else if (argument == "--loopback-workers") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.numLoopbackWorkers)) {
+                    return {};
+                }
+            } else if (argument == "--worker") {
+                const auto value = nextArgument();
+                if (!value || !parseAddress(*value, options.workerHost, options.workerPort)) {
+                    return {};
+                }
+            } else if (argument == "--server") {
+                const auto value = nextArgument();
+                std::uint16_t port = 0;
+                if (!value || !parseNumber(*value, port)) {
+                    return {};
+                }
+                options.serverPort = port;
+            } else if (argument == "--client") {
+                const auto value = nextArgument();
+                if (!value || !parseAddress(*value, options.clientHost, options.clientPort)) {
+                    return {};
+                }
+            } else if (argument == "--scene") {
+                const auto value = nextArgument();
+                if (!value) {
+                    return {};
+                }
+                options.sceneName = std::string{ *value };
+            } else if (argument == "--priority") {
+                const auto value = nextArgument();
+                if (!value || !parseNumber(*value, options.priority)) {
+                    return {};
+                }
+            } else {
+                std::cerr << std::format("Unknown option: {}\n", argument);
+                printUsage();
+                return {};
+            }
+        }
+        if (options.numLoopbackWorkers > 0 && !options.coordinatorPort) {
+            std::cerr << "--loopback-workers can only be used together with --coordinator\n";
+            return {};
+        }
+        const auto numModes = (options.coordinatorPort ? 1 : 0) + (options.workerHost ? 1 : 0) +
+                              (options.serverPort ? 1 : 0) + (options.clientHost ? 1 : 0);
+        if (numModes > 1) {
+            std::cerr << "--coordinator, --worker, --server and --client cannot be combined\n";
+            return {};
+        }
+        if (options.previewFactor > 0 && numModes > 0) {
+            std::cerr << "--preview can only be used when rendering locally\n";
+            return {};
+        }
+        if ((options.pinThreads || options.numaPlacement != NumaPlacement::None) && numModes > 0) {
+            std::cerr << "--pin-threads and --numa can only be used when rendering locally\n";
+            return {};
+        }
+        if (options.geometryPath && numModes > 0) {
+            std::cerr << "--geometry can only be used when rendering locally\n";
+            return {};
+        }
+        if (options.geometryPath && options.groundTexturePath) {
+            std::cerr << "--ground-texture cannot be used with --geometry\n";
+            return {};
+        }
+        if (options.goldenImagePath && (options.serverPort || options.workerHost)) {
+            std::cerr << "--compare cannot be used with --server or --worker\n";
+            return {};
+        }
+        if (options.resume && (options.serverPort || options.clientHost)) {
+            std::cerr << "--resume cannot be used with --server or --client\n";
+            return {};
+        }
+        if (options.imageWidth <= 0 || options.samplesPerPixel == 0) {
+            std::cerr << "The image width and the number of samples must be positive\n";
+            return {};
+        }
+        return options;
+    }
+
+    static void printUsage() {
+        std::cerr << "Usage: RayTracingInOneWeekend [options]\n"
+                     "  --width <pixels>               width of the image (default: 1200)\n"
+                     "  --samples <count>              samples per pixel (default: 32)\n"
+                     "  --look-from <x>,<y>,<z>        position of the camera (default: 13,2,3)\n"
+                     "  --look-at <x>,<y>,<z>          point the camera looks at (default: 0,0,0)\n"
+                     "  --sampler <name>               random, sobol or blue-noise (default: sobol)\n"
+                     "  --wavefront                    trace all paths of a tile bounce by bounce, sorted by material\n"
+                     "  --bvh <none|object|spatial>    acceleration structure of the scene (default: spatial)\n"
+                     "  --threads <count>              render threads (default: 7/8 of the hardware threads)\n"
+                     "  --compare <path>               fail unless the written image is identical to this one\n"
+                     "  --crop <x>,<y>,<w>,<h>         only render this part of the image (pixels from the top left)\n"
+                     "  --preview <2|4|8>              write progressively refined low resolution previews first\n"
+                     "  --no-denoise                   write the image without running the denoiser\n"
+                     "  --pin-threads                  pin every render thread to its own CPU\n"
+                     "  --numa <replicate|interleave>  copy the scene to every NUMA node or spread it over them\n"
+                     "  --ground-texture <path>        image file that is repeated over the ground\n"
+                     "  --environment <path>           equirectangular (HDR) image that lights the scene\n"
+                     "  --geometry <path>              stream the spheres from a geometry file, not the demo scene\n"
+                     "  --geometry-budget <MiB>        memory for mapping the geometry file (default: 1024)\n"
+                     "  --write-geometry <path>        write the demo scene into a geometry file and exit\n"
+                     "  --chunk-size <spheres>         spheres per chunk of a written geometry file (default: 1024)\n"
+                     "  --resume                       continue the render stored in the checkpoint file\n"
+                     "  --checkpoint <path>            checkpoint file (default: raytracer.checkpoint)\n"
+                     "  --checkpoint-interval <sec>    minimum time between two checkpoints (default: 60)\n"
+                     "  --coordinator <port>           distribute the image to workers that connect to this port\n"
+                     "  --loopback-workers <count>     start workers inside the coordinator process (for testing)\n"
+                     "  --worker <host>:<port>         render tiles for the coordinator at the given address\n"
+                     "  --server <port>                run a render server for clients on this machine\n"
+                     "  --client <host>:<port>         let the render server at the given address render the image\n"
+                     "  --scene <name>                 name of the scene on the render server (default: demo)\n"
+                     "  --priority <value>             jobs with higher priorities are rendered first (default: 0)\n";
+    }
+
+private:
+    [[nodiscard]] static bool parseAddress(const std::string_view text,
+                                           std::optional<std::string>& host,
+                                           std::string& port) {
+        const auto separator = text.rfind(':');
+        if (separator == std::string_view::npos || separator == 0 || separator + 1 == text.size()) {
+            std::cerr << std::format("Invalid address (expected <host>:<port>): {}\n", text);
+            return false;
+        }
+        host = std::string{ text.substr(0, separator) };
+        port = std::string{ text.substr(separator + 1) };
+        return true;
+    }
+
+    [[nodiscard]] static bool parseVector(const std::string_view text, Vec3& result) {
+        const auto firstSeparator = text.find(',');
+        const auto secondSeparator = text.find(',', firstSeparator == std::string_view::npos ? 0 : firstSeparator + 1);
+        if (firstSeparator == std::string_view::npos || secondSeparator == std::string_view::npos) {
+            std::cerr << std::format("Invalid vector (expected <x>,<y>,<z>): {}\n", text);
+            return false;
+        }
+        return parseNumber(text.substr(0, firstSeparator), result.x) &&
+               parseNumber(text.substr(firstSeparator + 1, secondSeparator - firstSeparator - 1), result.y) &&
+               parseNumber(text.substr(secondSeparator + 1), result.z);
+    }
+
+    [[nodiscard]] static bool parseCropRectangle(const std::string_view text, CropRectangle& result) {
+        std::vector<std::string_view> parts;
+        std::size_t start = 0;
+        while (true) {
+            const auto separator = text.find(',', start);
+            parts.push_back(text.substr(start, separator == std::string_view::npos ? separator : separator - start));
+            if (separator == std::string_view::npos) {
+                break;
+            }
+            start = separator + 1;
+        }
+        if (parts.size() != 4) {
+            std::cerr << std::format("Invalid crop window (expected <x>,<y>,<width>,<height>): {}\n", text);
+            return false;
+        }
+        if (!parseNumber(parts[0], result.x) || !parseNumber(parts[1], result.y) ||
+            !parseNumber(parts[2], result.width) || !parseNumber(parts[3], result.height)) {
+            return false;
+        }
+        if (result.x < 0 || result.y < 0 || result.width <= 0 || result.height <= 0) {
+            std::cerr << std::format("The crop window must have a positive size and lie inside the image: {}\n", text);
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    [[nodiscard]] static bool parseNumber(const std::string_view text, T& result) {
+        const auto [end, errorCode] = std::from_chars(text.data(), text.data() + text.size(), result);
+        if (errorCode != std::errc{} || end != text.data() + text.size()) {
+            std::cerr << std::format("Invalid number: {}\n", text);
+            return false;
+        }
+        return true;
+    }
+};
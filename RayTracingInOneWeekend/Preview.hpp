@@ -0,0 +1,83 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Color.hpp"
+#include "FrameBuffer.hpp"
+#include "Render.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Low resolution previews of a render. The image is rendered at 1/factor of the final resolution with only a few
+// samples per pixel, which takes about 1/(factor^2) of the time per sample, and is scaled up to the size of the crop
+// window of the final render. Rendering the previews with decreasing factors refines the image progressively.
+namespace Preview {
+    // settings for rendering the same view (and crop window) at 1/factor of the resolution
+    [[nodiscard]] inline RenderSettings createSettings(const RenderSettings& settings,
+                                                       const int factor,
+                                                       const std::uint32_t samplesPerPixel) {
+        assert(factor >= 1);
+        auto result = settings;
+        result.imageWidth = std::max(1, settings.imageWidth / factor);
+        result.imageHeight = std::max(1, settings.imageHeight / factor);
+        result.samplesPerPixel = samplesPerPixel;
+        // the scaled crop window contains every preview pixel that overlaps the original crop window
+        const auto scaleDown = [](const int value, const int size, const int scaledSize) {
+            return static_cast<int>(static_cast<std::int64_t>(value) * scaledSize / size);
+        };
+        const auto scaleUp = [](const int value, const int size, const int scaledSize) {
+            return static_cast<int>((static_cast<std::int64_t>(value) * scaledSize + size - 1) / size);
+        };
+        const auto& crop = settings.cropWindow;
+        result.cropWindow = Tile{ .startX{ scaleDown(crop.startX, settings.imageWidth, result.imageWidth) },
+                                  .startY{ scaleDown(crop.startY, settings.imageHeight, result.imageHeight) },
+                                  .endX{ scaleUp(crop.endX, settings.imageWidth, result.imageWidth) },
+                                  .endY{ scaleUp(crop.endY, settings.imageHeight, result.imageHeight) } };
+        return result;
+    }
+
+    // Bilinearly scales the resolved colors of a preview frame buffer (rendered with previewSettings) up to the crop
+    // window of the final settings.
+    [[nodiscard]] inline std::vector<Color> upscale(const FrameBuffer& preview,
+                                                    const RenderSettings& previewSettings,
+                                                    const RenderSettings& settings) {
+        const auto& previewCrop = previewSettings.cropWindow;
+        const auto& crop = settings.cropWindow;
+        assert(preview.width == previewCrop.width() && preview.height == previewCrop.height());
+        const auto scaleX = static_cast<double>(previewSettings.imageWidth) / static_cast<double>(settings.imageWidth);
+        const auto scaleY =
+                static_cast<double>(previewSettings.imageHeight) / static_cast<double>(settings.imageHeight);
+        // position of the pixel center in the preview frame buffer, clamped to the centers of its border pixels
+        const auto toPreview = [](const int value, const double scale, const int origin, const int size) {
+            const auto position = (static_cast<double>(value) + 0.5) * scale - 0.5 - static_cast<double>(origin);
+            return std::clamp(position, 0.0, static_cast<double>(size - 1));
+        };
+        std::vector<Color> result(static_cast<std::size_t>(crop.width()) * static_cast<std::size_t>(crop.height()));
+        for (auto y = crop.startY; y < crop.endY; ++y) {
+            const auto previewY = toPreview(y, scaleY, previewCrop.startY, preview.height);
+            const auto y0 = static_cast<int>(previewY);
+            const auto y1 = std::min(y0 + 1, preview.height - 1);
+            const auto fractionY = previewY - static_cast<double>(y0);
+            for (auto x = crop.startX; x < crop.endX; ++x) {
+                const auto previewX = toPreview(x, scaleX, previewCrop.startX, preview.width);
+                const auto x0 = static_cast<int>(previewX);
+                const auto x1 = std::min(x0 + 1, preview.width - 1);
+                const auto fractionX = previewX - static_cast<double>(x0);
+                const auto& color = preview.color;
+                const auto bottom = (1.0 - fractionX) * color[preview.index(x0, y0)] +
+                                    fractionX * color[preview.index(x1, y0)];
+                const auto top = (1.0 - fractionX) * color[preview.index(x0, y1)] +
+                                 fractionX * color[preview.index(x1, y1)];
+                result[static_cast<std::size_t>(y - crop.startY) * static_cast<std::size_t>(crop.width()) +
+                       static_cast<std::size_t>(x - crop.startX)] = (1.0 - fractionY) * bottom + fractionY * top;
+            }
+        }
+        return result;
+    }
+}// namespace Preview
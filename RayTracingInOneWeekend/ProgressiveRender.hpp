@@ -0,0 +1,206 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Color.hpp"
+#include "FrameBuffer.hpp"
+#include "Integrator.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Scene.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Render that runs on its own threads until it is complete or stopped, for viewers that show the image while it
+// converges. Pass p brings every pixel to min(2^p, samplesPerPixel) samples, so the first passes are fast and the
+// later ones refine the whole image evenly. Whenever a thread finishes a tile, it publishes the resolved, gamma
+// corrected pixels of the tile as 8 bit RGBA. The viewer polls the tiles that changed since it last looked, it never
+// waits for the render threads except for copying a single tile.
+class ProgressiveRender final {
+public:
+    // the world must outlive the render
+    ProgressiveRender(const World& world,
+                      const RenderSettings& settings,
+                      const RenderTileFunction renderTile,
+                      const unsigned int numThreads,
+                      const int tileSize)
+        : mWorld{ world },
+          mSettings{ settings },
+          mRenderTile{ renderTile },
+          mFrameBuffer{ settings.cropWindow.width(), settings.cropWindow.height() },
+          mSamplerPrototype{ createSampler(settings.samplerType) },
+          mThreadStatistics(std::max(numThreads, 1U)) {
+        for (const auto& tile : createTiles(settings.cropWindow, tileSize)) {
+            auto publishedTile = std::make_unique<PublishedTile>();
+            publishedTile->tile = tile;
+            const auto numPixels = static_cast<std::size_t>(tile.width()) * static_cast<std::size_t>(tile.height());
+            publishedTile->rgba.resize(numPixels * 4);
+            mTiles.push_back(std::move(publishedTile));
+        }
+        mNumPasses = 1;
+        while (passEndSample(mNumPasses - 1) < settings.samplesPerPixel) {
+            ++mNumPasses;
+        }
+        mFinishedTilesPerPass = std::vector<std::atomic<std::size_t>>(mNumPasses);
+        for (std::size_t i = 0; i < mThreadStatistics.size(); ++i) {
+            mThreads.emplace_back([this, i](const std::stop_token stopToken) { renderLoop(stopToken, i); });
+        }
+    }
+
+    ProgressiveRender(const ProgressiveRender&) = delete;
+    ProgressiveRender& operator=(const ProgressiveRender&) = delete;
+
+    ~ProgressiveRender() {
+        stop();
+    }
+
+    // the threads finish the tiles they are working on, the image keeps the samples of all finished tiles
+    void stop() {
+        for (auto& thread : mThreads) {
+            thread.request_stop();
+        }
+        for (auto& thread : mThreads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    [[nodiscard]] int width() const {
+        return mFrameBuffer.width;
+    }
+
+    [[nodiscard]] int height() const {
+        return mFrameBuffer.height;
+    }
+
+    // samples per pixel that every pixel has reached
+    [[nodiscard]] std::uint32_t completedSamples() const {
+        std::size_t completedPasses = 0;
+        while (completedPasses < mNumPasses && isPassFinished(completedPasses)) {
+            ++completedPasses;
+        }
+        return completedPasses == 0 ? 0U : passEndSample(completedPasses - 1);
+    }
+
+    [[nodiscard]] bool isFinished() const {
+        return isPassFinished(mNumPasses - 1);
+    }
+
+    // Calls upload(x, y, width, height, rgba) for every tile whose pixels changed since the last call and returns
+    // their number. The position is relative to the bottom left corner of the frame buffer, rgba holds the rows of
+    // the tile from the bottom to the top. Must not be called from several threads at once.
+    template<typename Upload>
+    std::size_t uploadChangedTiles(Upload&& upload) {
+        std::size_t result = 0;
+        for (auto& publishedTile : mTiles) {
+            const auto version = publishedTile->version.load(std::memory_order_acquire);
+            if (version == publishedTile->uploadedVersion) {
+                continue;
+            }
+            const auto& tile = publishedTile->tile;
+            {
+                const auto lock = std::scoped_lock{ publishedTile->pixelsMutex };
+                upload(tile.startX - mSettings.cropWindow.startX, tile.startY - mSettings.cropWindow.startY,
+                       tile.width(), tile.height(), std::span<const std::uint8_t>{ publishedTile->rgba });
+            }
+            publishedTile->uploadedVersion = version;
+            ++result;
+        }
+        return result;
+    }
+
+    // must not be called while the render is running
+    [[nodiscard]] RenderStatistics statistics() const {
+        RenderStatistics result;
+        for (const auto& statistics : mThreadStatistics) {
+            result += statistics;
+        }
+        return result;
+    }
+
+private:
+    struct PublishedTile {
+        Tile tile;
+        // held while rendering, keeps two passes of the same tile from running at once
+        std::mutex renderMutex;
+        std::mutex pixelsMutex;
+        std::vector<std::uint8_t> rgba;
+        std::atomic<std::uint64_t> version{ 0 };
+        // only used by the viewer thread
+        std::uint64_t uploadedVersion{ 0 };
+    };
+
+    [[nodiscard]] bool isPassFinished(const std::size_t pass) const {
+        return mFinishedTilesPerPass[pass].load(std::memory_order_acquire) == mTiles.size();
+    }
+
+    [[nodiscard]] std::uint32_t passEndSample(const std::size_t pass) const {
+        constexpr auto maxShift = std::size_t{ 31 };
+        return std::min(std::uint32_t{ 1 } << std::min(pass, maxShift), mSettings.samplesPerPixel);
+    }
+
+    // the tasks are the tiles of all passes in order, taken by whichever thread is free
+    void renderLoop(const std::stop_token stopToken, const std::size_t threadIndex) {
+        const auto sampler = mSamplerPrototype->clone();
+        const auto numTasks = mNumPasses * mTiles.size();
+        while (!stopToken.stop_requested()) {
+            const auto task = mNextTask.fetch_add(1, std::memory_order_relaxed);
+            if (task >= numTasks) {
+                break;
+            }
+            const auto pass = task / mTiles.size();
+            auto& publishedTile = *mTiles[task % mTiles.size()];
+            {
+                const auto lock = std::scoped_lock{ publishedTile.renderMutex };
+                // every tile owns its part of the frame buffer, the mutex orders the passes of the same tile
+                mRenderTile(publishedTile.tile, mWorld, mSettings, passEndSample(pass), *sampler,
+                            mThreadStatistics[threadIndex], mFrameBuffer, mSettings.cropWindow.startX,
+                            mSettings.cropWindow.startY);
+                publish(publishedTile);
+            }
+            mFinishedTilesPerPass[pass].fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void publish(PublishedTile& publishedTile) {
+        const auto& tile = publishedTile.tile;
+        const auto lock = std::scoped_lock{ publishedTile.pixelsMutex };
+        for (auto y = tile.startY; y < tile.endY; ++y) {
+            for (auto x = tile.startX; x < tile.endX; ++x) {
+                const auto index = mFrameBuffer.index(x - mSettings.cropWindow.startX, y - mSettings.cropWindow.startY);
+                const auto sampleCount = mFrameBuffer.sampleCount[index];
+                const auto color = sampleCount == 0 ? Color{}
+                                                    : mFrameBuffer.color[index] / static_cast<double>(sampleCount);
+                writeColor(publishedTile.rgba, static_cast<std::size_t>(tile.width()), x - tile.startX,
+                           y - tile.startY, Color{ std::sqrt(color.r), std::sqrt(color.g), std::sqrt(color.b) });
+            }
+        }
+        publishedTile.version.fetch_add(1, std::memory_order_release);
+    }
+
+    const World& mWorld;
+    RenderSettings mSettings;
+    RenderTileFunction mRenderTile;
+    FrameBuffer mFrameBuffer;
+    std::unique_ptr<Sampler> mSamplerPrototype;
+    std::vector<std::unique_ptr<PublishedTile>> mTiles;
+    std::size_t mNumPasses{ 0 };
+    std::atomic<std::size_t> mNextTask{ 0 };
+    std::vector<std::atomic<std::size_t>> mFinishedTilesPerPass;
+    std::vector<RenderStatistics> mThreadStatistics;
+    // last member, so that the threads are stopped before anything they use is destroyed
+    std::vector<std::jthread> mThreads;
+};
@@ -17,4 +17,12 @@ struct Ray {
 
     const Point3 origin;
     const Vec3 direction;
-};
\ No newline at end of file
+};
+
+// rays through the neighboring pixels in x and y direction, used to estimate the footprint of a camera ray
+struct RayDifferential {
+    Point3 originX;
+    Vec3 directionX;
+    Point3 originY;
+    Vec3 directionY;
+};
@@ -0,0 +1,72 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Material.hpp"
+#include "Ray.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+// cone around a ray, its width grows linearly with the distance from the origin of the ray
+struct RayCone {
+    double width;
+    double spreadAngle;
+};
+
+// Estimate of the area that a ray represents, used to select the mip level of texture lookups. Camera rays carry ray
+// differentials, the footprint at their first intersection is where the rays through the neighboring pixels hit the
+// tangent plane of the surface. Every scattered ray continues as a cone whose spread angle is widened by the material.
+struct RayFootprint {
+    // glancing angles stretch the footprint, but not without limits
+    static constexpr auto minCosine = 0.05;
+
+    std::optional<RayDifferential> differential;
+    RayCone cone;
+
+    [[nodiscard]] static RayFootprint fromCameraRay(const Ray& ray, const RayDifferential& differential) {
+        const auto spreadAngle = std::max((differential.directionX - ray.direction).length(),
+                                          (differential.directionY - ray.direction).length());
+        return RayFootprint{ .differential{ differential }, .cone{ .width{ 0.0 }, .spreadAngle{ spreadAngle } } };
+    }
+
+    // width of the footprint at the intersection that lies at the distance t along the ray
+    [[nodiscard]] double widthAt(const Ray& ray, const double t, const IntersectionInfo& intersectionInfo) const {
+        if (differential) {
+            const auto offsetX =
+                    intersectTangentPlane(differential->originX, differential->directionX, intersectionInfo);
+            const auto offsetY =
+                    intersectTangentPlane(differential->originY, differential->directionY, intersectionInfo);
+            if (offsetX && offsetY) {
+                return std::max((*offsetX - intersectionInfo.intersectionPoint).length(),
+                                (*offsetY - intersectionInfo.intersectionPoint).length());
+            }
+        }
+        const auto cosine = std::abs(ray.direction.dot(intersectionInfo.normal));
+        return (cone.width + cone.spreadAngle * t) / std::sqrt(std::max(cosine, minCosine));
+    }
+
+    // footprint of a ray that is scattered at an intersection where this footprint has the given width
+    [[nodiscard]] RayFootprint scattered(const double width, const double additionalSpreadAngle) const {
+        return RayFootprint{ .differential{},
+                             .cone{ .width{ width }, .spreadAngle{ cone.spreadAngle + additionalSpreadAngle } } };
+    }
+
+private:
+    [[nodiscard]] static std::optional<Point3> intersectTangentPlane(const Point3& origin,
+                                                                     const Vec3& direction,
+                                                                     const IntersectionInfo& intersectionInfo) {
+        const auto& normal = intersectionInfo.normal;
+        const auto denominator = normal.dot(direction);
+        if (std::abs(denominator) < minCosine) {
+            return {};
+        }
+        const auto t = normal.dot(intersectionInfo.intersectionPoint - origin) / denominator;
+        if (t < 0.0) {
+            return {};
+        }
+        return origin + t * direction;
+    }
+};
@@ -0,0 +1,318 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Camera.hpp"
+#include "Color.hpp"
+#include "FrameBuffer.hpp"
+#include "Ray.hpp"
+#include "RayFootprint.hpp"
+#include "Sampler.hpp"
+#include "Scene.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// rectangle of pixels [startX, endX) x [startY, endY) of the image
+struct Tile {
+    int startX;
+    int startY;
+    int endX;
+    int endY;
+
+    [[nodiscard]] int width() const {
+        return endX - startX;
+    }
+
+    [[nodiscard]] int height() const {
+        return endY - startY;
+    }
+
+    [[nodiscard]] bool isEmpty() const {
+        return width() <= 0 || height() <= 0;
+    }
+
+    [[nodiscard]] bool contains(const Tile& other) const {
+        return other.startX >= startX && other.startY >= startY && other.endX <= endX && other.endY <= endY;
+    }
+
+    [[nodiscard]] static Tile wholeImage(const int imageWidth, const int imageHeight) {
+        return Tile{ .startX{ 0 }, .startY{ 0 }, .endX{ imageWidth }, .endY{ imageHeight } };
+    }
+};
+
+// how the paths of a tile are traced, see Wavefront.hpp
+enum class PathScheduling : std::uint32_t {
+    // one path after the other from the camera to its end
+    PerPath,
+    // all paths of the tile advance one bounce at a time
+    Wavefront,
+};
+
+struct RenderSettings {
+    int imageWidth;
+    int imageHeight;
+    std::uint32_t samplesPerPixel;
+    int maxDepth;
+    SamplerType samplerType;
+    CameraSettings camera;
+    // part of the image that is rendered, frame buffers only cover this part
+    Tile cropWindow;
+    PathScheduling pathScheduling{ PathScheduling::PerPath };
+};
+
+struct TileTime {
+    Tile tile;
+    double seconds;
+};
+
+// everything that was measured while rendering an image
+struct RenderReport {
+    RenderStatistics statistics;
+    std::vector<TileTime> tileTimes;
+};
+
+// splits the region of the image into tiles of at most tileSize x tileSize pixels, row by row
+[[nodiscard]] inline std::vector<Tile> createTiles(const Tile& region, const int tileSize) {
+    std::vector<Tile> result;
+    for (int startY = region.startY; startY < region.endY; startY += tileSize) {
+        for (int startX = region.startX; startX < region.endX; startX += tileSize) {
+            result.push_back(Tile{ .startX{ startX },
+                                   .startY{ startY },
+                                   .endX{ std::min(startX + tileSize, region.endX) },
+                                   .endY{ std::min(startY + tileSize, region.endY) } });
+        }
+    }
+    return result;
+}
+
+[[nodiscard]] inline Color backgroundGradient(const Ray& ray) {
+    const auto normalizedDirection = ray.direction.normalized();
+    const auto colorInterpolationParam = 0.5 * (normalizedDirection.y + 1.0);
+    return (1.0 - colorInterpolationParam) * Color{ 1.0, 1.0, 1.0 } + colorInterpolationParam * Color{ 0.5, 0.7, 1.0 };
+}
+
+[[nodiscard]] inline Color background(const World& world, const Ray& ray) {
+    return world.environment ? world.environment->radiance(ray.direction) : backgroundGradient(ray);
+}
+
+// weight of a sample taken with the density samplePdf when otherPdf is the density of the other strategy
+[[nodiscard]] inline double powerHeuristic(const double samplePdf, const double otherPdf) {
+    const auto sampleSquared = samplePdf * samplePdf;
+    return sampleSquared / (sampleSquared + otherPdf * otherPdf);
+}
+
+// Returns the distance to the closest intersection and the index of the object that was hit. ObjectType can be the
+// concrete type of all objects of the world, which saves the virtual calls (see Integrator.hpp).
+template<typename ObjectType = Hittable>
+[[nodiscard]] std::optional<std::pair<double, std::size_t>> closestHit(const World& world,
+                                                                       const Ray& ray,
+                                                                       RenderStatistics& statistics) {
+    if (world.bvh) {
+        return world.bvh->closestHit<ObjectType>(world.objects, ray, 0.001, std::numeric_limits<double>::max(),
+                                                 statistics);
+    }
+    statistics.intersectionTests += world.objects.size();
+    std::optional<std::pair<double, std::size_t>> result;
+    for (std::size_t i = 0; i < world.objects.size(); ++i) {
+        const auto& object = static_cast<const ObjectType&>(*world.objects[i]);
+        const auto hitResult = object.hit(ray, 0.001, std::numeric_limits<double>::max());
+        if (hitResult && (!result || hitResult.value() < result->first)) {
+            result = std::pair{ hitResult.value(), i };
+        }
+    }
+    return result;
+}
+
+template<typename ObjectType = Hittable>
+[[nodiscard]] bool isOccluded(const World& world, const Ray& ray, RenderStatistics& statistics) {
+    ++statistics.shadowRays;
+    if (world.bvh) {
+        return world.bvh->anyHit<ObjectType>(world.objects, ray, 0.001, std::numeric_limits<double>::max(), statistics);
+    }
+    for (const auto& object : world.objects) {
+        ++statistics.intersectionTests;
+        if (static_cast<const ObjectType&>(*object).hit(ray, 0.001, std::numeric_limits<double>::max())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Light from the environment map arriving directly at the intersection, sampled proportional to the environment and
+// weighted against the chance that the scattered ray of the material finds the same light (multiple importance
+// sampling). The material is the one of the intersection, possibly downcast to its concrete type.
+template<typename ObjectType = Hittable, typename ConcreteMaterial, typename SamplerType>
+[[nodiscard]] Color sampleEnvironment(const World& world,
+                                      const IntersectionInfo& intersectionInfo,
+                                      const ConcreteMaterial& material,
+                                      SamplerType& sampler,
+                                      RenderStatistics& statistics) {
+    const auto lightSample = world.environment->sample(sampler.get2D());
+    const auto materialPdf = material.pdf(intersectionInfo, lightSample.direction);
+    if (lightSample.pdf <= 0.0 || materialPdf <= 0.0 ||
+        isOccluded<ObjectType>(world, Ray{ intersectionInfo.intersectionPoint, lightSample.direction }, statistics)) {
+        return Color{};
+    }
+    return material.evaluate(intersectionInfo, lightSample.direction) * lightSample.radiance *
+           (powerHeuristic(lightSample.pdf, materialPdf) / lightSample.pdf);
+}
+
+// If given, aovSample receives the information about the first hit of the ray. bounce is the number of rays of the
+// path that have been traced before this one. scatterPdf is the density with which the material at the origin of the
+// ray chose its direction, 0 for camera rays and specular materials.
+[[nodiscard]] inline Color rayColor(const Ray& ray,
+                                    const RayFootprint& footprint,
+                                    const World& world,
+                                    int depth,
+                                    Sampler& sampler,
+                                    RenderStatistics& statistics,
+                                    AovSample* const aovSample = nullptr,
+                                    const int bounce = 0,
+                                    const double scatterPdf = 0.0) {
+    if (depth <= 0) {
+        statistics.countPathEnd(bounce);
+        return Color{};
+    }
+    statistics.countRay(bounce);
+    const auto hit = closestHit(world, ray, statistics);
+    if (!hit) {
+        statistics.countPathEnd(bounce + 1);
+        const auto backgroundColor = background(world, ray);
+        if (aovSample != nullptr) {
+            *aovSample = AovSample{ .albedo{ backgroundColor }, .normal{}, .depth{ AovSample::missDepth } };
+        }
+        if (world.environment && scatterPdf > 0.0) {
+            // the environment has been sampled directly at the origin of this ray as well
+            return powerHeuristic(scatterPdf, world.environment->pdf(ray.direction)) * backgroundColor;
+        }
+        return backgroundColor;
+    }
+    const auto [t, hittableIndex] = *hit;
+    auto intersectionInfo = world.objects[hittableIndex]->getIntersectionInfo(ray, t);
+    intersectionInfo.footprintWidth = footprint.widthAt(ray, t, intersectionInfo);
+    if (aovSample != nullptr) {
+        *aovSample = AovSample{ .albedo{ intersectionInfo.material->getAlbedo(intersectionInfo) },
+                                .normal{ intersectionInfo.normal },
+                                .depth{ t } };
+    }
+
+    const auto scatterResult = intersectionInfo.material->scatter(ray, intersectionInfo, sampler);
+    if (!scatterResult) {
+        statistics.countPathEnd(bounce + 1);
+        return Color{};
+    }
+    const auto directLight = (world.environment && scatterResult->pdf > 0.0)
+                                     ? sampleEnvironment(world, intersectionInfo, *intersectionInfo.material, sampler,
+                                                         statistics)
+                                     : Color{};
+    const auto scatteredFootprint = footprint.scattered(intersectionInfo.footprintWidth, scatterResult->spreadAngle);
+    return directLight + scatterResult->attenuation * rayColor(scatterResult->ray, scatteredFootprint, world,
+                                                               depth - 1, sampler, statistics, nullptr, bounce + 1,
+                                                               scatterResult->pdf);
+}
+
+namespace RenderDetail {
+    // The differentials of camera rays span the distance between two samples, not between two pixels, so that
+    // textures don't get blurrier than necessary with many samples per pixel. Returns the distance in s and t.
+    [[nodiscard]] inline std::pair<double, double> sampleSpacing(const RenderSettings& settings) {
+        const auto differentialScale =
+                std::max(0.125, 1.0 / std::sqrt(static_cast<double>(std::max(settings.samplesPerPixel, 1U))));
+        return { differentialScale / static_cast<double>(settings.imageWidth),
+                 differentialScale / static_cast<double>(settings.imageHeight) };
+    }
+
+    // camera ray with the position in the pixel and the point on the unit disk of the lens already drawn
+    [[nodiscard]] inline Ray cameraRay(const Camera& camera,
+                                       const RenderSettings& settings,
+                                       const int x,
+                                       const int y,
+                                       const std::pair<double, double>& spacing,
+                                       const Sample2D& pixelSample,
+                                       const Vec3& lensSample,
+                                       RayDifferential& differential) {
+        const auto u = (static_cast<double>(x) + pixelSample.u) / static_cast<double>(settings.imageWidth);
+        const auto v = (static_cast<double>(y) + pixelSample.v) / static_cast<double>(settings.imageHeight);
+        return camera.getRay(u, v, spacing.first, spacing.second, lensSample, differential);
+    }
+
+    // camera ray through a random position of the pixel (x, y), the sampler has to be started for this pixel sample
+    template<typename SamplerType>
+    [[nodiscard]] Ray cameraRay(const Camera& camera,
+                                const RenderSettings& settings,
+                                const int x,
+                                const int y,
+                                const std::pair<double, double>& spacing,
+                                SamplerType& sampler,
+                                RayDifferential& differential) {
+        const auto pixelSample = sampler.get2D();
+        const auto lensSample = Sampling::concentricDisk(sampler.get2D());
+        return cameraRay(camera, settings, x, y, spacing, pixelSample, lensSample, differential);
+    }
+
+    // Loop over the pixels and samples of a tile, shared by the generic and the specialized render kernels. tracePath
+    // is called with the camera ray, its footprint and the AOV sample to fill in and returns the radiance of the path.
+    template<typename SamplerType, typename TracePath>
+    double renderTile(const Tile& tile,
+                      const RenderSettings& settings,
+                      const std::uint32_t endSample,
+                      SamplerType& sampler,
+                      FrameBuffer& frameBuffer,
+                      const int originX,
+                      const int originY,
+                      TracePath&& tracePath) {
+        const auto startTime = std::chrono::steady_clock::now();
+        const Camera camera{ settings.camera };
+        const auto spacing = sampleSpacing(settings);
+        for (auto y = tile.startY; y < tile.endY; ++y) {
+            for (auto x = tile.startX; x < tile.endX; ++x) {
+                const auto index = frameBuffer.index(x - originX, y - originY);
+                const auto startSample = frameBuffer.sampleCount[index];
+                if (startSample >= endSample) {
+                    continue;
+                }
+                Color pixelColor{};
+                AovSample pixelAov{ .albedo{}, .normal{}, .depth{ 0.0 } };
+                for (auto sample = startSample; sample < endSample; ++sample) {
+                    sampler.startPixelSample(x, y, sample);
+                    RayDifferential differential;
+                    const auto ray = cameraRay(camera, settings, x, y, spacing, sampler, differential);
+                    AovSample aovSample;
+                    pixelColor += tracePath(ray, RayFootprint::fromCameraRay(ray, differential), aovSample);
+                    pixelAov.albedo += aovSample.albedo;
+                    pixelAov.normal += aovSample.normal;
+                    pixelAov.depth += aovSample.depth;
+                }
+                frameBuffer.addSamples(index, pixelColor, pixelAov, endSample - startSample);
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+}// namespace RenderDetail
+
+// Renders the pixels of the tile until every one of them has endSample samples and returns the time this took in
+// seconds. The frame buffer may cover only a part of the image, its bottom left pixel is the image pixel
+// (originX, originY). This is the generic kernel, see Integrator.hpp for the specialized ones.
+inline double renderTile(const Tile& tile,
+                         const World& world,
+                         const RenderSettings& settings,
+                         const std::uint32_t endSample,
+                         Sampler& sampler,
+                         RenderStatistics& statistics,
+                         FrameBuffer& frameBuffer,
+                         const int originX = 0,
+                         const int originY = 0) {
+    return RenderDetail::renderTile(tile, settings, endSample, sampler, frameBuffer, originX, originY,
+                                    [&](const Ray& ray, const RayFootprint& footprint, AovSample& aovSample) {
+                                        return rayColor(ray, footprint, world, settings.maxDepth, sampler, statistics,
+                                                        &aovSample);
+                                    });
+}
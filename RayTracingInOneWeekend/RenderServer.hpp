@@ -0,0 +1,554 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "FrameBuffer.hpp"
+#include "Integrator.hpp"
+#include "Network.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Scene.hpp"
+#include "Serialization.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Render server: a long-lived process that keeps uploaded scenes together with their World in memory and renders jobs
+// (camera, resolution and samples per pixel of a cached scene) for clients on the same machine. A job names its scene
+// and carries the fingerprint of its content (see Scene::fingerprint()), so a client whose scene differs from the cached one under the
+// same name is asked to upload it again instead of getting an image of the other scene. Jobs are queued by
+// priority, all render threads work on the tiles of the job with the highest priority. A job with a higher priority
+// that arrives while another one is rendering takes over the threads as soon as they have finished their current
+// tile. Finished tiles are streamed back to the client immediately.
+//
+// Messages (see Network.hpp for the framing):
+//   client -> server: UploadScene (SceneName + serialized Scene), SubmitJob (JobDescription)
+//   server -> client: SceneStored (empty), UnknownScene (empty, also if the fingerprint differs), JobAccepted (job id, number of tiles),
+//   TileResult (job id, Network::TileResultHeader and the pixels of the tile), JobFinished (job id),
+//   Error (text of the message)
+namespace RenderServerDetail {
+    enum class MessageType : std::uint32_t {
+        UploadScene,
+        SubmitJob,
+        SceneStored,
+        UnknownScene,
+        JobAccepted,
+        TileResult,
+        JobFinished,
+        Error,
+    };
+
+    using SceneName = std::array<char, 64>;
+
+    [[nodiscard]] inline std::string_view toStringView(const SceneName& name) {
+        const auto end = std::find(name.cbegin(), name.cend(), '\0');
+        return std::string_view{ name.data(), static_cast<std::size_t>(end - name.cbegin()) };
+    }
+
+    [[nodiscard]] inline std::optional<SceneName> toSceneName(const std::string_view name) {
+        // the name must leave room for the terminating zero
+        if (name.empty() || name.size() >= SceneName{}.size()) {
+            return {};
+        }
+        SceneName result{};
+        std::copy(name.cbegin(), name.cend(), result.begin());
+        return result;
+    }
+
+    struct JobAcceptedMessage {
+        std::uint64_t jobId;
+        std::uint32_t numTiles;
+    };
+
+    [[nodiscard]] inline std::vector<std::byte> encodeError(const std::string_view text) {
+        return Network::encodeMessage(MessageType::Error, std::as_bytes(std::span{ text.data(), text.size() }));
+    }
+}// namespace RenderServerDetail
+
+struct JobDescription {
+    RenderServerDetail::SceneName sceneName;
+    // see Scene::fingerprint(), filled in by RenderClient::render()
+    std::uint64_t sceneFingerprint;
+    RenderSettings settings;
+    // jobs with higher priorities are rendered first, jobs with the same priority in the order of their arrival
+    std::int32_t priority;
+};
+
+class RenderServer {
+public:
+    static constexpr int tileSize = 32;
+    static constexpr int maxImageDimension = 16384;
+    static constexpr int maxDepthLimit = 1000;
+
+    explicit RenderServer(const std::uint16_t port) : mPort{ port } {
+        Network::ignoreBrokenPipes();
+        mSockets.listen(port);
+        if (!mSockets.succeeded()) {
+            return;
+        }
+        mSockets.on_connection([this](const Socket socket, const IPAddress address) { onConnection(socket, address); });
+        mIsListening = true;
+    }
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    [[nodiscard]] bool isListening() const {
+        return mIsListening;
+    }
+
+    // serves clients until the process is terminated
+    void run(const unsigned int numThreads) {
+        assert(mIsListening);
+        std::vector<std::jthread> renderThreads;
+        for (unsigned int i = 0; i < numThreads; ++i) {
+            renderThreads.emplace_back([this](const std::stop_token stopToken) { renderJobs(stopToken); });
+        }
+        std::cout << std::format("Render server listening on port {} with {} threads\n", mPort, numThreads)
+                  << std::flush;
+        while (true) {
+            mReceivedData = false;
+            mSockets.update();
+            const auto sentData = sendFinishedTiles();
+            if (!mReceivedData && !sentData) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            }
+        }
+    }
+
+private:
+    struct CachedScene {
+        Scene scene;
+        World world;
+        std::uint64_t fingerprint;
+    };
+
+    struct Connection {
+        std::uint64_t id;
+        Network::MessageBuffer<RenderServerDetail::MessageType> receiveBuffer;
+    };
+
+    struct Job {
+        std::uint64_t id;
+        std::uint64_t connectionId;
+        JobDescription description;
+        std::shared_ptr<const CachedScene> scene;
+        RenderTileFunction renderTile;
+        std::deque<Tile> openTiles;
+        std::size_t numTiles;
+        std::size_t numFinishedTiles{ 0 };
+        bool isCancelled{ false };
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    // message that a render thread has produced for the client of a job
+    struct OutgoingMessage {
+        std::uint64_t connectionId;
+        std::vector<std::byte> message;
+    };
+
+    void onConnection(const Socket socket, const IPAddress address) {
+        // the server is meant for clients on the same machine only
+        if ((address.ip >> 24) != 127) {
+            std::cerr << "Rejected a connection from another machine\n";
+            auto rejectedSocket = socket;
+            tcp_close(&rejectedSocket);
+            return;
+        }
+        mSockets.add_already_connected_socket(socket);
+        if (!mSockets.succeeded()) {
+            return;
+        }
+        auto* const handle = mSockets.handle();
+        mSockets.on_data([this](Socket* const dataSocket, void* const data, const int size) {
+                    onData(dataSocket, data, size);
+                })
+                .on_error([this](Socket* const errorSocket) { onDisconnect(errorSocket); });
+        mConnections.emplace(handle, Connection{ .id{ mNextConnectionId++ }, .receiveBuffer{} });
+    }
+
+    void onDisconnect(Socket* const socket) {
+        const auto connection = mConnections.find(socket);
+        if (connection == mConnections.end()) {
+            return;
+        }
+        {
+            // tiles that are being rendered right now are finished, but their results are dropped
+            auto lock = std::scoped_lock{ mJobsMutex };
+            std::erase_if(mJobs, [&](const std::shared_ptr<Job>& job) {
+                if (job->connectionId != connection->second.id) {
+                    return false;
+                }
+                job->isCancelled = true;
+                std::cout << std::format("Job {} cancelled, the client has disconnected\n", job->id) << std::flush;
+                return true;
+            });
+        }
+        mConnections.erase(connection);
+    }
+
+    void onData(Socket* const socket, const void* const data, const int size) {
+        const auto connection = mConnections.find(socket);
+        if (connection == mConnections.end() || size <= 0) {
+            return;
+        }
+        mReceivedData = true;
+        auto& buffer = connection->second.receiveBuffer;
+        buffer.append(data, size);
+        while (const auto message = buffer.next()) {
+            if (!handleMessage(socket, connection->second, message->type, message->payload)) {
+                std::cerr << "Received an invalid message from a client\n";
+                socol_close(socket);
+                return;
+            }
+        }
+        if (buffer.isCorrupted()) {
+            socol_close(socket);
+        }
+    }
+
+    [[nodiscard]] bool handleMessage(Socket* const socket,
+                                     const Connection& connection,
+                                     const RenderServerDetail::MessageType type,
+                                     const std::span<const std::byte> payload) {
+        using RenderServerDetail::MessageType;
+        ByteReader reader{ payload };
+        switch (type) {
+            case MessageType::UploadScene: {
+                const auto name = reader.read<RenderServerDetail::SceneName>();
+                if (!name || RenderServerDetail::toStringView(*name).empty()) {
+                    return false;
+                }
+                storeScene(socket, std::string{ RenderServerDetail::toStringView(*name) },
+                           payload.subspan(sizeof(RenderServerDetail::SceneName)));
+                return true;
+            }
+            case MessageType::SubmitJob: {
+                const auto description = reader.read<JobDescription>();
+                if (!description) {
+                    return false;
+                }
+                submitJob(socket, connection, *description);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    void storeScene(Socket* const socket, std::string name, const std::span<const std::byte> sceneData) {
+        using RenderServerDetail::MessageType;
+        auto scene = Scene::deserialize(sceneData);
+        if (!scene) {
+            Network::send(socket, RenderServerDetail::encodeError("invalid scene data"));
+            return;
+        }
+        // jobs that are still rendering the previous version of the scene keep it alive
+        auto world = scene->buildWorld();
+        const auto fingerprint = scene->fingerprint();
+        std::cout << std::format("Stored scene '{}' ({} spheres, fingerprint {:016x})\n", name, scene->spheres.size(),
+                                 fingerprint)
+                  << std::flush;
+        mScenes.insert_or_assign(std::move(name), std::make_shared<const CachedScene>(
+                                                          CachedScene{ .scene{ std::move(*scene) },
+                                                                       .world{ std::move(world) },
+                                                                       .fingerprint{ fingerprint } }));
+        Network::send(socket, Network::encodeMessage(MessageType::SceneStored));
+    }
+
+    void submitJob(Socket* const socket, const Connection& connection, const JobDescription& description) {
+        using RenderServerDetail::MessageType;
+        const auto& settings = description.settings;
+        if (settings.imageWidth <= 0 || settings.imageHeight <= 0 || settings.imageWidth > maxImageDimension ||
+            settings.imageHeight > maxImageDimension || settings.samplesPerPixel == 0 || settings.maxDepth <= 0 ||
+            settings.maxDepth > maxDepthLimit || static_cast<std::uint32_t>(settings.samplerType) > 2 ||
+            static_cast<std::uint32_t>(settings.pathScheduling) > 1 ||
+            settings.cropWindow.isEmpty() ||
+            !Tile::wholeImage(settings.imageWidth, settings.imageHeight).contains(settings.cropWindow)) {
+            Network::send(socket, RenderServerDetail::encodeError("invalid render settings"));
+            return;
+        }
+        const auto sceneName = RenderServerDetail::toStringView(description.sceneName);
+        const auto scene = mScenes.find(std::string{ sceneName });
+        // another client may have stored a different scene under the same name
+        if (scene == mScenes.cend() || scene->second->fingerprint != description.sceneFingerprint) {
+            Network::send(socket, Network::encodeMessage(MessageType::UnknownScene));
+            return;
+        }
+
+        const auto tiles = createTiles(settings.cropWindow, tileSize);
+        const auto kernel = selectRenderKernel(settings, scene->second->world);
+        auto job = std::make_shared<Job>(Job{ .id{ mNextJobId++ },
+                                              .connectionId{ connection.id },
+                                              .description{ description },
+                                              .scene{ scene->second },
+                                              .renderTile{ kernel.renderTile },
+                                              .openTiles{ std::deque<Tile>(tiles.cbegin(), tiles.cend()) },
+                                              .numTiles{ tiles.size() },
+                                              .startTime{ std::chrono::steady_clock::now() } });
+        ByteWriter writer;
+        writer.write(RenderServerDetail::JobAcceptedMessage{ .jobId{ job->id },
+                                                             .numTiles{ static_cast<std::uint32_t>(tiles.size()) } });
+        Network::send(socket, Network::encodeMessage(MessageType::JobAccepted, writer.release()));
+        std::cout << std::format("Job {} accepted: scene '{}', {}x{}, {} spp, priority {}, kernel: {}\n", job->id,
+                                 sceneName, settings.imageWidth, settings.imageHeight, settings.samplesPerPixel,
+                                 description.priority, kernel.description)
+                  << std::flush;
+        {
+            auto lock = std::scoped_lock{ mJobsMutex };
+            const auto position = std::find_if(mJobs.cbegin(), mJobs.cend(), [&](const std::shared_ptr<Job>& other) {
+                return other->description.priority < description.priority;
+            });
+            mJobs.insert(position, std::move(job));
+        }
+        mJobsAvailable.notify_all();
+    }
+
+    void renderJobs(const std::stop_token& stopToken) {
+        using RenderServerDetail::MessageType;
+        while (true) {
+            std::shared_ptr<Job> job;
+            Tile tile;
+            {
+                auto lock = std::unique_lock{ mJobsMutex };
+                const auto findJob = [&]() {
+                    return std::find_if(mJobs.begin(), mJobs.end(),
+                                        [](const std::shared_ptr<Job>& candidate) {
+                                            return !candidate->openTiles.empty();
+                                        });
+                };
+                mJobsAvailable.wait(lock, stopToken, [&]() { return findJob() != mJobs.end(); });
+                if (stopToken.stop_requested()) {
+                    return;
+                }
+                job = *findJob();
+                tile = job->openTiles.front();
+                job->openTiles.pop_front();
+            }
+
+            const auto& settings = job->description.settings;
+            const auto sampler = createSampler(settings.samplerType);
+            FrameBuffer tileBuffer{ tile.width(), tile.height() };
+            RenderStatistics statistics;
+            const auto seconds = job->renderTile(tile, job->scene->world, settings, settings.samplesPerPixel,
+                                                 *sampler, statistics, tileBuffer, tile.startX, tile.startY);
+            ByteWriter writer;
+            writer.write(job->id);
+            Network::writeTileResult(
+                    writer,
+                    Network::TileResultHeader{ .tile{ tile }, .statistics{ statistics }, .seconds{ seconds } },
+                    tileBuffer);
+            auto message = Network::encodeMessage(MessageType::TileResult, writer.release());
+
+            auto lock = std::scoped_lock{ mJobsMutex, mOutboxMutex };
+            if (job->isCancelled) {
+                continue;
+            }
+            mOutbox.push_back(OutgoingMessage{ .connectionId{ job->connectionId }, .message{ std::move(message) } });
+            ++job->numFinishedTiles;
+            if (job->numFinishedTiles == job->numTiles) {
+                ByteWriter finishedWriter;
+                finishedWriter.write(job->id);
+                mOutbox.push_back(OutgoingMessage{
+                        .connectionId{ job->connectionId },
+                        .message{ Network::encodeMessage(MessageType::JobFinished, finishedWriter.release()) } });
+                std::erase(mJobs, job);
+                const auto jobSeconds =
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - job->startTime).count();
+                std::cout << std::format("Job {} finished after {:.2f} s\n", job->id, jobSeconds) << std::flush;
+            }
+        }
+    }
+
+    // sends the messages of the render threads to the clients that are still connected, returns true if any were sent
+    [[nodiscard]] bool sendFinishedTiles() {
+        std::vector<OutgoingMessage> outbox;
+        {
+            auto lock = std::scoped_lock{ mOutboxMutex };
+            std::swap(outbox, mOutbox);
+        }
+        for (const auto& [connectionId, message] : outbox) {
+            const auto connection = std::find_if(mConnections.cbegin(), mConnections.cend(), [&](const auto& entry) {
+                return entry.second.id == connectionId;
+            });
+            if (connection != mConnections.cend()) {
+                Network::send(connection->first, message);
+            }
+        }
+        return !outbox.empty();
+    }
+
+private:
+    std::uint16_t mPort;
+    bool mIsListening{ false };
+    bool mReceivedData{ false };
+    SocketCollection mSockets;
+    std::unordered_map<Socket*, Connection> mConnections;
+    std::uint64_t mNextConnectionId{ 0 };
+    std::uint64_t mNextJobId{ 0 };
+    // only used by the thread that runs the event loop
+    std::unordered_map<std::string, std::shared_ptr<const CachedScene>> mScenes;
+
+    std::mutex mJobsMutex;
+    std::condition_variable_any mJobsAvailable;
+    // sorted by priority, highest first
+    std::vector<std::shared_ptr<Job>> mJobs;
+
+    std::mutex mOutboxMutex;
+    std::vector<OutgoingMessage> mOutbox;
+};
+
+// Connection of a client to a render server.
+class RenderClient {
+public:
+    [[nodiscard]] bool connect(const std::string& host, const std::string& port) {
+        Network::ignoreBrokenPipes();
+        if (!mSocket.connect(host, port)) {
+            std::cerr << std::format("Unable to connect to the render server at {}:{}\n", host, port);
+            return false;
+        }
+        return true;
+    }
+
+    // Renders the job on the server and blocks until all tiles have been received. If the server does not know the
+    // scene yet (or has a different one under its name), it is uploaded first and stays cached on the server for later
+    // jobs. The fingerprint of the job is replaced by the one of the scene. The returned frame buffer covers the crop
+    // window of the job.
+    [[nodiscard]] std::optional<FrameBuffer> render(JobDescription job, const Scene& scene, RenderReport& report) {
+        using RenderServerDetail::MessageType;
+        job.sceneFingerprint = scene.fingerprint();
+        auto accepted = submit(job);
+        if (accepted && accepted->type == MessageType::UnknownScene) {
+            std::cout << std::format("Uploading scene '{}'\n", RenderServerDetail::toStringView(job.sceneName))
+                      << std::flush;
+            ByteWriter writer;
+            writer.write(job.sceneName);
+            writer.writeBytes(scene.serialize());
+            if (!send(Network::encodeMessage(MessageType::UploadScene, writer.release()))) {
+                return {};
+            }
+            const auto stored = receive(MessageType::SceneStored);
+            if (!stored) {
+                return {};
+            }
+            accepted = submit(job);
+        }
+        if (!accepted || !expect(*accepted, MessageType::JobAccepted)) {
+            return {};
+        }
+        ByteReader acceptedReader{ accepted->payload };
+        const auto acceptedMessage = acceptedReader.read<RenderServerDetail::JobAcceptedMessage>();
+        if (!acceptedMessage) {
+            return {};
+        }
+        std::cout << std::format("Job {} accepted, waiting for {} tiles...\n", acceptedMessage->jobId,
+                                 acceptedMessage->numTiles)
+                  << std::flush;
+
+        const auto& cropWindow = job.settings.cropWindow;
+        FrameBuffer frameBuffer{ cropWindow.width(), cropWindow.height() };
+        report = RenderReport{};
+        while (true) {
+            const auto message = Network::receiveMessage<MessageType>(mSocket);
+            if (!message) {
+                std::cerr << "Lost the connection to the render server\n";
+                return {};
+            }
+            if (message->type == MessageType::JobFinished) {
+                break;
+            }
+            if (!expect(*message, MessageType::TileResult)) {
+                return {};
+            }
+            ByteReader reader{ message->payload };
+            const auto jobId = reader.read<std::uint64_t>();
+            const auto header = reader.read<Network::TileResultHeader>();
+            if (!jobId || *jobId != acceptedMessage->jobId || !header ||
+                !Network::readTilePixels(reader, header->tile, frameBuffer, cropWindow.startX, cropWindow.startY)) {
+                std::cerr << "Received an invalid tile from the render server\n";
+                return {};
+            }
+            report.statistics += header->statistics;
+            report.tileTimes.push_back(TileTime{ .tile{ header->tile }, .seconds{ header->seconds } });
+        }
+        if (report.tileTimes.size() != acceptedMessage->numTiles) {
+            std::cerr << "The render server did not send all tiles\n";
+            return {};
+        }
+        return frameBuffer;
+    }
+
+private:
+    [[nodiscard]] bool send(const std::vector<std::byte>& message) {
+        if (mSocket.send_exact(message.data(), static_cast<std::uint32_t>(message.size())) == 0) {
+            std::cerr << "Unable to send to the render server\n";
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::optional<Network::Message<RenderServerDetail::MessageType>> submit(const JobDescription& job) {
+        ByteWriter writer;
+        writer.write(job);
+        if (!send(Network::encodeMessage(RenderServerDetail::MessageType::SubmitJob, writer.release()))) {
+            return {};
+        }
+        auto message = Network::receiveMessage<RenderServerDetail::MessageType>(mSocket);
+        if (!message) {
+            std::cerr << "Lost the connection to the render server\n";
+        }
+        return message;
+    }
+
+    [[nodiscard]] std::optional<Network::Message<RenderServerDetail::MessageType>> receive(
+            const RenderServerDetail::MessageType expectedType) {
+        auto message = Network::receiveMessage<RenderServerDetail::MessageType>(mSocket);
+        if (!message) {
+            std::cerr << "Lost the connection to the render server\n";
+            return {};
+        }
+        if (!expect(*message, expectedType)) {
+            return {};
+        }
+        return message;
+    }
+
+    // reports errors sent by the server
+    [[nodiscard]] static bool expect(const Network::Message<RenderServerDetail::MessageType>& message,
+                                     const RenderServerDetail::MessageType expectedType) {
+        if (message.type == expectedType) {
+            return true;
+        }
+        if (message.type == RenderServerDetail::MessageType::Error) {
+            std::cerr << std::format("Render server error: {}\n",
+                                     std::string_view{ reinterpret_cast<const char*>(message.payload.data()),
+                                                       message.payload.size() });
+        } else {
+            std::cerr << "Received an unexpected message from the render server\n";
+        }
+        return false;
+    }
+
+private:
+    TCPSocket mSocket;
+};
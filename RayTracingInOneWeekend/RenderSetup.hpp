@@ -0,0 +1,63 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Options.hpp"
+#include "Render.hpp"
+#include "Scene.hpp"
+#include "Texture.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+// The scene and the render settings that the options describe, shared by the command line tracer and the viewer of
+// OpenGLBasics, so that both render the same image for the same options.
+namespace RenderSetup {
+    inline constexpr int maxDepth = 50;
+    // the ground is the first sphere of the demo scene, one repetition of the texture covers about 3 x 3 units
+    inline constexpr double groundTextureRepeat = 1000.0;
+
+    [[nodiscard]] inline int imageHeight(const Options& options) {
+        return std::max(1, static_cast<int>(options.imageWidth / options.camera.aspectRatio));
+    }
+
+    [[nodiscard]] inline RenderSettings createRenderSettings(const Options& options, const Tile& cropWindow) {
+        return RenderSettings{ .imageWidth{ options.imageWidth },
+                               .imageHeight{ imageHeight(options) },
+                               .samplesPerPixel{ options.samplesPerPixel },
+                               .maxDepth{ maxDepth },
+                               .samplerType{ options.samplerType },
+                               .camera{ options.camera },
+                               .cropWindow{ cropWindow },
+                               .pathScheduling{ options.pathScheduling } };
+    }
+
+    // the demo scene with the ground texture and the environment map of the options, reports errors itself
+    [[nodiscard]] inline std::optional<Scene> createScene(const Options& options) {
+        auto scene = Scene::createDemoScene();
+        if (options.groundTexturePath) {
+            auto texture = TextureImage::load(*options.groundTexturePath);
+            if (!texture) {
+                std::cerr << std::format("Unable to load texture {}\n", *options.groundTexturePath);
+                return {};
+            }
+            auto& groundMaterial = scene.materials[scene.spheres.front().materialIndex];
+            groundMaterial.textureIndex = static_cast<std::uint32_t>(scene.textures.size());
+            groundMaterial.textureRepeat = groundTextureRepeat;
+            scene.textures.push_back(std::move(*texture));
+        }
+        if (options.environmentPath) {
+            scene.environment = EnvironmentImage::load(*options.environmentPath);
+            if (!scene.environment) {
+                std::cerr << std::format("Unable to load environment map {}\n", *options.environmentPath);
+                return {};
+            }
+        }
+        return scene;
+    }
+}// namespace RenderSetup
@@ -0,0 +1,304 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Utility.hpp"
+#include "Sampling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A sampler hands out the random numbers for one (pixel, sample) pair. Each call to get1D()/get2D()
+// consumes the next dimension, so every decision along a path (pixel jitter, lens position, scatter
+// direction, ...) gets its own dimension of the underlying sequence.
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    virtual void startPixelSample(int x, int y, std::uint32_t sampleIndex) = 0;
+    [[nodiscard]] virtual double get1D() = 0;
+    [[nodiscard]] virtual Sample2D get2D() = 0;
+    [[nodiscard]] virtual std::unique_ptr<Sampler> clone() const = 0;
+};
+
+namespace SamplerDetail {
+    constexpr auto oneMinusEpsilon = 0x1.fffffffffffffp-1;
+
+    [[nodiscard]] constexpr double toUnitInterval(const std::uint32_t value) {
+        return std::min(static_cast<double>(value) * 0x1p-32, oneMinusEpsilon);
+    }
+
+    [[nodiscard]] constexpr std::uint32_t hash(std::uint32_t value) {
+        // integer hash by Chris Wellons (lowbias32)
+        value ^= value >> 16;
+        value *= 0x7feb352dU;
+        value ^= value >> 15;
+        value *= 0x846ca68bU;
+        value ^= value >> 16;
+        return value;
+    }
+
+    [[nodiscard]] constexpr std::uint32_t hashCombine(const std::uint32_t seed, const std::uint32_t value) {
+        return seed ^ (hash(value) + 0x9e3779b9U + (seed << 6) + (seed >> 2));
+    }
+
+    // finalizer of SplitMix64, a bijection that mixes all bits
+    [[nodiscard]] constexpr std::uint64_t mix64(std::uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9U;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebU;
+        return value ^ (value >> 31);
+    }
+
+    [[nodiscard]] constexpr std::uint32_t reverseBits(std::uint32_t value) {
+        value = ((value >> 1) & 0x55555555U) | ((value & 0x55555555U) << 1);
+        value = ((value >> 2) & 0x33333333U) | ((value & 0x33333333U) << 2);
+        value = ((value >> 4) & 0x0f0f0f0fU) | ((value & 0x0f0f0f0fU) << 4);
+        value = ((value >> 8) & 0x00ff00ffU) | ((value & 0x00ff00ffU) << 8);
+        return (value >> 16) | (value << 16);
+    }
+
+    // Laine-Karras style permutation, see Burley: "Practical Hash-based Owen Scrambling" (2020)
+    [[nodiscard]] constexpr std::uint32_t laineKarrasPermutation(std::uint32_t value, const std::uint32_t seed) {
+        value += seed;
+        value ^= value * 0x6c50b47cU;
+        value ^= value * 0xb82f1e52U;
+        value ^= value * 0xc7afe638U;
+        value ^= value * 0x8d22f6e6U;
+        return value;
+    }
+
+    [[nodiscard]] constexpr std::uint32_t nestedUniformScramble(const std::uint32_t value, const std::uint32_t seed) {
+        return reverseBits(laineKarrasPermutation(reverseBits(value), seed));
+    }
+
+    // first Sobol dimension: the van der Corput sequence in base 2
+    [[nodiscard]] constexpr std::uint32_t sobolDimension0(const std::uint32_t index) {
+        return reverseBits(index);
+    }
+
+    // second Sobol dimension (primitive polynomial x + 1), direction numbers v_i = v_(i-1) ^ (v_(i-1) >> 1)
+    [[nodiscard]] constexpr std::uint32_t sobolDimension1(std::uint32_t index) {
+        std::uint32_t result = 0;
+        std::uint32_t direction = 0x80000000U;
+        for (; index != 0; index >>= 1) {
+            if ((index & 1U) != 0) {
+                result ^= direction;
+            }
+            direction ^= direction >> 1;
+        }
+        return result;
+    }
+
+    // 64x64 blue noise dither mask, generated once by greedily placing each rank into the largest void
+    // (the rank-assignment phase of Ulichney's void-and-cluster method) with a toroidal gaussian energy
+    class BlueNoiseMask {
+    public:
+        static constexpr int size = 64;
+        static constexpr int mask = size - 1;
+
+        [[nodiscard]] static double get(const int x, const int y) {
+            return values()[static_cast<std::size_t>((y & mask) * size + (x & mask))];
+        }
+
+    private:
+        [[nodiscard]] static const std::vector<double>& values() {
+            static const auto result = generate();
+            return result;
+        }
+
+        [[nodiscard]] static std::vector<double> generate() {
+            constexpr auto numPixels = static_cast<std::size_t>(size * size);
+            constexpr auto sigma = 1.9;
+
+            std::vector<double> kernel(numPixels);
+            for (int dy = 0; dy < size; ++dy) {
+                for (int dx = 0; dx < size; ++dx) {
+                    const auto wrappedX = static_cast<double>(std::min(dx, size - dx));
+                    const auto wrappedY = static_cast<double>(std::min(dy, size - dy));
+                    kernel[static_cast<std::size_t>(dy * size + dx)] =
+                            std::exp(-(wrappedX * wrappedX + wrappedY * wrappedY) / (2.0 * sigma * sigma));
+                }
+            }
+
+            // tiny deterministic jitter breaks the ties of the initially empty mask
+            std::vector<double> energy(numPixels);
+            for (std::size_t i = 0; i < numPixels; ++i) {
+                energy[i] = toUnitInterval(hash(static_cast<std::uint32_t>(i))) * 1e-6;
+            }
+            std::vector<bool> isFilled(numPixels, false);
+            std::vector<double> result(numPixels);
+            for (std::size_t rank = 0; rank < numPixels; ++rank) {
+                std::size_t voidIndex = 0;
+                auto minEnergy = infinity;
+                for (std::size_t i = 0; i < numPixels; ++i) {
+                    if (!isFilled[i] && energy[i] < minEnergy) {
+                        minEnergy = energy[i];
+                        voidIndex = i;
+                    }
+                }
+                isFilled[voidIndex] = true;
+                result[voidIndex] = (static_cast<double>(rank) + 0.5) / static_cast<double>(numPixels);
+                const auto voidX = static_cast<int>(voidIndex) & mask;
+                const auto voidY = static_cast<int>(voidIndex) / size;
+                for (int y = 0; y < size; ++y) {
+                    for (int x = 0; x < size; ++x) {
+                        energy[static_cast<std::size_t>(y * size + x)] +=
+                                kernel[static_cast<std::size_t>(((y - voidY) & mask) * size + ((x - voidX) & mask))];
+                    }
+                }
+            }
+            return result;
+        }
+    };
+}// namespace SamplerDetail
+
+// Independent uniform random numbers. Every (pixel, sample) pair has its own SplitMix64 stream, so the image does not
+// depend on the number of threads or the order in which they render the tiles.
+class RandomSampler final : public Sampler {
+public:
+    explicit RandomSampler(const std::uint32_t seed = 0) : mSeed{ seed } { }
+
+    void startPixelSample(const int x, const int y, const std::uint32_t sampleIndex) override {
+        using namespace SamplerDetail;
+        const auto pixel = (std::uint64_t{ static_cast<std::uint32_t>(x) } << 32) | static_cast<std::uint32_t>(y);
+        mState = mix64(mix64(mix64(mSeed) ^ pixel) ^ sampleIndex);
+    }
+
+    [[nodiscard]] double get1D() override {
+        // the upper 53 bits fill the mantissa, the result is always less than 1
+        return static_cast<double>(next() >> 11) * 0x1p-53;
+    }
+
+    [[nodiscard]] Sample2D get2D() override {
+        const auto u = get1D();
+        return Sample2D{ .u{ u }, .v{ get1D() } };
+    }
+
+    [[nodiscard]] std::unique_ptr<Sampler> clone() const override {
+        return std::make_unique<RandomSampler>(*this);
+    }
+
+private:
+    [[nodiscard]] std::uint64_t next() {
+        mState += 0x9e3779b97f4a7c15U;
+        return SamplerDetail::mix64(mState);
+    }
+
+private:
+    std::uint64_t mSeed;
+    std::uint64_t mState{ 0 };
+};
+
+// Owen-scrambled Sobol (0,2)-sequence with per-dimension shuffling. Every dimension of every pixel gets its own
+// scramble seed, so dimensions stay decorrelated while each of them keeps its stratification.
+// Works best with power-of-two sample counts.
+class SobolSampler final : public Sampler {
+public:
+    explicit SobolSampler(const std::uint32_t seed = 0) : mSeed{ seed } { }
+
+    void startPixelSample(const int x, const int y, const std::uint32_t sampleIndex) override {
+        using namespace SamplerDetail;
+        mPixelSeed = hashCombine(hashCombine(mSeed, static_cast<std::uint32_t>(x)), static_cast<std::uint32_t>(y));
+        mSampleIndex = sampleIndex;
+        mDimension = 0;
+    }
+
+    [[nodiscard]] double get1D() override {
+        using namespace SamplerDetail;
+        const auto dimensionSeed = hashCombine(mPixelSeed, mDimension++);
+        const auto index = nestedUniformScramble(mSampleIndex, dimensionSeed);
+        return toUnitInterval(nestedUniformScramble(sobolDimension0(index), hashCombine(dimensionSeed, 0)));
+    }
+
+    [[nodiscard]] Sample2D get2D() override {
+        using namespace SamplerDetail;
+        const auto dimensionSeed = hashCombine(mPixelSeed, mDimension++);
+        const auto index = nestedUniformScramble(mSampleIndex, dimensionSeed);
+        return Sample2D{
+            .u{ toUnitInterval(nestedUniformScramble(sobolDimension0(index), hashCombine(dimensionSeed, 0))) },
+            .v{ toUnitInterval(nestedUniformScramble(sobolDimension1(index), hashCombine(dimensionSeed, 1))) }
+        };
+    }
+
+    [[nodiscard]] std::unique_ptr<Sampler> clone() const override {
+        return std::make_unique<SobolSampler>(*this);
+    }
+
+private:
+    std::uint32_t mSeed;
+    std::uint32_t mPixelSeed{ 0 };
+    std::uint32_t mSampleIndex{ 0 };
+    std::uint32_t mDimension{ 0 };
+};
+
+// Sobol points shared by all pixels, rotated (Cranley-Patterson) by a blue noise dither mask. The remaining error
+// of neighboring pixels is then anti-correlated, which looks like fine grain instead of blotchy noise.
+class BlueNoiseSampler final : public Sampler {
+public:
+    explicit BlueNoiseSampler(const std::uint32_t seed = 0) : mSeed{ seed } { }
+
+    void startPixelSample(const int x, const int y, const std::uint32_t sampleIndex) override {
+        mX = x;
+        mY = y;
+        mSampleIndex = sampleIndex;
+        mDimension = 0;
+    }
+
+    [[nodiscard]] double get1D() override {
+        using namespace SamplerDetail;
+        const auto dimensionSeed = hashCombine(mSeed, mDimension++);
+        const auto index = nestedUniformScramble(mSampleIndex, dimensionSeed);
+        return rotate(toUnitInterval(sobolDimension0(index)), dimensionSeed);
+    }
+
+    [[nodiscard]] Sample2D get2D() override {
+        using namespace SamplerDetail;
+        const auto dimensionSeed = hashCombine(mSeed, mDimension++);
+        const auto index = nestedUniformScramble(mSampleIndex, dimensionSeed);
+        return Sample2D{ .u{ rotate(toUnitInterval(sobolDimension0(index)), hashCombine(dimensionSeed, 0)) },
+                         .v{ rotate(toUnitInterval(sobolDimension1(index)), hashCombine(dimensionSeed, 1)) } };
+    }
+
+    [[nodiscard]] std::unique_ptr<Sampler> clone() const override {
+        return std::make_unique<BlueNoiseSampler>(*this);
+    }
+
+private:
+    [[nodiscard]] double rotate(const double value, const std::uint32_t seed) const {
+        using namespace SamplerDetail;
+        // every dimension reads the mask with its own toroidal offset
+        const auto offsetX = static_cast<int>(seed & 0xffU);
+        const auto offsetY = static_cast<int>((seed >> 8) & 0xffU);
+        const auto rotated = value + BlueNoiseMask::get(mX + offsetX, mY + offsetY);
+        return std::min(rotated - std::floor(rotated), oneMinusEpsilon);
+    }
+
+private:
+    std::uint32_t mSeed;
+    int mX{ 0 };
+    int mY{ 0 };
+    std::uint32_t mSampleIndex{ 0 };
+    std::uint32_t mDimension{ 0 };
+};
+
+enum class SamplerType {
+    Random,
+    Sobol,
+    BlueNoise,
+};
+
+[[nodiscard]] inline std::unique_ptr<Sampler> createSampler(const SamplerType type, const std::uint32_t seed = 0) {
+    switch (type) {
+        case SamplerType::Random:
+            return std::make_unique<RandomSampler>(seed);
+        case SamplerType::Sobol:
+            return std::make_unique<SobolSampler>(seed);
+        case SamplerType::BlueNoise:
+            return std::make_unique<BlueNoiseSampler>(seed);
+    }
+    return std::make_unique<RandomSampler>(seed);
+}
@@ -0,0 +1,314 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Bvh.hpp"
+#include "EnvironmentMap.hpp"
+#include "Hittable.hpp"
+#include "Material.hpp"
+#include "Serialization.hpp"
+#include "Sphere.hpp"
+#include "Texture.hpp"
+#include "Utility.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+// everything the tracer needs to render a Scene
+struct World {
+    std::vector<std::unique_ptr<Hittable>> objects;
+    // replaces the background gradient if present
+    std::unique_ptr<const EnvironmentMap> environment;
+    // every type of material that occurs in the world, used to select a specialized render kernel
+    std::vector<MaterialType> materialTypes;
+    // over the objects that existed when the world was built, absent if it is a flat list
+    std::optional<Bvh> bvh;
+};
+
+struct MaterialDescription {
+    static constexpr auto noTexture = std::numeric_limits<std::uint32_t>::max();
+
+    MaterialType type;
+    Color albedo;
+    double fuzz;
+    double refractionIndex;
+    // index into Scene::textures, replaces the albedo of Lambertian materials
+    std::uint32_t textureIndex{ noTexture };
+    double textureRepeat{ 1.0 };
+};
+
+struct SphereDescription {
+    Point3 center;
+    double radius;
+    std::uint32_t materialIndex;
+};
+
+// field by field, the padding of the structs is not initialized
+inline void addToFingerprint(Fingerprint& fingerprint, const Vec3& vector) {
+    fingerprint.add(vector.x);
+    fingerprint.add(vector.y);
+    fingerprint.add(vector.z);
+}
+
+inline void addToFingerprint(Fingerprint& fingerprint, const MaterialDescription& material) {
+    fingerprint.add(material.type);
+    addToFingerprint(fingerprint, material.albedo);
+    fingerprint.add(material.fuzz);
+    fingerprint.add(material.refractionIndex);
+    fingerprint.add(material.textureIndex);
+    fingerprint.add(material.textureRepeat);
+}
+
+// Plain data description of everything that can be rendered. Unlike the World, a Scene can be serialized, e.g.
+// to send it to other processes that take part in rendering the same image.
+struct Scene {
+    std::vector<MaterialDescription> materials;
+    std::vector<SphereDescription> spheres;
+    std::vector<TextureImage> textures;
+    std::optional<EnvironmentImage> environment;
+
+    [[nodiscard]] std::vector<std::byte> serialize() const {
+        ByteWriter writer;
+        writer.write(static_cast<std::uint32_t>(environment ? 1 : 0));
+        if (environment) {
+            writer.write(static_cast<std::int32_t>(environment->width));
+            writer.write(static_cast<std::int32_t>(environment->height));
+            writer.writeBytes(std::as_bytes(std::span{ environment->rgb }));
+        }
+        writer.write(static_cast<std::uint32_t>(textures.size()));
+        for (const auto& texture : textures) {
+            writer.write(static_cast<std::int32_t>(texture.width));
+            writer.write(static_cast<std::int32_t>(texture.height));
+            writer.writeBytes(std::as_bytes(std::span{ texture.rgba }));
+        }
+        writer.write(static_cast<std::uint32_t>(materials.size()));
+        for (const auto& material : materials) {
+            writer.write(material);
+        }
+        writer.write(static_cast<std::uint32_t>(spheres.size()));
+        for (const auto& sphere : spheres) {
+            writer.write(sphere);
+        }
+        return writer.release();
+    }
+
+    // identifies the content of the scene, unlike the serialized bytes it does not depend on padding
+    void addToFingerprint(Fingerprint& fingerprint) const {
+        fingerprint.add(environment.has_value());
+        if (environment) {
+            fingerprint.add(environment->width);
+            fingerprint.add(environment->height);
+            fingerprint.addBytes(std::as_bytes(std::span{ environment->rgb }));
+        }
+        fingerprint.add(textures.size());
+        for (const auto& texture : textures) {
+            fingerprint.add(texture.width);
+            fingerprint.add(texture.height);
+            fingerprint.addBytes(std::as_bytes(std::span{ texture.rgba }));
+        }
+        fingerprint.add(materials.size());
+        for (const auto& material : materials) {
+            ::addToFingerprint(fingerprint, material);
+        }
+        fingerprint.add(spheres.size());
+        for (const auto& sphere : spheres) {
+            ::addToFingerprint(fingerprint, sphere.center);
+            fingerprint.add(sphere.radius);
+            fingerprint.add(sphere.materialIndex);
+        }
+    }
+
+    [[nodiscard]] std::uint64_t fingerprint() const {
+        Fingerprint result;
+        addToFingerprint(result);
+        return result.value();
+    }
+
+    [[nodiscard]] static std::optional<Scene> deserialize(const std::span<const std::byte> bytes) {
+        ByteReader reader{ bytes };
+        Scene result;
+        const auto hasEnvironment = reader.read<std::uint32_t>();
+        if (!hasEnvironment || *hasEnvironment > 1) {
+            return {};
+        }
+        if (*hasEnvironment == 1) {
+            const auto width = reader.read<std::int32_t>();
+            const auto height = reader.read<std::int32_t>();
+            if (!width || !height || *width <= 0 || *height <= 0 || *width > EnvironmentImage::maxDimension ||
+                *height > EnvironmentImage::maxDimension) {
+                return {};
+            }
+            const auto numValues = static_cast<std::size_t>(*width) * static_cast<std::size_t>(*height) * 3;
+            if (numValues > reader.remaining() / sizeof(float)) {
+                return {};
+            }
+            auto environment = EnvironmentImage{ .width{ *width }, .height{ *height }, .rgb{} };
+            environment.rgb.resize(numValues);
+            if (!reader.readBytes(std::as_writable_bytes(std::span{ environment.rgb })) ||
+                !std::all_of(environment.rgb.cbegin(), environment.rgb.cend(),
+                             [](const float value) { return std::isfinite(value) && value >= 0.0F; })) {
+                return {};
+            }
+            result.environment = std::move(environment);
+        }
+        const auto numTextures = reader.read<std::uint32_t>();
+        if (!numTextures || *numTextures > reader.remaining() / (2 * sizeof(std::int32_t))) {
+            return {};
+        }
+        for (std::uint32_t i = 0; i < *numTextures; ++i) {
+            const auto width = reader.read<std::int32_t>();
+            const auto height = reader.read<std::int32_t>();
+            if (!width || !height || *width <= 0 || *height <= 0 || *width > TextureImage::maxDimension ||
+                *height > TextureImage::maxDimension) {
+                return {};
+            }
+            const auto numBytes = static_cast<std::size_t>(*width) * static_cast<std::size_t>(*height) * 4;
+            if (numBytes > reader.remaining()) {
+                return {};
+            }
+            auto texture = TextureImage{ .width{ *width }, .height{ *height }, .rgba{} };
+            texture.rgba.resize(numBytes);
+            if (!reader.readBytes(std::as_writable_bytes(std::span{ texture.rgba }))) {
+                return {};
+            }
+            result.textures.push_back(std::move(texture));
+        }
+        const auto numMaterials = reader.read<std::uint32_t>();
+        if (!numMaterials || *numMaterials > reader.remaining() / sizeof(MaterialDescription)) {
+            return {};
+        }
+        for (std::uint32_t i = 0; i < *numMaterials; ++i) {
+            const auto material = reader.read<MaterialDescription>();
+            if (!material || material->type > MaterialType::Dielectric ||
+                (material->textureIndex != MaterialDescription::noTexture &&
+                 material->textureIndex >= result.textures.size())) {
+                return {};
+            }
+            result.materials.push_back(*material);
+        }
+        const auto numSpheres = reader.read<std::uint32_t>();
+        if (!numSpheres || *numSpheres > reader.remaining() / sizeof(SphereDescription)) {
+            return {};
+        }
+        for (std::uint32_t i = 0; i < *numSpheres; ++i) {
+            const auto sphere = reader.read<SphereDescription>();
+            if (!sphere || sphere->materialIndex >= result.materials.size()) {
+                return {};
+            }
+            result.spheres.push_back(*sphere);
+        }
+        return result;
+    }
+
+    [[nodiscard]] World buildWorld(const BvhSettings& bvhSettings = {}) const {
+        std::vector<std::shared_ptr<const Texture>> builtTextures;
+        builtTextures.reserve(textures.size());
+        for (const auto& texture : textures) {
+            builtTextures.push_back(std::make_shared<const Texture>(texture));
+        }
+        std::vector<std::shared_ptr<Material>> builtMaterials;
+        builtMaterials.reserve(materials.size());
+        for (const auto& material : materials) {
+            builtMaterials.push_back(buildMaterial(material, builtTextures));
+        }
+        World result;
+        for (const auto& material : materials) {
+            if (std::find(result.materialTypes.cbegin(), result.materialTypes.cend(), material.type) ==
+                result.materialTypes.cend()) {
+                result.materialTypes.push_back(material.type);
+            }
+        }
+        result.objects.reserve(spheres.size());
+        for (const auto& sphere : spheres) {
+            result.objects.emplace_back(
+                    std::make_unique<Sphere>(sphere.center, sphere.radius, builtMaterials[sphere.materialIndex]));
+        }
+        if (environment) {
+            result.environment = std::make_unique<const EnvironmentMap>(*environment);
+        }
+        if (bvhSettings.type != BvhType::None) {
+            result.bvh = Bvh::build(result.objects, bvhSettings);
+        }
+        return result;
+    }
+
+    [[nodiscard]] static std::shared_ptr<Material> buildMaterial(
+            const MaterialDescription& material,
+            const std::vector<std::shared_ptr<const Texture>>& builtTextures) {
+        switch (material.type) {
+            case MaterialType::Lambertian:
+                if (material.textureIndex != MaterialDescription::noTexture) {
+                    return std::make_shared<Lambertian>(builtTextures[material.textureIndex], material.textureRepeat);
+                }
+                return std::make_shared<Lambertian>(material.albedo);
+            case MaterialType::Metal:
+                return std::make_shared<Metal>(material.albedo, material.fuzz);
+            case MaterialType::Dielectric:
+                return std::make_shared<Dielectric>(material.refractionIndex);
+        }
+        return {};
+    }
+
+    // the final scene of "Ray Tracing in One Weekend"
+    [[nodiscard]] static Scene createDemoScene() {
+        Scene scene;
+        const auto addSphere = [&scene](const Point3& center, const double radius,
+                                        const MaterialDescription& material) {
+            scene.spheres.push_back(SphereDescription{
+                    .center{ center },
+                    .radius{ radius },
+                    .materialIndex{ static_cast<std::uint32_t>(scene.materials.size()) } });
+            scene.materials.push_back(material);
+        };
+        const auto lambertian = [](const Color& albedo) {
+            return MaterialDescription{
+                .type{ MaterialType::Lambertian }, .albedo{ albedo }, .fuzz{ 0.0 }, .refractionIndex{ 1.0 }
+            };
+        };
+        const auto metal = [](const Color& albedo, const double fuzz) {
+            return MaterialDescription{
+                .type{ MaterialType::Metal }, .albedo{ albedo }, .fuzz{ fuzz }, .refractionIndex{ 1.0 }
+            };
+        };
+        const auto dielectric = [](const double refractionIndex) {
+            return MaterialDescription{ .type{ MaterialType::Dielectric },
+                                        .albedo{ Color{ 1.0, 1.0, 1.0 } },
+                                        .fuzz{ 0.0 },
+                                        .refractionIndex{ refractionIndex } };
+        };
+
+        addSphere(Point3{ 0.0, -1000.0, -1.0 }, 1000.0, lambertian(Color{ 0.5, 0.5, 0.5 }));
+
+        for (int i = -11; i < 11; ++i) {
+            for (int j = -11; j < 11; ++j) {
+                const auto center = Point3{ static_cast<double>(i) + 0.9 * Random::randomDouble(), 0.2,
+                                            static_cast<double>(j) + 0.9 * Random::randomDouble() };
+                if ((center - Point3{ 4.0, 0.2, 0.0 }).length() > 0.9) {
+                    const auto chooseMat = Random::randomDouble();
+                    if (chooseMat < 0.8) {
+                        const auto albedo = Random::randomVec3() * Random::randomVec3();
+                        addSphere(center, 0.2, lambertian(albedo));
+                    } else if (chooseMat < 0.95) {
+                        const auto albedo = Random::randomVec3(0.5, 1.0);
+                        const auto fuzz = Random::randomDouble(0.0, 0.5);
+                        addSphere(center, 0.2, metal(albedo, fuzz));
+                    } else {
+                        addSphere(center, 0.2, dielectric(1.5));
+                    }
+                }
+            }
+        }
+        addSphere(Point3{ 0.0, 1.0, 0.0 }, 1.0, dielectric(1.5));
+        addSphere(Point3{ -4.0, 1.0, 0.0 }, 1.0, lambertian(Color{ 0.4, 0.2, 0.1 }));
+        addSphere(Point3{ 4.0, 1.0, 0.0 }, 1.0, metal(Color{ 0.7, 0.6, 0.5 }, 0.0));
+        return scene;
+    }
+};
@@ -0,0 +1,98 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Appends trivially copyable values to a byte buffer. Values are stored in the native byte order, all machines
+// that exchange data are expected to be little endian.
+class ByteWriter {
+public:
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto offset = mBytes.size();
+        mBytes.resize(offset + sizeof(T));
+        std::memcpy(mBytes.data() + offset, &value, sizeof(T));
+    }
+
+    void writeBytes(const std::span<const std::byte> bytes) {
+        mBytes.insert(mBytes.end(), bytes.begin(), bytes.end());
+    }
+
+    [[nodiscard]] std::vector<std::byte> release() {
+        return std::move(mBytes);
+    }
+
+private:
+    std::vector<std::byte> mBytes;
+};
+
+// counterpart of ByteWriter, every read fails once the end of the data has been reached
+class ByteReader {
+public:
+    explicit ByteReader(const std::span<const std::byte> bytes) : mBytes{ bytes } { }
+
+    template<typename T>
+    [[nodiscard]] std::optional<T> read() {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+        if (mBytes.size() - mOffset < sizeof(T)) {
+            return {};
+        }
+        T result;
+        std::memcpy(&result, mBytes.data() + mOffset, sizeof(T));
+        mOffset += sizeof(T);
+        return result;
+    }
+
+    // fills the whole destination or nothing
+    [[nodiscard]] bool readBytes(const std::span<std::byte> destination) {
+        if (remaining() < destination.size()) {
+            return false;
+        }
+        std::memcpy(destination.data(), mBytes.data() + mOffset, destination.size());
+        mOffset += destination.size();
+        return true;
+    }
+
+    [[nodiscard]] std::size_t remaining() const {
+        return mBytes.size() - mOffset;
+    }
+
+private:
+    std::span<const std::byte> mBytes;
+    std::size_t mOffset{ 0 };
+};
+
+// 64 bit FNV-1a hash of a sequence of values. Structs have to be added member by member, their padding bytes are
+// not guaranteed to have the same value in every process.
+class Fingerprint {
+public:
+    template<typename T>
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    void add(const T value) {
+        addBytes(std::as_bytes(std::span{ &value, 1 }));
+    }
+
+    void addBytes(const std::span<const std::byte> bytes) {
+        for (const auto byte : bytes) {
+            mValue = (mValue ^ static_cast<std::uint64_t>(byte)) * 0x100000001b3ULL;
+        }
+    }
+
+    [[nodiscard]] std::uint64_t value() const {
+        return mValue;
+    }
+
+private:
+    std::uint64_t mValue{ 0xcbf29ce484222325ULL };
+};
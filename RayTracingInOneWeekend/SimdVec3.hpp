@@ -0,0 +1,297 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#else
+#error "SimdVec3 needs at least SSE2"
+#endif
+
+// Drop-in replacement for ScalarVec3 (see Vec3.hpp) that stores the components in four lanes of SIMD registers, the
+// fourth lane is padding. With AVX2 (e.g. -mavx2 or -march=native), all four lanes live in one 256 bit register,
+// otherwise in two SSE2 registers (x/y and z/padding). The results are identical to those of ScalarVec3 as long as
+// the compiler does not contract the scalar code into fused multiply-adds. The padding lane is never read by any
+// operation that combines lanes, so it does not need to be kept at zero.
+struct alignas(32) SimdVec3 {
+    constexpr SimdVec3() : x{ 0.0 }, y{ 0.0 }, z{ 0.0 } { }
+    constexpr SimdVec3(double v0, double v1, double v2) : x{ v0 }, y{ v1 }, z{ v2 } { }
+
+    [[nodiscard]] constexpr bool operator==(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return (x == other.x && y == other.y && z == other.z);
+        }
+#ifdef __AVX2__
+        return (_mm256_movemask_pd(_mm256_cmp_pd(load(), other.load(), _CMP_EQ_OQ)) & 0b0111) == 0b0111;
+#else
+        const auto [xy, zw] = load();
+        const auto [otherXY, otherZW] = other.load();
+        return _mm_movemask_pd(_mm_cmpeq_pd(xy, otherXY)) == 0b11 &&
+               (_mm_movemask_pd(_mm_cmpeq_sd(zw, otherZW)) & 0b01) == 0b01;
+#endif
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator-() const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ -x, -y, -z };
+        }
+        return fromLanes(lanewise(load(), [](const auto lanes) { return negate(lanes); }));
+    }
+
+    constexpr SimdVec3& operator+=(const SimdVec3& other) {
+        return (*this = *this + other);
+    }
+
+    constexpr SimdVec3& operator*=(const SimdVec3& other) {
+        return (*this = *this * other);
+    }
+
+    constexpr SimdVec3& operator*=(const double scalar) {
+        return (*this = *this * scalar);
+    }
+
+    constexpr SimdVec3& operator/=(const double scalar) {
+        return (*this *= 1.0 / scalar);
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator+(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ x + other.x, y + other.y, z + other.z };
+        }
+        return fromLanes(lanewise(load(), other.load(), [](const auto lhs, const auto rhs) { return add(lhs, rhs); }));
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator-(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ x - other.x, y - other.y, z - other.z };
+        }
+        return fromLanes(
+                lanewise(load(), other.load(), [](const auto lhs, const auto rhs) { return subtract(lhs, rhs); }));
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator*(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ x * other.x, y * other.y, z * other.z };
+        }
+        return fromLanes(
+                lanewise(load(), other.load(), [](const auto lhs, const auto rhs) { return multiply(lhs, rhs); }));
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator*(const double scalar) const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ x * scalar, y * scalar, z * scalar };
+        }
+        return *this * broadcast(scalar);
+    }
+
+    [[nodiscard]] inline friend constexpr SimdVec3 operator*(const double scalar, const SimdVec3& vector) {
+        return vector * scalar;
+    }
+
+    [[nodiscard]] constexpr SimdVec3 operator/(const double scalar) const {
+        return (*this) * (1.0 / scalar);
+    }
+
+    [[nodiscard]] double length() const {
+        return std::sqrt(lengthSquared());
+    }
+
+    [[nodiscard]] constexpr double lengthSquared() const {
+        return dot(*this);
+    }
+
+    [[nodiscard]] constexpr double dot(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return x * other.x + y * other.y + z * other.z;
+        }
+        // (x + y) + z like the scalar version, the padding lane is left out
+#ifdef __AVX2__
+        const auto product = _mm256_mul_pd(load(), other.load());
+        const auto xy = _mm256_castpd256_pd128(product);
+        const auto zw = _mm256_extractf128_pd(product, 1);
+#else
+        const auto xy = _mm_mul_pd(load().xy, other.load().xy);
+        const auto zw = _mm_mul_sd(load().zw, other.load().zw);
+#endif
+        return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw));
+    }
+
+    [[nodiscard]] constexpr SimdVec3 cross(const SimdVec3& other) const {
+        if (std::is_constant_evaluated()) {
+            return SimdVec3{ y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x };
+        }
+#ifdef __AVX2__
+        constexpr auto yzx = _MM_SHUFFLE(3, 0, 2, 1);
+        constexpr auto zxy = _MM_SHUFFLE(3, 1, 0, 2);
+        const auto lhs = load();
+        const auto rhs = other.load();
+        return fromLanes(
+                _mm256_sub_pd(_mm256_mul_pd(_mm256_permute4x64_pd(lhs, yzx), _mm256_permute4x64_pd(rhs, zxy)),
+                              _mm256_mul_pd(_mm256_permute4x64_pd(lhs, zxy), _mm256_permute4x64_pd(rhs, yzx))));
+#else
+        const auto [lhsXY, lhsZW] = load();
+        const auto [rhsXY, rhsZW] = other.load();
+        const auto lhsYZ = _mm_shuffle_pd(lhsXY, lhsZW, 0b01);
+        const auto lhsZX = _mm_shuffle_pd(lhsZW, lhsXY, 0b00);
+        const auto rhsYZ = _mm_shuffle_pd(rhsXY, rhsZW, 0b01);
+        const auto rhsZX = _mm_shuffle_pd(rhsZW, rhsXY, 0b00);
+        const auto resultXY = _mm_sub_pd(_mm_mul_pd(lhsYZ, rhsZX), _mm_mul_pd(lhsZX, rhsYZ));
+        // x * other.y - y * other.x
+        const auto resultZ = _mm_sub_sd(_mm_mul_sd(lhsXY, _mm_unpackhi_pd(rhsXY, rhsXY)),
+                                        _mm_mul_sd(_mm_unpackhi_pd(lhsXY, lhsXY), rhsXY));
+        return fromLanes(Lanes{ .xy{ resultXY }, .zw{ resultZ } });
+#endif
+    }
+
+    [[nodiscard]] SimdVec3 normalized() const {
+        return *this / length();
+    }
+
+    [[nodiscard]] bool isNearZero() const {
+        constexpr auto epsilon = 1e-8;
+        return (std::abs(x) < epsilon && std::abs(y) < epsilon && std::abs(z) < epsilon);
+    }
+
+    [[nodiscard]] SimdVec3 reflect(const SimdVec3& normal) const {
+        return *this - 2.0 * this->dot(normal) * normal;
+    }
+
+    [[nodiscard]] SimdVec3 refract(const SimdVec3& normal, const double refractionIndexRatio) const {
+        assert(std::abs(lengthSquared() - 1.0) <= 0.01);
+        assert(std::abs(normal.lengthSquared() - 1.0) <= 0.01);
+        const auto cosTheta = std::min(-(*this).dot(normal), 1.0);
+        const auto outDirectionPerpendicular = refractionIndexRatio * (*this + cosTheta * normal);
+        const auto outDirectionParallel =
+                -std::sqrt(std::abs(1.0 - outDirectionPerpendicular.lengthSquared())) * normal;
+        return outDirectionPerpendicular + outDirectionParallel;
+    }
+
+    union {
+        double x;
+        double r;
+    };
+    union {
+        double y;
+        double g;
+    };
+    union {
+        double z;
+        double b;
+    };
+
+private:
+#ifdef __AVX2__
+    using Lanes = __m256d;
+
+    [[nodiscard]] Lanes load() const {
+        return _mm256_load_pd(&x);
+    }
+
+    [[nodiscard]] static SimdVec3 fromLanes(const Lanes lanes) {
+        SimdVec3 result;
+        _mm256_store_pd(&result.x, lanes);
+        return result;
+    }
+
+    [[nodiscard]] static Lanes broadcast(const double value) {
+        return _mm256_set1_pd(value);
+    }
+
+    template<typename Operation>
+    [[nodiscard]] static Lanes lanewise(const Lanes lanes, Operation operation) {
+        return operation(lanes);
+    }
+
+    template<typename Operation>
+    [[nodiscard]] static Lanes lanewise(const Lanes lhs, const Lanes rhs, Operation operation) {
+        return operation(lhs, rhs);
+    }
+
+    [[nodiscard]] SimdVec3 operator*(const Lanes scalar) const {
+        return fromLanes(_mm256_mul_pd(load(), scalar));
+    }
+
+    [[nodiscard]] static __m256d negate(const __m256d lanes) {
+        return _mm256_xor_pd(lanes, _mm256_set1_pd(-0.0));
+    }
+
+    [[nodiscard]] static __m256d add(const __m256d lhs, const __m256d rhs) {
+        return _mm256_add_pd(lhs, rhs);
+    }
+
+    [[nodiscard]] static __m256d subtract(const __m256d lhs, const __m256d rhs) {
+        return _mm256_sub_pd(lhs, rhs);
+    }
+
+    [[nodiscard]] static __m256d multiply(const __m256d lhs, const __m256d rhs) {
+        return _mm256_mul_pd(lhs, rhs);
+    }
+#else
+    struct Lanes {
+        __m128d xy;
+        __m128d zw;
+    };
+
+    [[nodiscard]] Lanes load() const {
+        return Lanes{ .xy{ _mm_load_pd(&x) }, .zw{ _mm_load_pd(&z) } };
+    }
+
+    [[nodiscard]] static SimdVec3 fromLanes(const Lanes lanes) {
+        SimdVec3 result;
+        _mm_store_pd(&result.x, lanes.xy);
+        _mm_store_pd(&result.z, lanes.zw);
+        return result;
+    }
+
+    [[nodiscard]] static __m128d broadcast(const double value) {
+        return _mm_set1_pd(value);
+    }
+
+    // applies the operation to both registers
+    template<typename Operation>
+    [[nodiscard]] static Lanes lanewise(const Lanes lanes, Operation operation) {
+        return Lanes{ .xy{ operation(lanes.xy) }, .zw{ operation(lanes.zw) } };
+    }
+
+    template<typename Operation>
+    [[nodiscard]] static Lanes lanewise(const Lanes lhs, const Lanes rhs, Operation operation) {
+        return Lanes{ .xy{ operation(lhs.xy, rhs.xy) }, .zw{ operation(lhs.zw, rhs.zw) } };
+    }
+
+    [[nodiscard]] SimdVec3 operator*(const __m128d scalar) const {
+        return fromLanes(lanewise(load(), [scalar](const __m128d lanes) { return _mm_mul_pd(lanes, scalar); }));
+    }
+
+    [[nodiscard]] static __m128d negate(const __m128d lanes) {
+        return _mm_xor_pd(lanes, _mm_set1_pd(-0.0));
+    }
+
+    [[nodiscard]] static __m128d add(const __m128d lhs, const __m128d rhs) {
+        return _mm_add_pd(lhs, rhs);
+    }
+
+    [[nodiscard]] static __m128d subtract(const __m128d lhs, const __m128d rhs) {
+        return _mm_sub_pd(lhs, rhs);
+    }
+
+    [[nodiscard]] static __m128d multiply(const __m128d lhs, const __m128d rhs) {
+        return _mm_mul_pd(lhs, rhs);
+    }
+#endif
+
+    // the fourth lane, its value is undefined after arithmetic
+    double mPadding{ 0.0 };
+};
+
+inline std::ostream& operator<<(std::ostream& outStream, const SimdVec3& vector) {
+    outStream << std::format("{} {} {}", vector.x, vector.y, vector.z);
+    return outStream;
+}
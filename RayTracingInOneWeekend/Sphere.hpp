@@ -6,9 +6,11 @@
 
 #include "Hittable.hpp"
 #include "Material.hpp"
+#include <cmath>
 #include <memory>
+#include <numbers>
 
-class Sphere : public Hittable {
+class Sphere final : public Hittable {
 public:
     Sphere() = default;
     Sphere(const Point3& center, const double radius, std::shared_ptr<Material> material)
@@ -17,6 +19,15 @@ public:
           material{ std::move(material) } { }
 
     [[nodiscard]] std::optional<double> hit(const Ray& ray, double tMin, double tMax) const override {
+        return intersect(center, radius, ray, tMin, tMax);
+    }
+
+    // also used for spheres that are stored as plain data
+    [[nodiscard]] static std::optional<double> intersect(const Point3& center,
+                                                         const double radius,
+                                                         const Ray& ray,
+                                                         const double tMin,
+                                                         const double tMax) {
         const auto sphereCenterToRayOrigin = ray.origin - center;
         const auto squaredRayDirectionLength = ray.direction.lengthSquared();
         const auto minusHalfP = -ray.direction.dot(sphereCenterToRayOrigin) / squaredRayDirectionLength;
@@ -40,15 +51,37 @@ public:
         return {};
     }
 
+    [[nodiscard]] std::optional<BoundingBox> clippedBounds(const BoundingBox& clip) const override {
+        return BoundingBox::ofClippedSphere(center, radius, clip);
+    }
+
     [[nodiscard]] IntersectionInfo getIntersectionInfo(const Ray& ray, const double t) const override {
         IntersectionInfo result;
         result.intersectionPoint = ray.evaluate(t);
         const auto outwardsNormal = (result.intersectionPoint - center) / radius;
         result.setFaceNormal(ray, outwardsNormal);
         result.material = material;
+        setTextureCoordinates(result, outwardsNormal);
         return result;
     }
 
+private:
+    // The poles lie on the z axis, u goes around it starting at -x and v goes from -z to +z. This way the top of the
+    // ground sphere of the demo scene lies on the equator, where the mapping is least distorted.
+    void setTextureCoordinates(IntersectionInfo& intersectionInfo, const Vec3& outwardsNormal) const {
+        using std::numbers::pi;
+        const auto theta = std::acos(std::clamp(-outwardsNormal.z, -1.0, 1.0));
+        const auto phi = std::atan2(-outwardsNormal.y, outwardsNormal.x) + pi;
+        intersectionInfo.textureCoordinates = TextureCoordinates{ .u{ phi / (2.0 * pi) }, .v{ theta / pi } };
+        intersectionInfo.dpdu = 2.0 * pi * radius * Vec3{ outwardsNormal.y, -outwardsNormal.x, 0.0 };
+        const auto sinTheta = std::sqrt(outwardsNormal.x * outwardsNormal.x + outwardsNormal.y * outwardsNormal.y);
+        if (sinTheta > 0.0) {
+            intersectionInfo.dpdv = pi * radius *
+                                    Vec3{ -outwardsNormal.z * outwardsNormal.x / sinTheta,
+                                          -outwardsNormal.z * outwardsNormal.y / sinTheta, sinTheta };
+        }
+    }
+
 public:
     Point3 center;
     double radius;
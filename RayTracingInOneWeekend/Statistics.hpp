@@ -0,0 +1,88 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+
+// fixed instead of std::hardware_destructive_interference_size, whose value may differ between compilers
+inline constexpr std::size_t cacheLineSize = 64;
+
+// Counters of the hot path of the renderer. Every thread owns one instance and increments it without any
+// synchronization, the instances are aligned to whole cache lines so that no two threads ever write into the same
+// cache line. The instances are merged after rendering.
+struct alignas(cacheLineSize) RenderStatistics {
+    // paths that are longer are counted in the last bin
+    static constexpr std::size_t numPathDepthBins = 64;
+
+    std::uint64_t primaryRays{ 0 };
+    std::uint64_t secondaryRays{ 0 };
+    // visibility tests towards light sources, not part of any path
+    std::uint64_t shadowRays{ 0 };
+    std::uint64_t intersectionTests{ 0 };
+    // nodes of an acceleration structure, stays 0 as long as the world is a flat list
+    std::uint64_t nodeVisits{ 0 };
+    // number of rays (segments) of the finished paths
+    std::array<std::uint64_t, numPathDepthBins> pathDepthHistogram{};
+
+    void countRay(const int bounce) {
+        if (bounce == 0) {
+            ++primaryRays;
+        } else {
+            ++secondaryRays;
+        }
+    }
+
+    void countPathEnd(const int numRays) {
+        const auto bin = std::min(static_cast<std::size_t>(numRays), numPathDepthBins - 1);
+        ++pathDepthHistogram[bin];
+    }
+
+    RenderStatistics& operator+=(const RenderStatistics& other) {
+        primaryRays += other.primaryRays;
+        secondaryRays += other.secondaryRays;
+        shadowRays += other.shadowRays;
+        intersectionTests += other.intersectionTests;
+        nodeVisits += other.nodeVisits;
+        for (std::size_t i = 0; i < numPathDepthBins; ++i) {
+            pathDepthHistogram[i] += other.pathDepthHistogram[i];
+        }
+        return *this;
+    }
+
+    [[nodiscard]] std::uint64_t totalRays() const {
+        return primaryRays + secondaryRays + shadowRays;
+    }
+
+    [[nodiscard]] std::string summary(const double renderSeconds) const {
+        const auto rays = static_cast<double>(std::max(totalRays(), std::uint64_t{ 1 }));
+        auto result = std::format("Rays: {} primary, {} secondary, {} shadow, {:.3f} Mrays/s\n", primaryRays,
+                                  secondaryRays, shadowRays, rays / renderSeconds * 1.0e-6);
+        result += std::format("Intersection tests: {} ({:.2f} per ray)\n", intersectionTests,
+                              static_cast<double>(intersectionTests) / rays);
+        if (nodeVisits > 0) {
+            result += std::format("Node visits: {} ({:.2f} per ray)\n", nodeVisits,
+                                  static_cast<double>(nodeVisits) / rays);
+        }
+        std::uint64_t numPaths = 0;
+        for (const auto count : pathDepthHistogram) {
+            numPaths += count;
+        }
+        result += "Path depth histogram (rays per path):\n";
+        for (std::size_t i = 0; i < numPathDepthBins; ++i) {
+            if (pathDepthHistogram[i] == 0) {
+                continue;
+            }
+            result += std::format("  {:>3}{} {:>12} ({:5.2f} %)\n", i, (i + 1 == numPathDepthBins ? "+" : " "),
+                                  pathDepthHistogram[i],
+                                  100.0 * static_cast<double>(pathDepthHistogram[i]) / static_cast<double>(numPaths));
+        }
+        return result;
+    }
+};
@@ -0,0 +1,239 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Color.hpp"
+#include "Statistics.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct TextureCoordinates {
+    double u;
+    double v;
+};
+
+// 8 bit sRGB image as it is stored in a file, the rows are ordered from top to bottom
+struct TextureImage {
+    static constexpr int maxDimension = 16384;
+
+    int width;
+    int height;
+    std::vector<std::uint8_t> rgba;
+
+    [[nodiscard]] bool isValid() const {
+        return width > 0 && height > 0 && width <= maxDimension && height <= maxDimension &&
+               rgba.size() == static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4;
+    }
+
+    [[nodiscard]] static std::optional<TextureImage> load(const std::string& filename) {
+        int width = 0;
+        int height = 0;
+        int channelsInFile = 0;
+        auto* const data = stbi_load(filename.c_str(), &width, &height, &channelsInFile, 4);
+        if (data == nullptr) {
+            return {};
+        }
+        auto result = TextureImage{
+            .width{ width },
+            .height{ height },
+            .rgba{ std::vector<std::uint8_t>(data, data + static_cast<std::ptrdiff_t>(width) * height * 4) }
+        };
+        stbi_image_free(data);
+        if (!result.isValid()) {
+            return {};
+        }
+        return result;
+    }
+};
+
+namespace TextureDetail {
+    [[nodiscard]] inline double srgbToLinear(const double value) {
+        return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+    }
+
+    [[nodiscard]] inline double linearToSrgb(const double value) {
+        return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+    }
+
+    [[nodiscard]] inline const std::array<double, 256>& srgbToLinearTable() {
+        static const auto table = []() {
+            std::array<double, 256> result{};
+            for (std::size_t i = 0; i < result.size(); ++i) {
+                result[i] = srgbToLinear(static_cast<double>(i) / 255.0);
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    [[nodiscard]] inline std::uint8_t encodeSrgb(const double linearValue) {
+        const auto encoded = linearToSrgb(std::clamp(linearValue, 0.0, 1.0));
+        return static_cast<std::uint8_t>(std::lround(encoded * 255.0));
+    }
+}// namespace TextureDetail
+
+// Mipmapped image texture. All levels are stored as 8 bit sRGB in blocks of 8 x 8 texels, so that the 4 texels of a
+// bilinear lookup almost always lie in the same 256 byte block and the texels around a lookup are in memory that was
+// fetched anyway. Lookups with a large footprint (e.g. of secondary rays after diffuse bounces) are served from small
+// levels which stay in the cache.
+class Texture {
+public:
+    static constexpr int blockSize = 8;
+
+    explicit Texture(const TextureImage& image) {
+        assert(image.isValid());
+        // the base level is flipped, so that v = 0 is the bottom of the image
+        std::vector<Color> linearTexels(static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height));
+        const auto& toLinear = TextureDetail::srgbToLinearTable();
+        for (int y = 0; y < image.height; ++y) {
+            for (int x = 0; x < image.width; ++x) {
+                const auto source = (static_cast<std::size_t>(image.height - 1 - y) * image.width + x) * 4;
+                linearTexels[static_cast<std::size_t>(y) * image.width + x] =
+                        Color{ toLinear[image.rgba[source]], toLinear[image.rgba[source + 1]],
+                               toLinear[image.rgba[source + 2]] };
+            }
+        }
+        auto width = image.width;
+        auto height = image.height;
+        while (true) {
+            addLevel(width, height, linearTexels);
+            if (width == 1 && height == 1) {
+                break;
+            }
+            linearTexels = downsample(width, height, linearTexels);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+
+    [[nodiscard]] int width() const {
+        return mLevels.front().width;
+    }
+
+    [[nodiscard]] int height() const {
+        return mLevels.front().height;
+    }
+
+    [[nodiscard]] std::size_t numLevels() const {
+        return mLevels.size();
+    }
+
+    // Trilinear lookup with repeating texture coordinates. footprint is the extent of the area that the lookup
+    // represents in texture coordinates, it selects the mip level.
+    [[nodiscard]] Color sample(const TextureCoordinates& coordinates, const double footprint) const {
+        const auto texelFootprint = footprint * static_cast<double>(std::max(width(), height()));
+        const auto maxLevel = static_cast<double>(mLevels.size() - 1);
+        const auto level = std::clamp(texelFootprint > 1.0 ? std::log2(texelFootprint) : 0.0, 0.0, maxLevel);
+        const auto lowerLevel = static_cast<std::size_t>(level);
+        const auto weight = level - static_cast<double>(lowerLevel);
+        const auto lower = sampleLevel(mLevels[lowerLevel], coordinates);
+        if (weight == 0.0) {
+            return lower;
+        }
+        return (1.0 - weight) * lower + weight * sampleLevel(mLevels[lowerLevel + 1], coordinates);
+    }
+
+private:
+    struct alignas(cacheLineSize) TexelBlock {
+        std::array<std::uint32_t, blockSize * blockSize> texels;
+    };
+
+    struct Level {
+        int width;
+        int height;
+        int blocksPerRow;
+        std::size_t firstBlock;
+    };
+
+    void addLevel(const int width, const int height, const std::vector<Color>& linearTexels) {
+        const auto blocksPerRow = (width + blockSize - 1) / blockSize;
+        const auto blocksPerColumn = (height + blockSize - 1) / blockSize;
+        const auto level = Level{ .width{ width },
+                                  .height{ height },
+                                  .blocksPerRow{ blocksPerRow },
+                                  .firstBlock{ mBlocks.size() } };
+        mBlocks.resize(mBlocks.size() + static_cast<std::size_t>(blocksPerRow * blocksPerColumn));
+        mLevels.push_back(level);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const auto& color = linearTexels[static_cast<std::size_t>(y) * width + x];
+                const auto packed = static_cast<std::uint32_t>(TextureDetail::encodeSrgb(color.r)) |
+                                    static_cast<std::uint32_t>(TextureDetail::encodeSrgb(color.g)) << 8 |
+                                    static_cast<std::uint32_t>(TextureDetail::encodeSrgb(color.b)) << 16 |
+                                    std::uint32_t{ 0xFF } << 24;
+                texel(level, x, y) = packed;
+            }
+        }
+    }
+
+    // 2 x 2 box filter in linear color space, the last row/column of odd dimensions > 1 is dropped
+    [[nodiscard]] static std::vector<Color> downsample(const int width,
+                                                      const int height,
+                                                      const std::vector<Color>& texels) {
+        const auto newWidth = std::max(1, width / 2);
+        const auto newHeight = std::max(1, height / 2);
+        std::vector<Color> result(static_cast<std::size_t>(newWidth) * static_cast<std::size_t>(newHeight));
+        const auto at = [&](const int x, const int y) -> const Color& {
+            return texels[static_cast<std::size_t>(std::min(y, height - 1)) * width + std::min(x, width - 1)];
+        };
+        for (int y = 0; y < newHeight; ++y) {
+            for (int x = 0; x < newWidth; ++x) {
+                result[static_cast<std::size_t>(y) * newWidth + x] =
+                        0.25 * (at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) +
+                                at(2 * x + 1, 2 * y + 1));
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] std::uint32_t& texel(const Level& level, const int x, const int y) {
+        auto& block = mBlocks[level.firstBlock + static_cast<std::size_t>((y / blockSize) * level.blocksPerRow +
+                                                                          x / blockSize)];
+        return block.texels[static_cast<std::size_t>((y % blockSize) * blockSize + x % blockSize)];
+    }
+
+    [[nodiscard]] const std::uint32_t& texel(const Level& level, const int x, const int y) const {
+        const auto& block = mBlocks[level.firstBlock + static_cast<std::size_t>((y / blockSize) * level.blocksPerRow +
+                                                                                x / blockSize)];
+        return block.texels[static_cast<std::size_t>((y % blockSize) * blockSize + x % blockSize)];
+    }
+
+    [[nodiscard]] Color decodedTexel(const Level& level, const int x, const int y) const {
+        const auto& toLinear = TextureDetail::srgbToLinearTable();
+        const auto packed = texel(level, x, y);
+        return Color{ toLinear[packed & 0xFF], toLinear[(packed >> 8) & 0xFF], toLinear[(packed >> 16) & 0xFF] };
+    }
+
+    [[nodiscard]] Color sampleLevel(const Level& level, const TextureCoordinates& coordinates) const {
+        const auto x = (coordinates.u - std::floor(coordinates.u)) * level.width - 0.5;
+        const auto y = (coordinates.v - std::floor(coordinates.v)) * level.height - 0.5;
+        const auto x0 = static_cast<int>(std::floor(x));
+        const auto y0 = static_cast<int>(std::floor(y));
+        const auto fractionX = x - static_cast<double>(x0);
+        const auto fractionY = y - static_cast<double>(y0);
+        const auto wrap = [](const int value, const int size) { return value < 0 ? value + size : value % size; };
+        const auto left = wrap(x0, level.width);
+        const auto right = wrap(x0 + 1, level.width);
+        const auto bottom = wrap(y0, level.height);
+        const auto top = wrap(y0 + 1, level.height);
+        return (1.0 - fractionY) * ((1.0 - fractionX) * decodedTexel(level, left, bottom) +
+                                    fractionX * decodedTexel(level, right, bottom)) +
+               fractionY * ((1.0 - fractionX) * decodedTexel(level, left, top) +
+                            fractionX * decodedTexel(level, right, top));
+    }
+
+private:
+    std::vector<Level> mLevels;
+    std::vector<TexelBlock> mBlocks;
+};
@@ -5,6 +5,8 @@
 #pragma once
 
 #include "Vec3.hpp"
+#include "Sampling.hpp"
+#include <cstdint>
 #include <limits>
 #include <random>
 #include <numbers>
@@ -35,16 +37,12 @@ public:
     }
 
     [[nodiscard]] static Vec3 randomVecInsideUnitSphere() {
-        while (true) {
-            const auto vec = randomVec3(-1.0, 1.0);
-            if ((vec.x != 0.0 || vec.y != 0.0 || vec.z != 0.0) && vec.lengthSquared() < 1.0) {
-                return vec;
-            }
-        }
+        const auto directionSample = randomSample2D();
+        return Sampling::uniformBall(directionSample, randomDouble());
     }
 
     [[nodiscard]] static Vec3 randomUnitVector() {
-        return randomVecInsideUnitSphere().normalized();
+        return Sampling::uniformSphere(randomSample2D());
     }
 
     [[nodiscard]] static Vec3 randomVecInsideHemisphere(const Vec3& normal) {
@@ -53,12 +51,17 @@ public:
     }
 
     [[nodiscard]] static Vec3 randomInsideUnitDisk() {
-        while (true) {
-            const auto result = Vec3{ randomDouble(-1.0, 1.0), randomDouble(-1.0, 1.0), 0.0 };
-            if (result.lengthSquared() < 1.0) {
-                return result;
-            }
-        }
+        return Sampling::concentricDisk(randomSample2D());
+    }
+
+    [[nodiscard]] static Sample2D randomSample2D() {
+        const auto u = randomDouble();
+        return Sample2D{ .u{ u }, .v{ randomDouble() } };
+    }
+
+    static void seed(const std::uint64_t value) {
+        mRandomEngine.seed(value);
+        mDistribution.reset();
     }
 
 private:
@@ -9,65 +9,68 @@
 #include <iostream>
 #include <format>
 
+#ifdef RAYTRACER_SIMD_VEC3
+#include "SimdVec3.hpp"
+#endif
 
-struct Vec3 {
-    constexpr Vec3() : x{ 0.0 }, y{ 0.0 }, z{ 0.0 } { }
-    constexpr Vec3(double v0, double v1, double v2) : x{ v0 }, y{ v1 }, z{ v2 } { }
+struct ScalarVec3 {
+    constexpr ScalarVec3() : x{ 0.0 }, y{ 0.0 }, z{ 0.0 } { }
+    constexpr ScalarVec3(double v0, double v1, double v2) : x{ v0 }, y{ v1 }, z{ v2 } { }
 
-    [[nodiscard]] constexpr bool operator==(const Vec3& other) const {
+    [[nodiscard]] constexpr bool operator==(const ScalarVec3& other) const {
         return (x == other.x && y == other.y && z == other.z);
     }
 
-    [[nodiscard]] constexpr Vec3 operator-() const {
-        return Vec3{ -x, -y, -z };
+    [[nodiscard]] constexpr ScalarVec3 operator-() const {
+        return ScalarVec3{ -x, -y, -z };
     }
 
-    constexpr Vec3& operator+=(const Vec3& other) {
+    constexpr ScalarVec3& operator+=(const ScalarVec3& other) {
         x += other.x;
         y += other.y;
         z += other.z;
         return *this;
     }
 
-    constexpr Vec3& operator*=(const Vec3& other) {
+    constexpr ScalarVec3& operator*=(const ScalarVec3& other) {
         x *= other.x;
         y *= other.y;
         z *= other.z;
         return *this;
     }
 
-    constexpr Vec3& operator*=(const double scalar) {
+    constexpr ScalarVec3& operator*=(const double scalar) {
         x *= scalar;
         y *= scalar;
         z *= scalar;
         return *this;
     }
 
-    constexpr Vec3& operator/=(const double scalar) {
+    constexpr ScalarVec3& operator/=(const double scalar) {
         return (*this *= 1.0 / scalar);
     }
 
-    [[nodiscard]] constexpr Vec3 operator+(const Vec3& other) const {
-        return Vec3{ x + other.x, y + other.y, z + other.z };
+    [[nodiscard]] constexpr ScalarVec3 operator+(const ScalarVec3& other) const {
+        return ScalarVec3{ x + other.x, y + other.y, z + other.z };
     }
 
-    [[nodiscard]] constexpr Vec3 operator-(const Vec3& other) const {
-        return Vec3{ x - other.x, y - other.y, z - other.z };
+    [[nodiscard]] constexpr ScalarVec3 operator-(const ScalarVec3& other) const {
+        return ScalarVec3{ x - other.x, y - other.y, z - other.z };
     }
 
-    [[nodiscard]] constexpr Vec3 operator*(const Vec3& other) const {
-        return Vec3{ x * other.x, y * other.y, z * other.z };
+    [[nodiscard]] constexpr ScalarVec3 operator*(const ScalarVec3& other) const {
+        return ScalarVec3{ x * other.x, y * other.y, z * other.z };
     }
 
-    [[nodiscard]] constexpr Vec3 operator*(const double scalar) const {
-        return Vec3{ x * scalar, y * scalar, z * scalar };
+    [[nodiscard]] constexpr ScalarVec3 operator*(const double scalar) const {
+        return ScalarVec3{ x * scalar, y * scalar, z * scalar };
     }
 
-    [[nodiscard]] inline friend constexpr Vec3 operator*(const double scalar, const Vec3& vector) {
+    [[nodiscard]] inline friend constexpr ScalarVec3 operator*(const double scalar, const ScalarVec3& vector) {
         return vector * scalar;
     }
 
-    [[nodiscard]] constexpr Vec3 operator/(const double scalar) const {
+    [[nodiscard]] constexpr ScalarVec3 operator/(const double scalar) const {
         return (*this) * (1.0 / scalar);
     }
 
@@ -79,15 +82,15 @@ struct Vec3 {
         return x * x + y * y + z * z;
     }
 
-    [[nodiscard]] constexpr double dot(const Vec3& other) const {
+    [[nodiscard]] constexpr double dot(const ScalarVec3& other) const {
         return x * other.x + y * other.y + z * other.z;
     }
 
-    [[nodiscard]] constexpr Vec3 cross(const Vec3& other) const {
-        return Vec3{ y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x };
+    [[nodiscard]] constexpr ScalarVec3 cross(const ScalarVec3& other) const {
+        return ScalarVec3{ y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x };
     }
 
-    [[nodiscard]] Vec3 normalized() const {
+    [[nodiscard]] ScalarVec3 normalized() const {
         return *this / length();
     }
 
@@ -96,11 +99,11 @@ struct Vec3 {
         return (std::abs(x) < epsilon && std::abs(y) < epsilon && std::abs(z) < epsilon);
     }
 
-    [[nodiscard]] Vec3 reflect(const Vec3& normal) const {
+    [[nodiscard]] ScalarVec3 reflect(const ScalarVec3& normal) const {
         return *this - 2.0 * this->dot(normal) * normal;
     }
 
-    [[nodiscard]] Vec3 refract(const Vec3& normal, const double refractionIndexRatio) const {
+    [[nodiscard]] ScalarVec3 refract(const ScalarVec3& normal, const double refractionIndexRatio) const {
         assert(std::abs(lengthSquared() - 1.0) <= 0.01);
         assert(std::abs(normal.lengthSquared() - 1.0) <= 0.01);
         const auto cosTheta = std::min(-(*this).dot(normal), 1.0);
@@ -124,10 +127,18 @@ struct Vec3 {
     };
 };
 
-inline std::ostream& operator<<(std::ostream& outStream, const Vec3& vector) {
+inline std::ostream& operator<<(std::ostream& outStream, const ScalarVec3& vector) {
     outStream << std::format("{} {} {}", vector.x, vector.y, vector.z);
     return outStream;
 }
 
+// The vector type of the whole tracer, switched to SimdVec3 by the CMake option RAYTRACER_SIMD_VEC3. Both have the
+// same interface, but not the same size: checkpoints, geometry files and the messages of distributed renders contain
+// raw vectors and can only be exchanged between builds that use the same type.
+#ifdef RAYTRACER_SIMD_VEC3
+using Vec3 = SimdVec3;
+#else
+using Vec3 = ScalarVec3;
+#endif
 using Point3 = Vec3;
 using Color = Vec3;
@@ -0,0 +1,332 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#pragma once
+
+#include "Camera.hpp"
+#include "FrameBuffer.hpp"
+#include "Material.hpp"
+#include "Ray.hpp"
+#include "RayFootprint.hpp"
+#include "Render.hpp"
+#include "Sampler.hpp"
+#include "Sampling.hpp"
+#include "Scene.hpp"
+#include "Statistics.hpp"
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Wavefront path tracing. Instead of following one path from the camera to its end before starting the next one, all
+// paths of a tile (every sample of every pixel of the pass) advance one bounce at a time through separate stages:
+//   generate: camera rays for all pixel samples
+//   extend:   closest hit and its intersection of every active path, paths that miss receive the background and end
+//   sort:     the hits are ordered by the type of their material (counting sort)
+//   shade:    one loop per material type scatters the paths and queues the shadow rays towards the environment
+//   shadow:   visibility of the queued light samples
+//   compact:  the scattered paths become the active paths of the next bounce
+// Every stage is a tight loop over arrays with one entry per path, and the shading of a material type runs as a batch,
+// which keeps the branches and the instruction cache of the material code warm when the materials of a scene are
+// mixed. Each path keeps its own sampler and draws the same random numbers in the same order as rayColor(). The
+// radiance is accumulated from the camera towards the lights though, so the images match those of the other kernels
+// up to floating point rounding, they are still independent of the number of threads.
+namespace WavefrontDetail {
+    inline constexpr auto numMaterialTypes = static_cast<std::size_t>(MaterialType::Dielectric) + 1;
+
+    // state of the paths of a tile, one array per attribute
+    template<typename SamplerType>
+    struct PathBuffers {
+        std::vector<SamplerType> samplers;
+        std::vector<Point3> origins;
+        std::vector<Vec3> directions;
+        std::vector<RayFootprint> footprints;
+        // product of the attenuations along the path so far
+        std::vector<Color> throughputs;
+        std::vector<Color> radiances;
+        std::vector<double> scatterPdfs;
+        std::vector<AovSample> aovSamples;
+        std::vector<double> hitDistances;
+        std::vector<IntersectionInfo> intersections;
+
+        // samples of the camera rays, the lens samples are warped onto the unit disk in one batch
+        std::vector<Sample2D> pixelSamples;
+        std::vector<double> lensU;
+        std::vector<double> lensV;
+        std::vector<double> lensX;
+        std::vector<double> lensY;
+
+        // indices of paths
+        std::vector<std::uint32_t> activePaths;
+        std::vector<std::uint32_t> nextActivePaths;
+        std::vector<std::uint32_t> hitPaths;
+        // hit paths ordered by material type, the paths of type i start at shadeQueueStarts[i]
+        std::vector<std::uint32_t> shadeQueue;
+        std::array<std::size_t, numMaterialTypes + 1> shadeQueueStarts{};
+
+        // light samples whose visibility has to be tested, the contribution already includes the throughput
+        std::vector<std::uint32_t> shadowPaths;
+        std::vector<Point3> shadowOrigins;
+        std::vector<Vec3> shadowDirections;
+        std::vector<Color> shadowContributions;
+
+        // the frame buffer index of every pixel, its paths are [pixelPathStarts[i], pixelPathStarts[i + 1])
+        std::vector<std::size_t> pixelIndices;
+        std::vector<std::uint32_t> pixelPathStarts;
+
+        // keeps the allocations of previous tiles
+        void resize(const std::size_t numPaths) {
+            samplers.resize(numPaths);
+            origins.resize(numPaths);
+            directions.resize(numPaths);
+            footprints.resize(numPaths);
+            throughputs.resize(numPaths);
+            radiances.resize(numPaths);
+            scatterPdfs.resize(numPaths);
+            aovSamples.resize(numPaths);
+            hitDistances.resize(numPaths);
+            intersections.resize(numPaths);
+            pixelSamples.resize(numPaths);
+            lensU.resize(numPaths);
+            lensV.resize(numPaths);
+            lensX.resize(numPaths);
+            lensY.resize(numPaths);
+            shadeQueue.resize(numPaths);
+        }
+    };
+
+    template<typename SamplerType>
+    void generate(const Tile& tile,
+                  const RenderSettings& settings,
+                  const std::uint32_t endSample,
+                  const SamplerType& prototype,
+                  const FrameBuffer& frameBuffer,
+                  const int originX,
+                  const int originY,
+                  PathBuffers<SamplerType>& paths) {
+        paths.pixelIndices.clear();
+        paths.pixelPathStarts.clear();
+        std::uint32_t numPaths = 0;
+        for (auto y = tile.startY; y < tile.endY; ++y) {
+            for (auto x = tile.startX; x < tile.endX; ++x) {
+                const auto index = frameBuffer.index(x - originX, y - originY);
+                const auto startSample = frameBuffer.sampleCount[index];
+                if (startSample < endSample) {
+                    paths.pixelIndices.push_back(index);
+                    paths.pixelPathStarts.push_back(numPaths);
+                    numPaths += endSample - startSample;
+                }
+            }
+        }
+        paths.pixelPathStarts.push_back(numPaths);
+        paths.resize(numPaths);
+
+        const auto pixelPosition = [&](const std::size_t pixel) {
+            const auto index = paths.pixelIndices[pixel];
+            return std::pair{ originX + static_cast<int>(index % static_cast<std::size_t>(frameBuffer.width)),
+                              originY + static_cast<int>(index / static_cast<std::size_t>(frameBuffer.width)) };
+        };
+        // same order of the sampler dimensions as RenderDetail::cameraRay()
+        for (std::size_t pixel = 0; pixel < paths.pixelIndices.size(); ++pixel) {
+            const auto [x, y] = pixelPosition(pixel);
+            auto sample = frameBuffer.sampleCount[paths.pixelIndices[pixel]];
+            for (auto path = paths.pixelPathStarts[pixel]; path < paths.pixelPathStarts[pixel + 1]; ++path, ++sample) {
+                auto& sampler = paths.samplers[path];
+                sampler = prototype;
+                sampler.startPixelSample(x, y, sample);
+                paths.pixelSamples[path] = sampler.get2D();
+                const auto lensSample = sampler.get2D();
+                paths.lensU[path] = lensSample.u;
+                paths.lensV[path] = lensSample.v;
+            }
+        }
+        Sampling::concentricDisk(paths.lensU, paths.lensV, paths.lensX, paths.lensY);
+
+        const Camera camera{ settings.camera };
+        const auto spacing = RenderDetail::sampleSpacing(settings);
+        paths.activePaths.clear();
+        for (std::size_t pixel = 0; pixel < paths.pixelIndices.size(); ++pixel) {
+            const auto [x, y] = pixelPosition(pixel);
+            for (auto path = paths.pixelPathStarts[pixel]; path < paths.pixelPathStarts[pixel + 1]; ++path) {
+                RayDifferential differential;
+                const auto ray = RenderDetail::cameraRay(camera, settings, x, y, spacing, paths.pixelSamples[path],
+                                                         Vec3{ paths.lensX[path], paths.lensY[path], 0.0 },
+                                                         differential);
+                paths.origins[path] = ray.origin;
+                paths.directions[path] = ray.direction;
+                paths.footprints[path] = RayFootprint::fromCameraRay(ray, differential);
+                paths.throughputs[path] = Color{ 1.0, 1.0, 1.0 };
+                paths.radiances[path] = Color{};
+                paths.scatterPdfs[path] = 0.0;
+                paths.aovSamples[path] = AovSample{};
+                paths.activePaths.push_back(path);
+            }
+        }
+    }
+
+    template<typename ObjectType, typename SamplerType>
+    void extend(const World& world,
+                const int bounce,
+                PathBuffers<SamplerType>& paths,
+                RenderStatistics& statistics) {
+        paths.hitPaths.clear();
+        for (const auto path : paths.activePaths) {
+            statistics.countRay(bounce);
+            const Ray ray{ paths.origins[path], paths.directions[path] };
+            const auto hit = closestHit<ObjectType>(world, ray, statistics);
+            if (hit) {
+                // Objects may cache their last hit for getIntersectionInfo() (e.g. streamed geometry), so the
+                // intersection is computed right away instead of in the sort stage.
+                const auto [t, objectIndex] = *hit;
+                const auto& object = static_cast<const ObjectType&>(*world.objects[objectIndex]);
+                auto& intersectionInfo = paths.intersections[path];
+                intersectionInfo = object.getIntersectionInfo(ray, t);
+                intersectionInfo.footprintWidth = paths.footprints[path].widthAt(ray, t, intersectionInfo);
+                paths.hitDistances[path] = t;
+                paths.hitPaths.push_back(path);
+                continue;
+            }
+            statistics.countPathEnd(bounce + 1);
+            const auto backgroundColor = background(world, ray);
+            if (bounce == 0) {
+                paths.aovSamples[path] =
+                        AovSample{ .albedo{ backgroundColor }, .normal{}, .depth{ AovSample::missDepth } };
+            }
+            auto radiance = backgroundColor;
+            if (world.environment && paths.scatterPdfs[path] > 0.0) {
+                // the environment has been sampled directly at the origin of this ray as well
+                radiance = powerHeuristic(paths.scatterPdfs[path], world.environment->pdf(ray.direction)) *
+                           backgroundColor;
+            }
+            paths.radiances[path] += paths.throughputs[path] * radiance;
+        }
+    }
+
+    // orders the hit paths by the type of their material
+    template<typename SamplerType>
+    void sortByMaterial(PathBuffers<SamplerType>& paths) {
+        std::array<std::size_t, numMaterialTypes> counts{};
+        for (const auto path : paths.hitPaths) {
+            ++counts[static_cast<std::size_t>(paths.intersections[path].material->type())];
+        }
+        paths.shadeQueueStarts[0] = 0;
+        for (std::size_t i = 0; i < numMaterialTypes; ++i) {
+            paths.shadeQueueStarts[i + 1] = paths.shadeQueueStarts[i] + counts[i];
+        }
+        auto positions = paths.shadeQueueStarts;
+        for (const auto path : paths.hitPaths) {
+            const auto type = static_cast<std::size_t>(paths.intersections[path].material->type());
+            paths.shadeQueue[positions[type]++] = path;
+        }
+    }
+
+    // scatters the paths of one material type and queues their light samples
+    template<typename ConcreteMaterial, typename SamplerType>
+    void shade(const World& world, const int bounce, PathBuffers<SamplerType>& paths, RenderStatistics& statistics) {
+        constexpr auto type = static_cast<std::size_t>(ConcreteMaterial::materialType);
+        for (auto i = paths.shadeQueueStarts[type]; i < paths.shadeQueueStarts[type + 1]; ++i) {
+            const auto path = paths.shadeQueue[i];
+            const Ray ray{ paths.origins[path], paths.directions[path] };
+            const auto& intersectionInfo = paths.intersections[path];
+            const auto& material = static_cast<const ConcreteMaterial&>(*intersectionInfo.material);
+            auto& sampler = paths.samplers[path];
+            if (bounce == 0) {
+                paths.aovSamples[path] = AovSample{ .albedo{ material.getAlbedo(intersectionInfo) },
+                                                    .normal{ intersectionInfo.normal },
+                                                    .depth{ paths.hitDistances[path] } };
+            }
+            const auto scattered = material.scatter(ray, intersectionInfo, sampler);
+            if (!scattered) {
+                statistics.countPathEnd(bounce + 1);
+                continue;
+            }
+            if (world.environment && scattered->pdf > 0.0) {
+                // sampleEnvironment() without the visibility test, which is done by the shadow stage
+                const auto lightSample = world.environment->sample(sampler.get2D());
+                const auto materialPdf = material.pdf(intersectionInfo, lightSample.direction);
+                if (lightSample.pdf > 0.0 && materialPdf > 0.0) {
+                    const auto directLight = material.evaluate(intersectionInfo, lightSample.direction) *
+                                             lightSample.radiance *
+                                             (powerHeuristic(lightSample.pdf, materialPdf) / lightSample.pdf);
+                    paths.shadowPaths.push_back(path);
+                    paths.shadowOrigins.push_back(intersectionInfo.intersectionPoint);
+                    paths.shadowDirections.push_back(lightSample.direction);
+                    paths.shadowContributions.push_back(paths.throughputs[path] * directLight);
+                }
+            }
+            paths.footprints[path] =
+                    paths.footprints[path].scattered(intersectionInfo.footprintWidth, scattered->spreadAngle);
+            paths.origins[path] = scattered->ray.origin;
+            paths.directions[path] = scattered->ray.direction;
+            paths.throughputs[path] = paths.throughputs[path] * scattered->attenuation;
+            paths.scatterPdfs[path] = scattered->pdf;
+            paths.nextActivePaths.push_back(path);
+        }
+    }
+
+    template<typename ObjectType, typename SamplerType>
+    void traceShadowRays(const World& world, PathBuffers<SamplerType>& paths, RenderStatistics& statistics) {
+        for (std::size_t i = 0; i < paths.shadowPaths.size(); ++i) {
+            if (!isOccluded<ObjectType>(world, Ray{ paths.shadowOrigins[i], paths.shadowDirections[i] }, statistics)) {
+                paths.radiances[paths.shadowPaths[i]] += paths.shadowContributions[i];
+            }
+        }
+        paths.shadowPaths.clear();
+        paths.shadowOrigins.clear();
+        paths.shadowDirections.clear();
+        paths.shadowContributions.clear();
+    }
+
+    // has the signature of renderTile(), ObjectType can be the concrete type of all objects of the world
+    template<typename SamplerType, typename ObjectType>
+    double renderTile(const Tile& tile,
+                      const World& world,
+                      const RenderSettings& settings,
+                      const std::uint32_t endSample,
+                      Sampler& sampler,
+                      RenderStatistics& statistics,
+                      FrameBuffer& frameBuffer,
+                      const int originX,
+                      const int originY) {
+        assert(dynamic_cast<SamplerType*>(&sampler) != nullptr);
+        const auto startTime = std::chrono::steady_clock::now();
+        // reused by all tiles of the thread
+        thread_local PathBuffers<SamplerType> paths;
+        generate(tile, settings, endSample, static_cast<const SamplerType&>(sampler), frameBuffer, originX, originY,
+                 paths);
+        auto bounce = 0;
+        for (; bounce < settings.maxDepth && !paths.activePaths.empty(); ++bounce) {
+            extend<ObjectType>(world, bounce, paths, statistics);
+            sortByMaterial(paths);
+            paths.nextActivePaths.clear();
+            shade<Lambertian>(world, bounce, paths, statistics);
+            shade<Metal>(world, bounce, paths, statistics);
+            shade<Dielectric>(world, bounce, paths, statistics);
+            traceShadowRays<ObjectType>(world, paths, statistics);
+            std::swap(paths.activePaths, paths.nextActivePaths);
+        }
+        for (std::size_t i = 0; i < paths.activePaths.size(); ++i) {
+            statistics.countPathEnd(bounce);
+        }
+
+        // the samples of every pixel are summed in the order of their indices, like in the other kernels
+        for (std::size_t pixel = 0; pixel < paths.pixelIndices.size(); ++pixel) {
+            Color pixelColor{};
+            AovSample pixelAov{ .albedo{}, .normal{}, .depth{ 0.0 } };
+            const auto pathsBegin = paths.pixelPathStarts[pixel];
+            const auto pathsEnd = paths.pixelPathStarts[pixel + 1];
+            for (auto path = pathsBegin; path < pathsEnd; ++path) {
+                pixelColor += paths.radiances[path];
+                pixelAov.albedo += paths.aovSamples[path].albedo;
+                pixelAov.normal += paths.aovSamples[path].normal;
+                pixelAov.depth += paths.aovSamples[path].depth;
+            }
+            frameBuffer.addSamples(paths.pixelIndices[pixel], pixelColor, pixelAov, pathsEnd - pathsBegin);
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+}// namespace WavefrontDetail
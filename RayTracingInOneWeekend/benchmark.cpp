@@ -0,0 +1,265 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+// Microbenchmarks of the hot kernels of the tracer. All inputs are generated from fixed seeds, so two runs measure
+// exactly the same work. Every benchmark is calibrated to run for at least minBatchDuration per repetition, the
+// reported numbers are the median and the minimum over all repetitions in nanoseconds per call.
+//
+// Usage: RayTracingInOneWeekendBenchmark [filter], only benchmarks whose name contains the filter are run
+
+#include "Camera.hpp"
+#include "Material.hpp"
+#include "Ray.hpp"
+#include "Sampler.hpp"
+#include "Sphere.hpp"
+#include "Texture.hpp"
+#include "Utility.hpp"
+#include "Vec3.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr std::size_t numInputs = 4096;// power of two, inputs are indexed with (i & (numInputs - 1))
+    constexpr auto numRepetitions = 15;
+    constexpr auto minBatchDuration = std::chrono::milliseconds{ 20 };
+    constexpr std::uint64_t inputSeed = 0x5eed'1234'abcd'0042;
+
+    // keeps the compiler from removing the computation of value
+    template<typename T>
+    void doNotOptimize(const T& value) {
+#ifdef _MSC_VER
+        static volatile const T* sink;
+        sink = &value;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    // replays a fixed table of samples, so that the scatter benchmarks don't measure the cost of a real sampler
+    class ReplaySampler : public Sampler {
+    public:
+        explicit ReplaySampler(const std::uint64_t seed) : mValues(numInputs) {
+            std::mt19937_64 engine{ seed };
+            std::uniform_real_distribution<double> distribution{ 0.0, 1.0 };
+            std::generate(mValues.begin(), mValues.end(), [&]() { return distribution(engine); });
+        }
+
+        void startPixelSample(int, int, std::uint32_t) override { }
+
+        [[nodiscard]] double get1D() override {
+            return mValues[mIndex++ & (numInputs - 1)];
+        }
+
+        [[nodiscard]] Sample2D get2D() override {
+            const auto u = get1D();
+            return Sample2D{ .u{ u }, .v{ get1D() } };
+        }
+
+        [[nodiscard]] std::unique_ptr<Sampler> clone() const override {
+            return std::make_unique<ReplaySampler>(*this);
+        }
+
+    private:
+        std::vector<double> mValues;
+        std::size_t mIndex{ 0 };
+    };
+
+    struct Inputs {
+        explicit Inputs(const std::uint64_t seed) {
+            std::mt19937_64 engine{ seed };
+            std::uniform_real_distribution<double> distribution{ 0.0, 1.0 };
+            const auto randomUnitVector = [&]() {
+                return Sampling::uniformSphere(Sample2D{ .u{ distribution(engine) }, .v{ distribution(engine) } });
+            };
+            for (std::size_t i = 0; i < numInputs; ++i) {
+                // rays start around the unit sphere at the origin, roughly half of them point towards it
+                const auto origin = 4.0 * randomUnitVector();
+                const auto target = 1.5 * randomUnitVector();
+                rays.emplace_back(origin, target - origin);
+                directions.push_back(randomUnitVector() * (0.5 + distribution(engine)));
+                const auto normal = randomUnitVector();
+                normals.push_back(normal);
+                // incoming directions in the hemisphere opposite of the normal, like at a real intersection
+                const auto incoming = randomUnitVector();
+                incomingDirections.push_back(incoming.dot(normal) < 0.0 ? incoming : -incoming);
+                screenPositions.push_back(Sample2D{ .u{ distribution(engine) }, .v{ distribution(engine) } });
+            }
+        }
+
+        std::vector<Ray> rays;
+        std::vector<Vec3> directions;
+        std::vector<Vec3> normals;
+        std::vector<Vec3> incomingDirections;
+        std::vector<Sample2D> screenPositions;
+    };
+
+    class BenchmarkRunner {
+    public:
+        explicit BenchmarkRunner(const std::string_view filter) : mFilter{ filter } {
+            std::cout << std::format("{:<40} {:>12} {:>12} {:>10}\n", "benchmark", "median ns/op", "min ns/op",
+                                     "spread");
+        }
+
+        // operation gets the index of the call and must feed its result into doNotOptimize
+        void run(const std::string_view name, const std::function<void(std::size_t)>& operation) const {
+            if (name.find(mFilter) == std::string_view::npos) {
+                return;
+            }
+            // the function call overhead is part of every measurement, it is the same for all benchmarks
+            std::size_t batchSize = 1;
+            while (measure(operation, batchSize) < minBatchDuration) {
+                batchSize *= 2;
+            }
+            std::vector<double> nanosecondsPerOperation;
+            for (int i = 0; i < numRepetitions; ++i) {
+                const auto duration = measure(operation, batchSize);
+                nanosecondsPerOperation.push_back(std::chrono::duration<double, std::nano>(duration).count() /
+                                                  static_cast<double>(batchSize));
+            }
+            std::sort(nanosecondsPerOperation.begin(), nanosecondsPerOperation.end());
+            const auto median = nanosecondsPerOperation[nanosecondsPerOperation.size() / 2];
+            const auto minimum = nanosecondsPerOperation.front();
+            // interquartile range relative to the median, large values indicate an unstable measurement
+            const auto spread = (nanosecondsPerOperation[nanosecondsPerOperation.size() * 3 / 4] -
+                                 nanosecondsPerOperation[nanosecondsPerOperation.size() / 4]) /
+                                median;
+            std::cout << std::format("{:<40} {:>12.2f} {:>12.2f} {:>9.1f}%\n", name, median, minimum, spread * 100.0)
+                      << std::flush;
+        }
+
+    private:
+        [[nodiscard]] static std::chrono::steady_clock::duration measure(
+                const std::function<void(std::size_t)>& operation,
+                const std::size_t batchSize) {
+            const auto startTime = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < batchSize; ++i) {
+                operation(i & (numInputs - 1));
+            }
+            return std::chrono::steady_clock::now() - startTime;
+        }
+
+    private:
+        std::string_view mFilter;
+    };
+
+    [[nodiscard]] IntersectionInfo createIntersectionInfo(const Inputs& inputs,
+                                                          const std::size_t index,
+                                                          std::shared_ptr<Material> material) {
+        IntersectionInfo result;
+        result.intersectionPoint = inputs.normals[index];
+        result.setFaceNormal(Ray{ Point3{}, inputs.incomingDirections[index] }, inputs.normals[index]);
+        result.material = std::move(material);
+        return result;
+    }
+
+    void benchmarkMaterial(const BenchmarkRunner& runner,
+                           const std::string_view name,
+                           const Inputs& inputs,
+                           const std::shared_ptr<Material>& material) {
+        std::vector<IntersectionInfo> intersections;
+        std::vector<Ray> incomingRays;
+        for (std::size_t i = 0; i < numInputs; ++i) {
+            intersections.push_back(createIntersectionInfo(inputs, i, material));
+            incomingRays.emplace_back(Point3{}, inputs.incomingDirections[i]);
+        }
+        ReplaySampler sampler{ inputSeed };
+        runner.run(name, [&](const std::size_t i) {
+            doNotOptimize(material->scatter(incomingRays[i], intersections[i], sampler));
+        });
+    }
+}// namespace
+
+int main(int argc, char** argv) {
+    const auto filter = std::string_view{ argc > 1 ? argv[1] : "" };
+    const BenchmarkRunner runner{ filter };
+    const Inputs inputs{ inputSeed };
+
+    const auto sphereMaterial = std::make_shared<Lambertian>(Color{ 0.5, 0.5, 0.5 });
+    const Sphere sphere{ Point3{}, 1.0, sphereMaterial };
+    runner.run("Sphere::hit", [&](const std::size_t i) {
+        doNotOptimize(sphere.hit(inputs.rays[i], 0.001, std::numeric_limits<double>::max()));
+    });
+    runner.run("Sphere::getIntersectionInfo", [&](const std::size_t i) {
+        doNotOptimize(sphere.getIntersectionInfo(inputs.rays[i], 3.0));
+    });
+
+    runner.run("Vec3::normalized", [&](const std::size_t i) { doNotOptimize(inputs.directions[i].normalized()); });
+    runner.run("Vec3::reflect", [&](const std::size_t i) {
+        doNotOptimize(inputs.incomingDirections[i].reflect(inputs.normals[i]));
+    });
+    runner.run("Vec3::refract", [&](const std::size_t i) {
+        doNotOptimize(inputs.incomingDirections[i].refract(inputs.normals[i], 1.0 / 1.5));
+    });
+
+    benchmarkMaterial(runner, "Lambertian::scatter", inputs, std::make_shared<Lambertian>(Color{ 0.5, 0.5, 0.5 }));
+    benchmarkMaterial(runner, "Metal::scatter", inputs, std::make_shared<Metal>(Color{ 0.7, 0.6, 0.5 }, 0.3));
+    benchmarkMaterial(runner, "Dielectric::scatter", inputs, std::make_shared<Dielectric>(1.5));
+
+    Random::seed(inputSeed);
+    runner.run("Random::randomDouble", [](const std::size_t) { doNotOptimize(Random::randomDouble()); });
+    runner.run("Random::randomUnitVector", [](const std::size_t) { doNotOptimize(Random::randomUnitVector()); });
+    runner.run("Random::randomInsideUnitDisk",
+               [](const std::size_t) { doNotOptimize(Random::randomInsideUnitDisk()); });
+
+    for (const auto& [name, type] : { std::pair{ "RandomSampler::get2D", SamplerType::Random },
+                                      std::pair{ "SobolSampler::get2D", SamplerType::Sobol },
+                                      std::pair{ "BlueNoiseSampler::get2D", SamplerType::BlueNoise } }) {
+        const auto sampler = createSampler(type, static_cast<std::uint32_t>(inputSeed));
+        // a new pixel sample every 8 dimensions, like a path with a few bounces
+        runner.run(name, [&](const std::size_t i) {
+            if ((i & 7) == 0) {
+                sampler->startPixelSample(static_cast<int>(i & 63), static_cast<int>(i >> 6),
+                                          static_cast<std::uint32_t>(i));
+            }
+            doNotOptimize(sampler->get2D());
+        });
+    }
+
+    // random coordinates are the worst case of incoherent secondary rays, the footprint selects the mip level
+    const auto textureImage = [&]() {
+        constexpr auto size = 1024;
+        TextureImage result{ .width{ size }, .height{ size }, .rgba{} };
+        std::mt19937_64 engine{ inputSeed };
+        std::uniform_int_distribution<int> distribution{ 0, 255 };
+        result.rgba.resize(static_cast<std::size_t>(size * size * 4));
+        std::generate(result.rgba.begin(), result.rgba.end(),
+                      [&]() { return static_cast<std::uint8_t>(distribution(engine)); });
+        return result;
+    }();
+    const Texture texture{ textureImage };
+    for (const auto& [name, footprint] : { std::pair{ "Texture::sample (level 0)", 0.0 },
+                                           std::pair{ "Texture::sample (level 4)", 16.0 / 1024.0 },
+                                           std::pair{ "Texture::sample (level 4.5)", 22.6 / 1024.0 } }) {
+        runner.run(name, [&](const std::size_t i) {
+            const auto& position = inputs.screenPositions[i];
+            doNotOptimize(texture.sample(TextureCoordinates{ .u{ position.u }, .v{ position.v } }, footprint));
+        });
+    }
+
+    const Camera camera{ CameraSettings{} };
+    ReplaySampler cameraSampler{ inputSeed };
+    runner.run("Camera::getRay", [&](const std::size_t i) {
+        const auto& position = inputs.screenPositions[i];
+        doNotOptimize(camera.getRay(position.u, position.v, cameraSampler));
+    });
+    return EXIT_SUCCESS;
+}
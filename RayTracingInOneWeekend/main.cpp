@@ -3,191 +3,680 @@
 #include "Hittable.hpp"
 #include "Sphere.hpp"
 #include "Camera.hpp"
+#include "Sampler.hpp"
+#include "EnvironmentMap.hpp"
+#include "Scene.hpp"
+#include "ChunkedGeometry.hpp"
+#include "Texture.hpp"
+#include "Render.hpp"
+#include "Integrator.hpp"
+#include "Distributed.hpp"
+#include "RenderServer.hpp"
+#include "FrameBuffer.hpp"
+#include "Denoiser.hpp"
+#include "Checkpoint.hpp"
+#include "Options.hpp"
+#include "RenderSetup.hpp"
+#include "Numa.hpp"
+#include "Preview.hpp"
 #include "Utility.hpp"
 #include "stb_image_write.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <deque>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <functional>
 #include <format>
 #include <limits>
 #include <memory>
+#include <span>
 #include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 #include <cstdint>
-#include <cstring>
-
-using World = std::vector<std::unique_ptr<Hittable>>;
-
-[[nodiscard]] Color backgroundGradient(const Ray& ray) {
-    const auto normalizedDirection = ray.direction.normalized();
-    const auto colorInterpolationParam = 0.5 * (normalizedDirection.y + 1.0);
-    return (1.0 - colorInterpolationParam) * Color{ 1.0, 1.0, 1.0 } + colorInterpolationParam * Color{ 0.5, 0.7, 1.0 };
-}
-
-[[nodiscard]] Color rayColor(const Ray& ray, const World& world, int depth) {
-    if (depth <= 0) {
-        return Color{};
-    }
-    auto minT = std::numeric_limits<double>::min();
-    bool hitSomething = false;
-    std::size_t hittableIndex = 0;
-    for (std::size_t i = 0; i < world.size(); ++i) {
-        const auto hitResult = world[i]->hit(ray, 0.001, std::numeric_limits<double>::max());
-        if (hitResult) {
-            if (!hitSomething || hitResult.value() < minT) {
-                minT = hitResult.value();
-                hitSomething = true;
-                hittableIndex = i;
+
+[[nodiscard]] Color gammaCorrection(const Color& color) {
+    return Color{ std::sqrt(color.r), std::sqrt(color.g), std::sqrt(color.b) };
+}
+
+// where the render threads run and which copy of the world each of them reads
+struct RenderThreads {
+    Numa::ThreadPlacement placement;
+    std::vector<const World*> worlds;
+
+    [[nodiscard]] unsigned int count() const {
+        return placement.numThreads();
+    }
+};
+
+// Renders the given tile until every pixel has endSample samples, the render time is added to the tile time. The frame
+// buffer covers the crop window of the settings.
+[[nodiscard]] auto createWorkerLambda(TileTime& tileTime,
+                                      const RenderThreads& threads,
+                                      const RenderTileFunction renderTile,
+                                      FrameBuffer& frameBuffer,
+                                      std::uint32_t endSample,
+                                      const RenderSettings& settings,
+                                      const Sampler& samplerPrototype,
+                                      std::vector<RenderStatistics>& threadStatistics) {
+    return [&tileTime, &threads, renderTile, &frameBuffer, endSample, &settings, &samplerPrototype,
+            &threadStatistics](const unsigned int threadIndex) {
+        const auto sampler = samplerPrototype.clone();
+        // every task owns its tile of the frame buffer, so no synchronization is needed when writing
+        tileTime.seconds += renderTile(tileTime.tile, *threads.worlds[threadIndex], settings, endSample, *sampler,
+                                       threadStatistics[threadIndex], frameBuffer, settings.cropWindow.startX,
+                                       settings.cropWindow.startY);
+    };
+}
+
+using TaskQueue = std::deque<std::function<void(unsigned int)>>;
+
+// The tasks get the index of the thread that executes them. There is one queue per NUMA node of the thread placement,
+// the threads of a node take the tasks of their own queue first and help out the other nodes afterwards.
+void runTasks(std::vector<TaskQueue>& queues, const RenderThreads& threads) {
+    assert(queues.size() == threads.placement.numNodes);
+    std::mutex mTasksMutex;
+    std::vector<std::jthread> workerThreads;
+    for (unsigned int i = 0; i < threads.count(); ++i) {
+        workerThreads.emplace_back([&queues, &threads, &mTasksMutex, i]() {
+            if (const auto cpu = threads.placement.cpus[i]) {
+                Numa::pinCurrentThread(*cpu);
+            }
+            const auto ownQueue = threads.placement.nodeIndices[i];
+            while (true) {
+                std::function<void(unsigned int)> task;
+                {
+                    auto lock = std::scoped_lock{ mTasksMutex };
+                    for (std::size_t j = 0; j < queues.size() && !task; ++j) {
+                        auto& queue = queues[(ownQueue + j) % queues.size()];
+                        if (queue.empty()) {
+                            continue;
+                        }
+                        // other nodes take the tasks from the back, so that the owner keeps its tiles in order
+                        if (j == 0) {
+                            task = std::move(queue.front());
+                            queue.pop_front();
+                        } else {
+                            task = std::move(queue.back());
+                            queue.pop_back();
+                        }
+                    }
+                }
+                if (!task) {
+                    break;
+                }
+                task(i);
             }
+        });
+    }
+    for (auto& thread : workerThreads) {
+        thread.join();
+    }
+}
+
+// Distributes the tasks of consecutive tiles to the queues of the nodes in bands, so that every node writes to its
+// own part of the frame buffer.
+[[nodiscard]] std::vector<TaskQueue> distributeTasks(TaskQueue tasks, const RenderThreads& threads) {
+    const auto numNodes = threads.placement.numNodes;
+    std::vector<TaskQueue> result(numNodes);
+    const auto numTasks = tasks.size();
+    for (std::size_t i = 0; i < numTasks; ++i) {
+        result[i * numNodes / numTasks].push_back(std::move(tasks[i]));
+    }
+    return result;
+}
+
+// Identifies the image that the settings and the scene produce. The path scheduling is left out since both
+// schedulings render the same image. Of streamed geometry only the materials and the chunk table are included,
+// reading all spheres would take as long as loading them.
+[[nodiscard]] std::uint64_t renderFingerprint(const RenderSettings& settings,
+                                              const Scene& scene,
+                                              const ChunkedGeometry::ChunkCache* const geometryCache) {
+    Fingerprint fingerprint;
+    fingerprint.add(settings.imageWidth);
+    fingerprint.add(settings.imageHeight);
+    fingerprint.add(settings.samplesPerPixel);
+    fingerprint.add(settings.maxDepth);
+    fingerprint.add(settings.samplerType);
+    const auto& camera = settings.camera;
+    addToFingerprint(fingerprint, camera.lookFrom);
+    addToFingerprint(fingerprint, camera.lookAt);
+    addToFingerprint(fingerprint, camera.up);
+    fingerprint.add(camera.verticalFOV);
+    fingerprint.add(camera.aspectRatio);
+    fingerprint.add(camera.aperture);
+    fingerprint.add(camera.focusDistance);
+    fingerprint.add(settings.cropWindow.startX);
+    fingerprint.add(settings.cropWindow.startY);
+    fingerprint.add(settings.cropWindow.endX);
+    fingerprint.add(settings.cropWindow.endY);
+
+    scene.addToFingerprint(fingerprint);
+
+    fingerprint.add(geometryCache != nullptr);
+    if (geometryCache) {
+        const auto& file = geometryCache->file();
+        fingerprint.add(file.numSpheres);
+        fingerprint.add(file.materials.size());
+        for (const auto& material : file.materials) {
+            addToFingerprint(fingerprint, material);
+        }
+        fingerprint.add(file.chunks.size());
+        for (const auto& chunk : file.chunks) {
+            addToFingerprint(fingerprint, chunk.bounds.min);
+            addToFingerprint(fingerprint, chunk.bounds.max);
+            fingerprint.add(chunk.offset);
+            fingerprint.add(chunk.numSpheres);
         }
     }
-    if (!hitSomething) {
-        return backgroundGradient(ray);
+    return fingerprint.value();
+}
+
+[[nodiscard]] std::optional<Checkpoint> openOrCreateCheckpoint(const Options& options,
+                                                               FrameBuffer& frameBuffer,
+                                                               const std::uint32_t samplesPerPixel,
+                                                               const std::uint64_t fingerprint) {
+    if (!options.resume) {
+        auto checkpoint = Checkpoint::create(options.checkpointPath, frameBuffer.width, frameBuffer.height,
+                                             samplesPerPixel, fingerprint);
+        if (!checkpoint) {
+            std::cerr << std::format("Unable to create checkpoint file {}\n", options.checkpointPath);
+        }
+        return checkpoint;
+    }
+    auto checkpoint = Checkpoint::open(options.checkpointPath);
+    if (!checkpoint) {
+        std::cerr << std::format("Unable to open checkpoint file {}\n", options.checkpointPath);
+        return {};
+    }
+    if (checkpoint->width() != frameBuffer.width || checkpoint->height() != frameBuffer.height ||
+        checkpoint->samplesPerPixel() != samplesPerPixel || checkpoint->fingerprint() != fingerprint) {
+        std::cerr << std::format("Checkpoint file {} belongs to a different render\n", options.checkpointPath);
+        return {};
     }
-    const auto intersectionInfo = world[hittableIndex]->getIntersectionInfo(ray, minT);
+    checkpoint->restore(frameBuffer);
+    return checkpoint;
+}
 
-    const auto scatterResult = intersectionInfo.material->scatter(ray, intersectionInfo);
-    if (!scatterResult) {
-        return Color{};
+// reports the error itself, the caller only decides whether to go on
+[[nodiscard]] bool writeImage(const char* const filename,
+                              const int width,
+                              const int height,
+                              const std::vector<Color>& pixels) {
+    std::vector<std::uint8_t> imageBuffer(static_cast<std::size_t>(width * height * 4));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            writeColor(imageBuffer, static_cast<std::size_t>(width), x, y,
+                       pixels[static_cast<std::size_t>(y * width + x)]);
+        }
+    }
+    stbi_flip_vertically_on_write(true);
+    if (stbi_write_png(filename, width, height, 4, imageBuffer.data(), 4 * width) == 0) {
+        std::cerr << std::format("Unable to write {}\n", filename);
+        return false;
     }
-    return scatterResult->attenuation * rayColor(scatterResult->ray, world, depth - 1);
+    return true;
 }
 
-[[nodiscard]] Color gammaCorrection(const Color& color) {
-    return Color{ std::sqrt(color.r), std::sqrt(color.g), std::sqrt(color.b) };
+// Regression check for changes that must not alter the image: the same settings have to produce exactly the same image
+// regardless of the number of threads, since every (pixel, sample) pair has its own random numbers and the samples of
+// a pixel are always accumulated in the same order.
+[[nodiscard]] bool matchesGoldenImage(const std::string& imagePath, const std::string& goldenImagePath) {
+    const auto image = TextureImage::load(imagePath);
+    const auto goldenImage = TextureImage::load(goldenImagePath);
+    if (!image || !goldenImage) {
+        std::cerr << std::format("Unable to load {}\n", !image ? imagePath : goldenImagePath);
+        return false;
+    }
+    if (image->width != goldenImage->width || image->height != goldenImage->height) {
+        std::cerr << std::format("The image has {}x{} pixels, the golden image {}x{}\n", image->width, image->height,
+                                 goldenImage->width, goldenImage->height);
+        return false;
+    }
+    std::size_t numDifferentPixels = 0;
+    auto maxDifference = 0;
+    for (std::size_t i = 0; i < image->rgba.size(); i += 4) {
+        auto isDifferent = false;
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            const auto difference = std::abs(image->rgba[i + channel] - goldenImage->rgba[i + channel]);
+            maxDifference = std::max(maxDifference, difference);
+            isDifferent = isDifferent || difference != 0;
+        }
+        numDifferentPixels += isDifferent ? 1 : 0;
+    }
+    if (numDifferentPixels > 0) {
+        std::cerr << std::format("{} pixels differ from {} (by up to {})\n", numDifferentPixels, goldenImagePath,
+                                 maxDifference);
+        return false;
+    }
+    std::cout << std::format("The image is identical to {}\n", goldenImagePath);
+    return true;
 }
 
-[[nodiscard]] auto createWorkerLambda(int startLine,
-                                      int endLine,
-                                      int imageWidth,
-                                      int imageHeight,
-                                      const World& world,
-                                      std::vector<std::uint8_t>& imageBuffer,
-                                      std::mutex& imageBufferMutex,
-                                      int samplesPerPixel,
-                                      int maxDepth) {
-    return [imageWidth, imageHeight, &world, localBuffer = imageBuffer, &imageBuffer, &imageBufferMutex,
-            samplesPerPixel, startLine, endLine, maxDepth]() mutable {
-        std::cout << std::format("Calculating from line {} to line {}...\n", startLine, endLine) << std::flush;
-        for (auto y = startLine; y <= endLine; ++y) {
-            for (int x = 0; x < imageWidth; ++x) {
-                Color pixelColor{};
-                for (int sample = 0; sample < samplesPerPixel; ++sample) {
-                    const auto u = (static_cast<double>(x) + Random::randomDouble()) / static_cast<double>(imageWidth);
-                    const auto v = (static_cast<double>(y) + Random::randomDouble()) / static_cast<double>(imageHeight);
-                    const auto ray = Camera::getRay(u, v);
-                    pixelColor += rayColor(ray, world, maxDepth);
-                }
-                pixelColor /= static_cast<double>(samplesPerPixel);
-                pixelColor = gammaCorrection(pixelColor);
-                writeColor(localBuffer, imageWidth, x, y, pixelColor);
+[[nodiscard]] bool writeAovImages(const FrameBuffer& frameBuffer) {
+    if (!writeImage("raytracer_albedo.png", frameBuffer.width, frameBuffer.height, frameBuffer.albedo)) {
+        return false;
+    }
+
+    std::vector<Color> pixels(frameBuffer.numPixels());
+    std::transform(frameBuffer.normal.cbegin(), frameBuffer.normal.cend(), pixels.begin(),
+                   [](const Vec3& normal) { return 0.5 * (normal + Vec3{ 1.0, 1.0, 1.0 }); });
+    if (!writeImage("raytracer_normal.png", frameBuffer.width, frameBuffer.height, pixels)) {
+        return false;
+    }
+
+    auto maxDepth = 0.0;
+    for (const auto depth : frameBuffer.depth) {
+        if (depth < AovSample::missDepth) {
+            maxDepth = std::max(maxDepth, depth);
+        }
+    }
+    std::transform(frameBuffer.depth.cbegin(), frameBuffer.depth.cend(), pixels.begin(),
+                   [maxDepth](const double depth) {
+                       const auto brightness = 1.0 - std::min(depth / maxDepth, 1.0);
+                       return Color{ brightness, brightness, brightness };
+                   });
+    return writeImage("raytracer_depth.png", frameBuffer.width, frameBuffer.height, pixels);
+}
+
+// renders the image in passes of samplesPerPass samples, saves a checkpoint between two passes from time to time
+[[nodiscard]] RenderReport renderPasses(const RenderThreads& threads,
+                                        const RenderTileFunction renderTile,
+                                        const RenderSettings& settings,
+                                        const Sampler& samplerPrototype,
+                                        FrameBuffer& frameBuffer,
+                                        Checkpoint& checkpoint,
+                                        const Options& options,
+                                        const std::uint32_t samplesPerPass,
+                                        const int tileSize) {
+    auto lastCheckpointTime = std::chrono::steady_clock::now();
+    RenderReport report;
+    for (const auto& tile : createTiles(settings.cropWindow, tileSize)) {
+        report.tileTimes.push_back(TileTime{ .tile{ tile }, .seconds{ 0.0 } });
+    }
+    std::vector<RenderStatistics> threadStatistics(threads.count());
+
+    const auto firstSample = *std::min_element(frameBuffer.sampleCount.cbegin(), frameBuffer.sampleCount.cend());
+    if (options.resume) {
+        std::cout << std::format("Resuming at sample {} of {}\n", firstSample, settings.samplesPerPixel);
+    }
+    for (auto passStartSample = firstSample; passStartSample < settings.samplesPerPixel;
+         passStartSample += samplesPerPass) {
+        const auto passEndSample = std::min(passStartSample + samplesPerPass, settings.samplesPerPixel);
+        std::cout << std::format("Rendering samples {} to {} of {}...\n", passStartSample, passEndSample,
+                                 settings.samplesPerPixel)
+                  << std::flush;
+        TaskQueue tasks;
+        for (auto& tileTime : report.tileTimes) {
+            tasks.push_back(createWorkerLambda(tileTime, threads, renderTile, frameBuffer, passEndSample, settings,
+                                               samplerPrototype, threadStatistics));
+        }
+        auto queues = distributeTasks(std::move(tasks), threads);
+        runTasks(queues, threads);
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto secondsSinceCheckpoint = std::chrono::duration<double>(now - lastCheckpointTime).count();
+        if (passEndSample < settings.samplesPerPixel && secondsSinceCheckpoint >= options.checkpointIntervalSeconds) {
+            if (checkpoint.save(frameBuffer)) {
+                std::cout << std::format("Saved checkpoint after {} samples per pixel\n", passEndSample);
+            } else {
+                std::cerr << std::format("Unable to save checkpoint file {}\n", options.checkpointPath);
             }
+            lastCheckpointTime = now;
         }
-        constexpr auto pixelSize = sizeof(std::uint8_t) * 4;
-        const auto offset = (imageWidth * startLine) * pixelSize;
-        const auto size = (endLine - startLine + 1) * imageWidth * pixelSize;
-        {
-            // write the data into the outside buffer
-            auto bufferLock = std::scoped_lock{ imageBufferMutex };
-            std::memcpy(imageBuffer.data() + offset, localBuffer.data() + offset, size);
+    }
+    for (const auto& statistics : threadStatistics) {
+        report.statistics += statistics;
+    }
+    return report;
+}
+
+// Renders previews at 1/previewFactor, 1/(previewFactor/2), ..., 1/2 of the resolution, each one replaces the
+// preview image of the previous one. The previews are neither denoised nor checkpointed.
+void renderPreviews(const RenderThreads& threads,
+                    const RenderTileFunction renderTile,
+                    const RenderSettings& settings,
+                    const Sampler& samplerPrototype,
+                    const int previewFactor,
+                    const int tileSize) {
+    constexpr auto previewSamplesPerPixel = 4U;
+    std::vector<RenderStatistics> threadStatistics(threads.count());
+    for (auto factor = previewFactor; factor >= 2; factor /= 2) {
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto previewSettings = Preview::createSettings(settings, factor, previewSamplesPerPixel);
+        const auto& previewCrop = previewSettings.cropWindow;
+        FrameBuffer previewBuffer{ previewCrop.width(), previewCrop.height() };
+        std::vector<TileTime> tileTimes;
+        for (const auto& tile : createTiles(previewCrop, tileSize)) {
+            tileTimes.push_back(TileTime{ .tile{ tile }, .seconds{ 0.0 } });
         }
-        std::cout << std::format("Finished calculating lines {} to {}...\n", startLine, endLine) << std::flush;
-    };
+        TaskQueue tasks;
+        for (auto& tileTime : tileTimes) {
+            tasks.push_back(createWorkerLambda(tileTime, threads, renderTile, previewBuffer, previewSamplesPerPixel,
+                                               previewSettings, samplerPrototype, threadStatistics));
+        }
+        auto queues = distributeTasks(std::move(tasks), threads);
+        runTasks(queues, threads);
+
+        auto colors = Preview::upscale(previewBuffer.resolved(), previewSettings, settings);
+        std::transform(colors.cbegin(), colors.cend(), colors.begin(), gammaCorrection);
+        if (!writeImage("raytracer_preview.png", settings.cropWindow.width(), settings.cropWindow.height(), colors)) {
+            continue;
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << std::format("Wrote 1/{} resolution preview ({}x{}) in {:.2f} s\n", factor,
+                                 previewSettings.imageWidth, previewSettings.imageHeight, seconds)
+                  << std::flush;
+    }
 }
 
-int main() {
-    // image dimensions
-    constexpr auto imageWidth = 1200;
-    constexpr auto imageHeight = static_cast<int>(imageWidth / Camera::aspectRatio);
-    constexpr auto samplesPerPixel = 500;
-    constexpr auto maxDepth = 50;
-
-    // generate the world
-    World world;
-    const auto materialGround = std::make_shared<Lambertian>(Color{ 0.5, 0.5, 0.5 });
-    world.emplace_back(std::make_unique<Sphere>(Point3{ 0.0, -1000.0, -1.0 }, 1000.0, materialGround));
-
-    for (int i = -11; i < 11; ++i) {
-        for (int j = -11; j < 11; ++j) {
-            const auto center = Point3{ static_cast<double>(i) + 0.9 * Random::randomDouble(), 0.2,
-                                        static_cast<double>(j) + 0.9 * Random::randomDouble() };
-            if ((center - Point3{ 4.0, 0.2, 0.0 }).length() > 0.9) {
-                const auto chooseMat = Random::randomDouble();
-                std::shared_ptr<Material> material;
-                if (chooseMat < 0.8) {
-                    const auto albedo = Random::randomVec3() * Random::randomVec3();
-                    material = std::make_shared<Lambertian>(albedo);
-                    world.emplace_back(std::make_unique<Sphere>(center, 0.2, material));
-                } else if (chooseMat < 0.95) {
-                    const auto albedo = Random::randomVec3(0.5, 1.0);
-                    const auto fuzz = Random::randomDouble(0.0, 0.5);
-                    material = std::make_shared<Metal>(albedo, fuzz);
-                    world.emplace_back(std::make_unique<Sphere>(center, 0.2, material));
-                } else {
-                    material = std::make_shared<Dielectric>(1.5);
-                    world.emplace_back(std::make_unique<Sphere>(center, 0.2, material));
-                }
+// distributes the image to remote workers and/or workers running in this process
+[[nodiscard]] std::optional<FrameBuffer> renderDistributed(const Scene& scene,
+                                                           const RenderSettings& settings,
+                                                           const Options& options,
+                                                           const int tileSize,
+                                                           const unsigned int numThreads,
+                                                           RenderReport& report) {
+    RenderCoordinator coordinator{ *options.coordinatorPort };
+    if (!coordinator.isListening()) {
+        std::cerr << std::format("Unable to listen on port {}\n", *options.coordinatorPort);
+        return {};
+    }
+    std::vector<std::jthread> loopbackWorkers;
+    const auto threadsPerWorker = std::max(1U, numThreads / std::max(1U, options.numLoopbackWorkers));
+    for (unsigned int i = 0; i < options.numLoopbackWorkers; ++i) {
+        loopbackWorkers.emplace_back([port = std::to_string(*options.coordinatorPort), threadsPerWorker]() {
+            static_cast<void>(RenderWorker::run("127.0.0.1", port, threadsPerWorker));
+        });
+    }
+    auto frameBuffer = coordinator.render(scene, settings, tileSize);
+    report = RenderReport{ .statistics{ coordinator.statistics() }, .tileTimes{ coordinator.tileTimes() } };
+    return frameBuffer;
+}
+
+// Pins the render threads if requested and builds the world they read from, either once (in the interleaved memory
+// of all NUMA nodes) or once per node in its local memory.
+[[nodiscard]] RenderThreads createRenderThreads(const Scene& scene,
+                                                const Options& options,
+                                                const unsigned int numThreads,
+                                                std::vector<World>& worlds) {
+    const auto bvhSettings = BvhSettings{ .type{ options.bvhType } };
+    if (!options.pinThreads && options.numaPlacement == NumaPlacement::None) {
+        worlds.push_back(scene.buildWorld(bvhSettings));
+        return RenderThreads{ .placement{ Numa::ThreadPlacement::unpinned(numThreads) },
+                              .worlds{ std::vector<const World*>(numThreads, &worlds.front()) } };
+    }
+    const auto nodes = Numa::topology();
+    auto placement = Numa::ThreadPlacement::pinned(nodes, numThreads);
+    std::cout << std::format("Pinning {} render threads to the CPUs of {} NUMA node(s)\n", numThreads, nodes.size());
+    switch (options.numaPlacement) {
+        case NumaPlacement::None:
+            worlds.push_back(scene.buildWorld(bvhSettings));
+            // without replicas, the threads of all nodes can share one queue
+            placement.nodeIndices.assign(numThreads, 0);
+            placement.numNodes = 1;
+            break;
+        case NumaPlacement::Interleave:
+            worlds.push_back(Numa::withInterleavedMemory(nodes, [&]() { return scene.buildWorld(bvhSettings); }));
+            break;
+        case NumaPlacement::Replicate: {
+            // every replica is built by a thread of its node, so that its memory is allocated there
+            worlds.resize(nodes.size());
+            std::vector<std::jthread> builders;
+            for (std::size_t i = 0; i < nodes.size(); ++i) {
+                builders.emplace_back([&, i]() {
+                    Numa::pinCurrentThread(nodes[i].cpus.front());
+                    worlds[i] = scene.buildWorld(bvhSettings);
+                });
             }
+            break;
         }
     }
-    auto material1 = std::make_shared<Dielectric>(1.5);
-    world.emplace_back(std::make_unique<Sphere>(Point3(0, 1, 0), 1.0, material1));
+    std::vector<const World*> threadWorlds;
+    for (const auto nodeIndex : placement.nodeIndices) {
+        threadWorlds.push_back(&worlds[worlds.size() == 1 ? 0 : nodeIndex]);
+    }
+    return RenderThreads{ .placement{ std::move(placement) }, .worlds{ std::move(threadWorlds) } };
+}
 
-    auto material2 = std::make_shared<Lambertian>(Color(0.4, 0.2, 0.1));
-    world.emplace_back(std::make_unique<Sphere>(Point3(-4, 1, 0), 1.0, material2));
+// the pages of the frame buffer get allocated on the node of the render thread that writes them first
+void releaseForFirstTouch(FrameBuffer& frameBuffer) {
+    Numa::releaseForFirstTouch(frameBuffer.color);
+    Numa::releaseForFirstTouch(frameBuffer.albedo);
+    Numa::releaseForFirstTouch(frameBuffer.normal);
+    Numa::releaseForFirstTouch(frameBuffer.depth);
+    Numa::releaseForFirstTouch(frameBuffer.sampleCount);
+}
 
-    auto material3 = std::make_shared<Metal>(Color(0.7, 0.6, 0.5), 0.0);
-    world.emplace_back(std::make_unique<Sphere>(Point3(4, 1, 0), 1.0, material3));
+// Every tile is colored according to its render time per pixel (smaller tiles at the border of the image would look
+// cheap otherwise), from black (fastest) over red and yellow to white (slowest).
+// The heatmap covers the given region of the image, the parts of the tiles outside of it are left out.
+[[nodiscard]] bool writeHeatmap(const char* const filename,
+                                const Tile& region,
+                                const std::vector<TileTime>& tileTimes) {
+    if (tileTimes.empty()) {
+        return true;
+    }
+    std::vector<double> secondsPerPixel;
+    for (const auto& [tile, seconds] : tileTimes) {
+        secondsPerPixel.push_back(seconds / static_cast<double>(tile.width() * tile.height()));
+    }
+    const auto [fastest, slowest] = std::minmax_element(secondsPerPixel.cbegin(), secondsPerPixel.cend());
+    std::cerr << std::format("Render time per pixel: {:.2f} us to {:.2f} us\n", *fastest * 1.0e6, *slowest * 1.0e6);
+    const auto range = std::max(*slowest - *fastest, 1.0e-12);
+    const auto width = region.width();
+    const auto height = region.height();
+    std::vector<Color> pixels(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+    for (std::size_t i = 0; i < tileTimes.size(); ++i) {
+        const auto& tile = tileTimes[i].tile;
+        const auto heat = 3.0 * (secondsPerPixel[i] - *fastest) / range;
+        const auto color = Color{ std::clamp(heat, 0.0, 1.0), std::clamp(heat - 1.0, 0.0, 1.0),
+                                  std::clamp(heat - 2.0, 0.0, 1.0) };
+        for (auto y = std::max(tile.startY, region.startY); y < std::min(tile.endY, region.endY); ++y) {
+            for (auto x = std::max(tile.startX, region.startX); x < std::min(tile.endX, region.endX); ++x) {
+                pixels[static_cast<std::size_t>((y - region.startY) * width + x - region.startX)] = color;
+            }
+        }
+    }
+    return writeImage(filename, width, height, pixels);
+}
 
-    const auto startTime = std::chrono::high_resolution_clock::now();
+int main(int argc, char** argv) {
+    const auto options = CommandLine::parse(argc, argv);
+    if (!options) {
+        return EXIT_FAILURE;
+    }
 
-    std::vector<std::uint8_t> imageBuffer(static_cast<std::size_t>(imageWidth * imageHeight * 4));
-    std::mutex imageBufferMutex;
+    const auto hardwareThreads = std::thread::hardware_concurrency();
+    const auto numThreads = options->numThreads > 0
+                                    ? options->numThreads
+                                    : std::max(1U, (hardwareThreads == 0 ? 4 : hardwareThreads * 7 / 8));
+    if (options->workerHost) {
+        // workers get everything else from the coordinator
+        return RenderWorker::run(*options->workerHost, options->workerPort, numThreads) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    const auto numThreads =
-            (std::thread::hardware_concurrency() == 0 ? 4 : std::thread::hardware_concurrency() * 7 / 8);
-    const auto numTasks = numThreads * 2;
-    const int linesPerTask = imageHeight / numTasks;
-    std::deque<std::function<void(void)>> tasks;
+    if (options->serverPort) {
+        RenderServer server{ *options->serverPort };
+        if (!server.isListening()) {
+            std::cerr << std::format("Unable to listen on port {}\n", *options->serverPort);
+            return EXIT_FAILURE;
+        }
+        server.run(numThreads);
+        return EXIT_SUCCESS;
+    }
 
-    int currentEndLine = linesPerTask;
-    while (currentEndLine < imageHeight - 1) {
-        const auto newEndLine = std::min(currentEndLine + linesPerTask, imageHeight - 1);
-        tasks.push_back(createWorkerLambda(currentEndLine, newEndLine, imageWidth, imageHeight, world, imageBuffer,
-                                           imageBufferMutex, samplesPerPixel, maxDepth));
-        currentEndLine = newEndLine;
+    // image dimensions
+    const auto imageWidth = options->imageWidth;
+    const auto imageHeight = RenderSetup::imageHeight(*options);
+    auto cropWindow = Tile::wholeImage(imageWidth, imageHeight);
+    if (options->crop) {
+        // the rows of the image are stored from the bottom to the top
+        const auto& crop = *options->crop;
+        cropWindow = Tile{ .startX{ crop.x },
+                           .startY{ imageHeight - crop.y - crop.height },
+                           .endX{ crop.x + crop.width },
+                           .endY{ imageHeight - crop.y } };
+        if (!Tile::wholeImage(imageWidth, imageHeight).contains(cropWindow)) {
+            std::cerr << std::format("The crop window does not fit into the image ({}x{})\n", imageWidth, imageHeight);
+            return EXIT_FAILURE;
+        }
     }
-    std::mutex mTasksMutex;
-    std::cout << std::format("Total image height: {}\n", imageHeight);
-    std::vector<std::jthread> workerThreads;
-    for (std::remove_cv_t<decltype(numThreads)> i = 0; i < numThreads; ++i) {
-        workerThreads.emplace_back([&tasks, &mTasksMutex]() {
-            while (true) {
-                std::function<void(void)> task;
-                {
-                    auto lock = std::scoped_lock{ mTasksMutex };
-                    if (tasks.empty()) {
-                        break;
-                    }
-                    task = std::move(tasks.front());
-                    tasks.pop_front();
-                }
-                task();
-            }
-        });
+    // The denoiser filters every pixel together with its neighbors, which are missing at the border of a crop
+    // window. So that a denoised crop is identical to the same part of a full render, the crop is rendered and
+    // denoised with a margin of the filter footprint that is cut off afterwards.
+    const auto denoiserSettings = DenoiserSettings{};
+    auto renderWindow = cropWindow;
+    if (options->denoise) {
+        const auto margin = Denoiser::footprintRadius(denoiserSettings);
+        renderWindow = Tile{ .startX{ std::max(0, cropWindow.startX - margin) },
+                             .startY{ std::max(0, cropWindow.startY - margin) },
+                             .endX{ std::min(imageWidth, cropWindow.endX + margin) },
+                             .endY{ std::min(imageHeight, cropWindow.endY + margin) } };
     }
-    for (auto& thread : workerThreads) {
-        thread.join();
+    const auto settings = RenderSetup::createRenderSettings(*options, renderWindow);
+    // checkpoints can only be written between two passes
+    constexpr auto samplesPerPass = 4U;
+    constexpr auto tileSize = 32;
+
+    auto createdScene = RenderSetup::createScene(*options);
+    if (!createdScene) {
+        return EXIT_FAILURE;
+    }
+    auto scene = std::move(*createdScene);
+    if (options->writeGeometryPath) {
+        const auto success = ChunkedGeometry::write(*options->writeGeometryPath, scene, options->spheresPerChunk);
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    std::shared_ptr<ChunkedGeometry::ChunkCache> geometryCache;
+    if (options->geometryPath) {
+        auto geometryFile = ChunkedGeometry::GeometryFile::load(*options->geometryPath);
+        if (!geometryFile) {
+            std::cerr << std::format("Invalid geometry file {}\n", *options->geometryPath);
+            return EXIT_FAILURE;
+        }
+        std::cout << std::format("Streaming {} spheres in {} chunks from {}\n", geometryFile->numSpheres,
+                                 geometryFile->chunks.size(), *options->geometryPath);
+        geometryCache = std::make_shared<ChunkedGeometry::ChunkCache>(std::move(*geometryFile),
+                                                                      options->geometryBudgetMiB * 1024 * 1024);
+        // the spheres of the file replace those of the demo scene
+        scene.spheres.clear();
+        scene.materials.clear();
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    FrameBuffer frameBuffer{ renderWindow.width(), renderWindow.height() };
+    std::optional<Checkpoint> checkpoint;
+    RenderReport report;
+    if (options->clientHost) {
+        const auto sceneName = RenderServerDetail::toSceneName(options->sceneName);
+        if (!sceneName) {
+            std::cerr << std::format("Invalid scene name: {}\n", options->sceneName);
+            return EXIT_FAILURE;
+        }
+        RenderClient client;
+        if (!client.connect(*options->clientHost, options->clientPort)) {
+            return EXIT_FAILURE;
+        }
+        const auto job = JobDescription{ .sceneName{ *sceneName },
+                                         .sceneFingerprint{ 0 },
+                                         .settings{ settings },
+                                         .priority{ options->priority } };
+        auto result = client.render(job, scene, report);
+        if (!result) {
+            return EXIT_FAILURE;
+        }
+        frameBuffer = std::move(*result);
+    } else if (options->coordinatorPort) {
+        // checkpoints are not supported when rendering distributed, lost tiles are rendered again by other workers
+        auto result = renderDistributed(scene, settings, *options, tileSize, numThreads, report);
+        if (!result) {
+            return EXIT_FAILURE;
+        }
+        frameBuffer = std::move(*result);
+    } else {
+        checkpoint = openOrCreateCheckpoint(*options, frameBuffer, settings.samplesPerPixel,
+                                            renderFingerprint(settings, scene, geometryCache.get()));
+        if (!checkpoint) {
+            return EXIT_FAILURE;
+        }
+        std::vector<World> worlds;
+        const auto threads = createRenderThreads(scene, *options, numThreads, worlds);
+        if (worlds.front().bvh && worlds.front().bvh->statistics().numNodes > 0) {
+            const auto& bvhStatistics = worlds.front().bvh->statistics();
+            std::cout << std::format("BVH: {} nodes, {} leaves, {} references to {} objects, {} spatial splits\n",
+                                     bvhStatistics.numNodes, bvhStatistics.numLeaves, bvhStatistics.numReferences,
+                                     worlds.front().objects.size(), bvhStatistics.numSpatialSplits);
+        }
+        if (geometryCache) {
+            for (auto& world : worlds) {
+                ChunkedGeometry::addToWorld(world, geometryCache);
+            }
+        }
+        if (options->numaPlacement != NumaPlacement::None && !options->resume) {
+            releaseForFirstTouch(frameBuffer);
+        }
+        const auto samplerPrototype = createSampler(settings.samplerType);
+        // the previews only differ in resolution and sample count, so they can use the same kernel
+        const auto kernel = selectRenderKernel(settings, worlds.front());
+        std::cout << std::format("Render kernel: {}\n", kernel.description);
+        if (options->previewFactor > 0) {
+            // the previews are not denoised and only cover the crop window
+            auto previewSettings = settings;
+            previewSettings.cropWindow = cropWindow;
+            renderPreviews(threads, kernel.renderTile, previewSettings, *samplerPrototype, options->previewFactor,
+                           tileSize);
+        }
+        report = renderPasses(threads, kernel.renderTile, settings, *samplerPrototype, frameBuffer, *checkpoint,
+                              *options, samplesPerPass, tileSize);
     }
     const auto endTime = std::chrono::high_resolution_clock::now();
     const auto duration = std::chrono::duration<double>(endTime - startTime).count();
     std::cerr << std::format("Elapsed time: {} s\n", duration);
-    stbi_flip_vertically_on_write(true);
-    const auto result = stbi_write_png("raytracer.png", imageWidth, imageHeight, 4, imageBuffer.data(), 4 * imageWidth);
-    assert(result);
+    // after resuming, the statistics only cover the samples that have been rendered by this process
+    std::cerr << report.statistics.summary(duration);
+    if (geometryCache) {
+        const auto geometryStatistics = geometryCache->statistics();
+        std::cerr << std::format("Geometry chunks: {} loads, {} evictions, {} failures, {:.1f} MiB peak\n",
+                                 geometryStatistics.loads, geometryStatistics.evictions, geometryStatistics.failures,
+                                 static_cast<double>(geometryStatistics.peakResidentBytes) / (1024.0 * 1024.0));
+    }
+    // the render window includes the margin of the denoiser, the heatmap has to line up with the cropped image
+    if (!writeHeatmap("raytracer_heatmap.png", cropWindow, report.tileTimes)) {
+        return EXIT_FAILURE;
+    }
+
+    auto resolvedFrameBuffer = frameBuffer.resolved();
+    if (options->denoise) {
+        const auto denoiseStartTime = std::chrono::high_resolution_clock::now();
+        resolvedFrameBuffer.color = Denoiser::denoise(resolvedFrameBuffer, denoiserSettings, numThreads);
+        const auto denoiseDuration =
+                std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - denoiseStartTime).count();
+        std::cerr << std::format("Denoising time: {} s\n", denoiseDuration);
+    }
+    const auto outputFrameBuffer =
+            resolvedFrameBuffer.region(cropWindow.startX - renderWindow.startX, cropWindow.startY - renderWindow.startY,
+                                       cropWindow.width(), cropWindow.height());
+    auto finalColors = outputFrameBuffer.color;
+    std::transform(finalColors.cbegin(), finalColors.cend(), finalColors.begin(), gammaCorrection);
+    // the checkpoint is kept if the images cannot be written, so that the render is not lost
+    if (!writeImage("raytracer.png", outputFrameBuffer.width, outputFrameBuffer.height, finalColors) ||
+        !writeAovImages(outputFrameBuffer)) {
+        return EXIT_FAILURE;
+    }
+    if (checkpoint) {
+        // the render is complete, the checkpoint is not needed anymore
+        checkpoint.reset();
+        std::filesystem::remove(options->checkpointPath);
+    }
+
+    if (options->goldenImagePath && !matchesGoldenImage("raytracer.png", *options->goldenImagePath)) {
+        return EXIT_FAILURE;
+    }
 }
@@ -0,0 +1,16 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+#define NET_USE_CPP
+#define NET_IMPLEMENTATION
+// the include directory is a SYSTEM one, but GCC still reports this warning of the inlined implementation
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include "net.h"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
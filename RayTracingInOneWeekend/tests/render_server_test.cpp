@@ -0,0 +1,80 @@
+//
+// Created by coder2k on 19.10.2026.
+//
+
+// Two clients send different scenes under the same name to one render server. Each of them has to get the image of
+// its own scene back, not the one of the scene that the server has cached under that name.
+
+#include "RenderServer.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+    constexpr std::uint16_t port = 47391;
+
+    [[nodiscard]] std::optional<FrameBuffer> renderOnServer(const std::string& sceneName, const Scene& scene) {
+        RenderClient client;
+        if (!client.connect("127.0.0.1", std::to_string(port))) {
+            return {};
+        }
+        constexpr auto width = 48;
+        constexpr auto height = 32;
+        const auto settings = RenderSettings{ .imageWidth{ width },
+                                              .imageHeight{ height },
+                                              .samplesPerPixel{ 2 },
+                                              .maxDepth{ 50 },
+                                              .samplerType{ SamplerType::Sobol },
+                                              .camera{},
+                                              .cropWindow{ Tile::wholeImage(width, height) } };
+        const auto job = JobDescription{ .sceneName{ *RenderServerDetail::toSceneName(sceneName) },
+                                         .sceneFingerprint{ 0 },
+                                         .settings{ settings },
+                                         .priority{ 0 } };
+        RenderReport report;
+        return client.render(job, scene, report);
+    }
+
+    [[nodiscard]] bool check(const bool condition, const char* const description) {
+        if (!condition) {
+            std::cerr << std::format("FAILED: {}\n", description);
+        }
+        return condition;
+    }
+
+    [[nodiscard]] int runTest() {
+        const auto firstScene = Scene::createDemoScene();
+        auto secondScene = firstScene;
+        // the ground and the three large spheres
+        secondScene.spheres.resize(4);
+
+        const auto first = renderOnServer("shared", firstScene);
+        const auto second = renderOnServer("shared", secondScene);
+        const auto secondReference = renderOnServer("second", secondScene);
+        const auto firstAgain = renderOnServer("shared", firstScene);
+        if (!check(first && second && secondReference && firstAgain, "all jobs are rendered")) {
+            return EXIT_FAILURE;
+        }
+        auto success = check(first->color != second->color, "the scenes give different images");
+        success = check(second->color == secondReference->color, "the second client gets its own scene") && success;
+        success = check(firstAgain->color == first->color, "the first client gets its scene back") && success;
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}// namespace
+
+int main() {
+    RenderServer server{ port };
+    if (!server.isListening()) {
+        std::cerr << std::format("Unable to listen on port {}\n", port);
+        return EXIT_FAILURE;
+    }
+    // the server never returns from run(), so the process ends without destroying it
+    std::thread{ [&server]() { server.run(2); } }.detach();
+    const auto result = runTest();
+    std::cout << std::flush;
+    std::_Exit(result);
+}